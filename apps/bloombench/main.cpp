@@ -0,0 +1,145 @@
+#include "common/rprpp_wrappers/Buffer.h"
+#include "common/rprpp_wrappers/Context.h"
+#include "common/rprpp_wrappers/filters/BloomFilter.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// measures BloomFilter on a synthetic hdr image, without renderer and without stalls between the timed runs.
+// every configuration is run once untimed, it compiles shaders and allocates intermediates,
+// then ITERATIONS runs are submitted back to back and only the last one is waited for.
+// the last sweep runs the same kernels with the direct and the fft convolution and prints
+// the fft crossover radius for rprppBloomFilterSetFftCrossoverRadius.
+
+#define WIDTH 3840
+#define HEIGHT 2160
+#define DEVICE_ID 0
+#define ITERATIONS 50
+#define FRAMES_IN_FLIGHT 3
+
+struct BenchConfig {
+    std::string name;
+    RprPpBloomMode mode;
+    unsigned int downscale;
+    float radius;
+};
+
+void fillInput(rprpp::wrappers::Context& context, rprpp::wrappers::Buffer& buffer, rprpp::wrappers::Image& input);
+void configure(rprpp::wrappers::filters::BloomFilter& bloomFilter, rprpp::wrappers::Image& input, rprpp::wrappers::Image& output, const BenchConfig& config);
+unsigned int kernelRadius(float radius);
+double measure(rprpp::wrappers::Context& context, rprpp::wrappers::filters::BloomFilter& bloomFilter);
+
+int main()
+{
+    std::cout << "BloomBench started..." << std::endl;
+    try {
+        RprPpImageFormat format = RPRPP_IMAGE_FROMAT_R32G32B32A32_SFLOAT;
+        rprpp::wrappers::Context context(DEVICE_ID);
+        context.setFramesInFlight(FRAMES_IN_FLIGHT);
+        rprpp::wrappers::Buffer buffer(context, WIDTH * HEIGHT * rprpp::wrappers::to_pixel_size(format));
+
+        RprPpImageDescription desc = {
+            .width = WIDTH,
+            .height = HEIGHT,
+            .format = format,
+        };
+        rprpp::wrappers::Image input = rprpp::wrappers::Image::create(context, desc);
+        rprpp::wrappers::Image output = rprpp::wrappers::Image::create(context, desc);
+        fillInput(context, buffer, input);
+
+        std::vector<BenchConfig> configs;
+        for (float radius : { 0.005f, 0.01f, 0.02f, 0.05f, 0.1f, 0.2f }) {
+            configs.push_back({ "convolution", RPRPP_BLOOM_MODE_CONVOLUTION, 1, radius });
+            configs.push_back({ "convolution downscale 4", RPRPP_BLOOM_MODE_CONVOLUTION, 4, radius });
+            configs.push_back({ "pyramid", RPRPP_BLOOM_MODE_PYRAMID, 1, radius });
+        }
+
+        for (const BenchConfig& config : configs) {
+            rprpp::wrappers::filters::BloomFilter bloomFilter(context);
+            configure(bloomFilter, input, output, config);
+            std::cout << config.name << ", radius = " << config.radius << ": " << measure(context, bloomFilter) << " ms" << std::endl;
+        }
+
+        // fft is used for kernels larger than the crossover, so 0 forces it and UINT_MAX disables it
+        unsigned int fftFasterRadius = 0;
+        for (float radius : { 0.002f, 0.005f, 0.01f, 0.02f, 0.03f, 0.05f, 0.08f }) {
+            rprpp::wrappers::filters::BloomFilter bloomFilter(context);
+            configure(bloomFilter, input, output, { "convolution", RPRPP_BLOOM_MODE_CONVOLUTION, 1, radius });
+            bloomFilter.setFftCrossoverRadius(UINT_MAX);
+            double directTime = measure(context, bloomFilter);
+            bloomFilter.setFftCrossoverRadius(0);
+            double fftTime = measure(context, bloomFilter);
+
+            std::cout << "kernel radius = " << kernelRadius(radius) << ": direct " << directTime << " ms, fft " << fftTime << " ms" << std::endl;
+            if (fftFasterRadius == 0 && fftTime < directTime) {
+                fftFasterRadius = kernelRadius(radius);
+            }
+        }
+
+        if (fftFasterRadius > 0) {
+            std::cout << "fft crossover radius: " << fftFasterRadius - 1 << std::endl;
+        } else {
+            std::cout << "fft is slower for every measured radius" << std::endl;
+        }
+    } catch (const std::runtime_error& e) {
+        printf("%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    std::cout << "BloomBench finished..." << std::endl;
+    return 0;
+}
+
+void fillInput(rprpp::wrappers::Context& context, rprpp::wrappers::Buffer& buffer, rprpp::wrappers::Image& input)
+{
+    // smooth gradients with bright spots, luminance covers [0, 2]
+    float* pixels = static_cast<float*>(buffer.map(buffer.size()));
+    for (uint32_t y = 0; y < HEIGHT; y++) {
+        for (uint32_t x = 0; x < WIDTH; x++) {
+            float value = 1.0f + sinf(x * 0.01f) * cosf(y * 0.013f);
+            float* pixel = pixels + (size_t(y) * WIDTH + x) * 4;
+            pixel[0] = value;
+            pixel[1] = value * 0.8f;
+            pixel[2] = value * 0.6f;
+            pixel[3] = 1.0f;
+        }
+    }
+    buffer.unmap();
+    context.copyBufferToImage(buffer.get(), input.get());
+}
+
+void configure(rprpp::wrappers::filters::BloomFilter& bloomFilter, rprpp::wrappers::Image& input, rprpp::wrappers::Image& output, const BenchConfig& config)
+{
+    bloomFilter.setInput(input);
+    bloomFilter.setOutput(output);
+    bloomFilter.setMode(config.mode);
+    bloomFilter.setDownscale(config.downscale);
+    bloomFilter.setRadius(config.radius);
+    // half of the synthetic image is below the threshold
+    bloomFilter.setThreshold(0.5f);
+    bloomFilter.setIntensity(0.2f);
+}
+
+// the same kernel radius as BloomFilter computes for the full resolution image
+unsigned int kernelRadius(float radius)
+{
+    int sigma = static_cast<int>(sqrtf(WIDTH * WIDTH + HEIGHT * HEIGHT) * radius);
+    return static_cast<unsigned int>(std::max(1, static_cast<int>(4.0f * sigma + 0.5f)));
+}
+
+double measure(rprpp::wrappers::Context& context, rprpp::wrappers::filters::BloomFilter& bloomFilter)
+{
+    context.waitTimelineValue(bloomFilter.runTimeline());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t value = 0;
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        value = bloomFilter.runTimeline();
+    }
+    context.waitTimelineValue(value);
+    std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - start;
+    return time.count() / ITERATIONS;
+}
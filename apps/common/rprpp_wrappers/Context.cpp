@@ -1,4 +1,5 @@
 #include "Context.h"
+#include <cassert>
 
 namespace rprpp::wrappers {
 
@@ -48,6 +49,26 @@ RprPpVkQueue Context::getVkQueue() const noexcept
     return vkhandle;
 }
 
+RprPpVkQueue Context::getVkTransferQueue() const noexcept
+{
+    RprPpError status;
+    RprPpVkQueue vkhandle = nullptr;
+
+    status = rprppContextGetVkTransferQueue(m_context, &vkhandle);
+    RPRPP_CHECK(status);
+    return vkhandle;
+}
+
+RprPpVkQueue Context::getVkAsyncComputeQueue() const noexcept
+{
+    RprPpError status;
+    RprPpVkQueue vkhandle = nullptr;
+
+    status = rprppContextGetVkAsyncComputeQueue(m_context, &vkhandle);
+    RPRPP_CHECK(status);
+    return vkhandle;
+}
+
 void Context::waitQueueIdle()
 {
     RprPpError status;
@@ -56,6 +77,98 @@ void Context::waitQueueIdle()
     RPRPP_CHECK(status);
 }
 
+void Context::setFramesInFlight(unsigned int framesInFlight)
+{
+    RprPpError status;
+
+    status = rprppContextSetFramesInFlight(m_context, framesInFlight);
+    RPRPP_CHECK(status);
+}
+
+RprPpVkSemaphore Context::getTimelineSemaphore() const
+{
+    RprPpError status;
+    RprPpVkSemaphore timelineSemaphore;
+
+    status = rprppContextGetTimelineSemaphore(m_context, &timelineSemaphore);
+    RPRPP_CHECK(status);
+
+    return timelineSemaphore;
+}
+
+RprPpMemoryStatistics Context::getMemoryStatistics() const
+{
+    RprPpError status;
+    RprPpMemoryStatistics statistics;
+
+    status = rprppContextGetMemoryStatistics(m_context, &statistics);
+    RPRPP_CHECK(status);
+
+    return statistics;
+}
+
+void Context::setImagePoolCapacity(size_t capacity)
+{
+    RprPpError status;
+
+    status = rprppContextSetImagePoolCapacity(m_context, capacity);
+    RPRPP_CHECK(status);
+}
+
+void Context::savePipelineCache(const std::string& path)
+{
+    RprPpError status;
+
+    status = rprppContextSavePipelineCache(m_context, path.c_str());
+    RPRPP_CHECK(status);
+}
+
+void Context::loadPipelineCache(const std::string& path)
+{
+    RprPpError status;
+
+    status = rprppContextLoadPipelineCache(m_context, path.c_str());
+    RPRPP_CHECK(status);
+}
+
+void Context::prewarm(const std::vector<RprPpImageFormat>& formats, RprPpFilterTypeFlags filterTypes)
+{
+    RprPpError status;
+
+    status = rprppContextPrewarm(m_context, formats.data(), static_cast<unsigned int>(formats.size()), filterTypes);
+    RPRPP_CHECK(status);
+}
+
+bool Context::prewarmFinished()
+{
+    RprPpError status;
+    RprPpBool finished;
+
+    status = rprppContextGetPrewarmFinished(m_context, &finished);
+    RPRPP_CHECK(status);
+
+    return finished == RPRPP_TRUE;
+}
+
+void Context::waitPrewarm()
+{
+    RprPpError status;
+
+    status = rprppContextWaitPrewarm(m_context);
+    RPRPP_CHECK(status);
+}
+
+bool Context::waitTimelineValue(uint64_t value, uint64_t timeout)
+{
+    RprPpError status;
+    RprPpBool completed;
+
+    status = rprppContextWaitTimelineValue(m_context, value, timeout, &completed);
+    RPRPP_CHECK(status);
+
+    return completed == RPRPP_TRUE;
+}
+
 RprPpContext Context::get() const noexcept
 {
     return m_context;
@@ -85,4 +198,56 @@ void Context::copyImage(RprPpImage src, RprPpImage dst)
     RPRPP_CHECK(status);
 }
 
+TimelinePoint Context::copyBufferToImageAsync(RprPpBuffer buffer, RprPpImage image, const std::vector<RprPpVkSemaphore>& waitSemaphores, const std::vector<uint64_t>& waitValues)
+{
+    assert(waitSemaphores.size() == waitValues.size());
+
+    RprPpError status;
+    TimelinePoint finished;
+
+    status = rprppContextCopyBufferToImageAsync(m_context, buffer, image, waitSemaphores.data(), waitValues.data(), static_cast<unsigned int>(waitSemaphores.size()), &finished.semaphore, &finished.value);
+    RPRPP_CHECK(status);
+
+    return finished;
+}
+
+TimelinePoint Context::copyImageToBufferAsync(RprPpImage image, RprPpBuffer buffer, const std::vector<RprPpVkSemaphore>& waitSemaphores, const std::vector<uint64_t>& waitValues)
+{
+    assert(waitSemaphores.size() == waitValues.size());
+
+    RprPpError status;
+    TimelinePoint finished;
+
+    status = rprppContextCopyImageToBufferAsync(m_context, image, buffer, waitSemaphores.data(), waitValues.data(), static_cast<unsigned int>(waitSemaphores.size()), &finished.semaphore, &finished.value);
+    RPRPP_CHECK(status);
+
+    return finished;
+}
+
+TimelinePoint Context::uploadImages(const std::vector<RprPpImageUpload>& uploads, const std::vector<RprPpVkSemaphore>& waitSemaphores, const std::vector<uint64_t>& waitValues)
+{
+    assert(waitSemaphores.size() == waitValues.size());
+
+    RprPpError status;
+    TimelinePoint finished;
+
+    status = rprppContextUploadImages(m_context, uploads.data(), static_cast<unsigned int>(uploads.size()), waitSemaphores.data(), waitValues.data(), static_cast<unsigned int>(waitSemaphores.size()), &finished.semaphore, &finished.value);
+    RPRPP_CHECK(status);
+
+    return finished;
+}
+
+TimelinePoint Context::copyImageAsync(RprPpImage src, RprPpImage dst, const std::vector<RprPpVkSemaphore>& waitSemaphores, const std::vector<uint64_t>& waitValues)
+{
+    assert(waitSemaphores.size() == waitValues.size());
+
+    RprPpError status;
+    TimelinePoint finished;
+
+    status = rprppContextCopyImageAsync(m_context, src, dst, waitSemaphores.data(), waitValues.data(), static_cast<unsigned int>(waitSemaphores.size()), &finished.semaphore, &finished.value);
+    RPRPP_CHECK(status);
+
+    return finished;
+}
+
 }
\ No newline at end of file
@@ -4,9 +4,16 @@
 #include "rprpp/rprpp.h"
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 namespace rprpp::wrappers {
 
+struct TimelinePoint {
+    RprPpVkSemaphore semaphore;
+    uint64_t value;
+};
+
 class Context {
 public:
     explicit Context(uint32_t deviceId);
@@ -21,7 +28,31 @@ public:
     [[nodiscard]]
     RprPpVkQueue getVkQueue() const noexcept;
 
+    [[nodiscard]]
+    RprPpVkQueue getVkTransferQueue() const noexcept;
+
+    [[nodiscard]]
+    RprPpVkQueue getVkAsyncComputeQueue() const noexcept;
+
     void waitQueueIdle();
+    void setFramesInFlight(unsigned int framesInFlight);
+
+    [[nodiscard]]
+    RprPpVkSemaphore getTimelineSemaphore() const;
+
+    // returns false if timeout (in nanoseconds) expired before value was signaled
+    bool waitTimelineValue(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+    [[nodiscard]]
+    RprPpMemoryStatistics getMemoryStatistics() const;
+
+    void setImagePoolCapacity(size_t capacity);
+
+    void savePipelineCache(const std::string& path);
+    void loadPipelineCache(const std::string& path);
+    void prewarm(const std::vector<RprPpImageFormat>& formats, RprPpFilterTypeFlags filterTypes);
+    bool prewarmFinished();
+    void waitPrewarm();
 
     [[nodiscard]]
     RprPpContext get() const noexcept;
@@ -29,6 +60,10 @@ public:
     void copyBufferToImage(RprPpBuffer buffer, RprPpImage image);
     void copyImageToBuffer(RprPpImage image, RprPpBuffer buffer);
     void copyImage(RprPpImage src, RprPpImage dst);
+    TimelinePoint copyBufferToImageAsync(RprPpBuffer buffer, RprPpImage image, const std::vector<RprPpVkSemaphore>& waitSemaphores = {}, const std::vector<uint64_t>& waitValues = {});
+    TimelinePoint copyImageToBufferAsync(RprPpImage image, RprPpBuffer buffer, const std::vector<RprPpVkSemaphore>& waitSemaphores = {}, const std::vector<uint64_t>& waitValues = {});
+    TimelinePoint uploadImages(const std::vector<RprPpImageUpload>& uploads, const std::vector<RprPpVkSemaphore>& waitSemaphores = {}, const std::vector<uint64_t>& waitValues = {});
+    TimelinePoint copyImageAsync(RprPpImage src, RprPpImage dst, const std::vector<RprPpVkSemaphore>& waitSemaphores = {}, const std::vector<uint64_t>& waitValues = {});
 
     Context(const Context&) = delete;
     Context& operator=(const Context&) = delete;
@@ -0,0 +1,76 @@
+#include "Pipeline.h"
+#include <cassert>
+
+namespace rprpp::wrappers {
+
+Pipeline::Pipeline(const Context& context)
+    : m_context(context.get())
+{
+    RprPpError status;
+
+    status = rprppContextCreatePipeline(m_context, &m_pipeline);
+    RPRPP_CHECK(status);
+}
+
+Pipeline::~Pipeline()
+{
+    RprPpError status;
+
+    status = rprppContextDestroyPipeline(m_context, m_pipeline);
+    RPRPP_CHECK(status);
+}
+
+void Pipeline::addFilter(const filters::Filter& filter)
+{
+    RprPpError status;
+
+    status = rprppPipelineAddFilter(m_pipeline, filter.get());
+    RPRPP_CHECK(status);
+}
+
+void Pipeline::clear()
+{
+    RprPpError status;
+
+    status = rprppPipelineClear(m_pipeline);
+    RPRPP_CHECK(status);
+}
+
+void Pipeline::setFusion(bool fusion)
+{
+    RprPpError status;
+
+    status = rprppPipelineSetFusion(m_pipeline, fusion ? 1 : 0);
+    RPRPP_CHECK(status);
+}
+
+RprPpVkSemaphore Pipeline::run(RprPpVkSemaphore waitSemaphore)
+{
+    RprPpError status;
+    RprPpVkSemaphore finishedSemaphore;
+
+    status = rprppPipelineRun(m_pipeline, waitSemaphore, &finishedSemaphore);
+    RPRPP_CHECK(status);
+
+    return finishedSemaphore;
+}
+
+uint64_t Pipeline::runTimeline(const std::vector<RprPpVkSemaphore>& waitSemaphores, const std::vector<uint64_t>& waitValues, const std::vector<RprPpVkSemaphore>& signalSemaphores)
+{
+    assert(waitSemaphores.size() == waitValues.size());
+
+    RprPpError status;
+    uint64_t signaledValue;
+
+    status = rprppPipelineRunTimeline(m_pipeline, waitSemaphores.data(), waitValues.data(), static_cast<unsigned int>(waitSemaphores.size()), signalSemaphores.data(), static_cast<unsigned int>(signalSemaphores.size()), &signaledValue);
+    RPRPP_CHECK(status);
+
+    return signaledValue;
+}
+
+RprPpPipeline Pipeline::get() const noexcept
+{
+    return m_pipeline;
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Context.h"
+#include "filters/Filter.h"
+
+#include <vector>
+
+namespace rprpp::wrappers {
+
+class Pipeline {
+public:
+    explicit Pipeline(const Context& context);
+    ~Pipeline();
+
+    void addFilter(const filters::Filter& filter);
+    void clear();
+    void setFusion(bool fusion);
+    RprPpVkSemaphore run(RprPpVkSemaphore waitSemaphore = nullptr);
+    uint64_t runTimeline(const std::vector<RprPpVkSemaphore>& waitSemaphores = {}, const std::vector<uint64_t>& waitValues = {}, const std::vector<RprPpVkSemaphore>& signalSemaphores = {});
+    RprPpPipeline get() const noexcept;
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+private:
+    RprPpContext m_context;
+    RprPpPipeline m_pipeline;
+};
+
+}
@@ -38,4 +38,28 @@ void BloomFilter::setThreshold(float threshold)
     RPRPP_CHECK(status);
 }
 
+void BloomFilter::setMode(RprPpBloomMode mode)
+{
+    RprPpError status;
+
+    status = rprppBloomFilterSetMode(filter(), mode);
+    RPRPP_CHECK(status);
+}
+
+void BloomFilter::setDownscale(unsigned int downscale)
+{
+    RprPpError status;
+
+    status = rprppBloomFilterSetDownscale(filter(), downscale);
+    RPRPP_CHECK(status);
+}
+
+void BloomFilter::setFftCrossoverRadius(unsigned int radius)
+{
+    RprPpError status;
+
+    status = rprppBloomFilterSetFftCrossoverRadius(filter(), radius);
+    RPRPP_CHECK(status);
+}
+
 }
\ No newline at end of file
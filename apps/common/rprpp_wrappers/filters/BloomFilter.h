@@ -10,6 +10,9 @@ public:
     void setRadius(float radius);
     void setIntensity(float intensity);
     void setThreshold(float threshold);
+    void setMode(RprPpBloomMode mode);
+    void setDownscale(unsigned int downscale);
+    void setFftCrossoverRadius(unsigned int radius);
 };
 
 }
\ No newline at end of file
@@ -38,6 +38,21 @@ RprPpVkSemaphore Filter::run(RprPpVkSemaphore waitSemaphore)
     return finishedSemaphore;
 }
 
+uint64_t Filter::runTimeline(const std::vector<RprPpVkSemaphore>& waitSemaphores, const std::vector<uint64_t>& waitValues, const std::vector<RprPpVkSemaphore>& signalSemaphores)
+{
+    assert(m_context);
+    assert(m_filter);
+    assert(waitSemaphores.size() == waitValues.size());
+
+    RprPpError status;
+    uint64_t signaledValue;
+
+    status = rprppFilterRunTimeline(m_filter, waitSemaphores.data(), waitValues.data(), static_cast<unsigned int>(waitSemaphores.size()), signalSemaphores.data(), static_cast<unsigned int>(signalSemaphores.size()), &signaledValue);
+    RPRPP_CHECK(status);
+
+    return signaledValue;
+}
+
 void Filter::setInput(const Image& image)
 {
     RprPpError status;
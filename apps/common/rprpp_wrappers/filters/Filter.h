@@ -4,6 +4,8 @@
 #include "../Image.h"
 #include "../helper.h"
 
+#include <vector>
+
 namespace rprpp::wrappers::filters {
 
 class Filter {
@@ -11,6 +13,8 @@ public:
     virtual ~Filter();
 
     RprPpVkSemaphore run(RprPpVkSemaphore waitSemaphore = nullptr);
+    // returns the value of context timeline semaphore signaled once the filter is finished
+    uint64_t runTimeline(const std::vector<RprPpVkSemaphore>& waitSemaphores = {}, const std::vector<uint64_t>& waitValues = {}, const std::vector<RprPpVkSemaphore>& signalSemaphores = {});
     void setInput(const Image& image);
     void setOutput(const Image& image);
 
@@ -110,4 +110,63 @@ void ToneMapFilter::setAperture(float aperture)
     RPRPP_CHECK(status);
 }
 
+void ToneMapFilter::setMode(RprPpToneMapMode mode)
+{
+    RprPpError status;
+
+    status = rprppToneMapFilterSetMode(filter(), mode);
+    RPRPP_CHECK(status);
+}
+
+void ToneMapFilter::setCubeLut(const std::string& path)
+{
+    RprPpError status;
+
+    status = rprppToneMapFilterSetCubeLut(filter(), path.empty() ? nullptr : path.c_str());
+    RPRPP_CHECK(status);
+}
+
+void ToneMapFilter::setAutoExposure(bool autoExposure)
+{
+    RprPpError status;
+
+    status = rprppToneMapFilterSetAutoExposure(filter(), autoExposure ? 1 : 0);
+    RPRPP_CHECK(status);
+}
+
+void ToneMapFilter::setAutoExposurePercentile(float percentile)
+{
+    RprPpError status;
+
+    status = rprppToneMapFilterSetAutoExposurePercentile(filter(), percentile);
+    RPRPP_CHECK(status);
+}
+
+void ToneMapFilter::setAutoExposureAdaptation(float adaptation)
+{
+    RprPpError status;
+
+    status = rprppToneMapFilterSetAutoExposureAdaptation(filter(), adaptation);
+    RPRPP_CHECK(status);
+}
+
+void ToneMapFilter::setAutoExposureKey(float key)
+{
+    RprPpError status;
+
+    status = rprppToneMapFilterSetAutoExposureKey(filter(), key);
+    RPRPP_CHECK(status);
+}
+
+float ToneMapFilter::getExposure()
+{
+    RprPpError status;
+    float exposure;
+
+    status = rprppToneMapFilterGetExposure(filter(), &exposure);
+    RPRPP_CHECK(status);
+
+    return exposure;
+}
+
 }
\ No newline at end of file
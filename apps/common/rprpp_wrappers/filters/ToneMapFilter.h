@@ -2,6 +2,8 @@
 
 #include "Filter.h"
 
+#include <string>
+
 namespace rprpp::wrappers::filters {
 
 class ToneMapFilter : public Filter {
@@ -19,6 +21,14 @@ public:
     void setFNumber(float fNumber);
     void setFocalLength(float focalLength);
     void setAperture(float aperture);
+    void setMode(RprPpToneMapMode mode);
+    // empty path switches back to the baked LUT
+    void setCubeLut(const std::string& path);
+    void setAutoExposure(bool autoExposure);
+    void setAutoExposurePercentile(float percentile);
+    void setAutoExposureAdaptation(float adaptation);
+    void setAutoExposureKey(float key);
+    float getExposure();
 };
 
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "common/HybridProRenderer.h"
 #include "common/rprpp_wrappers/Buffer.h"
 #include "common/rprpp_wrappers/Context.h"
+#include "common/rprpp_wrappers/Pipeline.h"
 #include "common/rprpp_wrappers/filters/BloomFilter.h"
 #include "common/rprpp_wrappers/filters/ComposeColorShadowReflectionFilter.h"
 #include "common/rprpp_wrappers/filters/ComposeOpacityShadowFilter.h"
@@ -70,22 +71,20 @@ void runWithInterop(const std::filesystem::path& exeDirPath, int deviceId)
 
     RprPpImageFormat format = RPRPP_IMAGE_FROMAT_R32G32B32A32_SFLOAT;
     rprpp::wrappers::Context ppContext(deviceId);
+    ppContext.setFramesInFlight(FRAMES_IN_FLIGHT);
+    // pipelines are created while the renderer starts up
+    ppContext.prewarm({ format }, RPRPP_FILTER_TYPE_BLOOM | RPRPP_FILTER_TYPE_COMPOSE_COLOR_SHADOW_REFLECTION | RPRPP_FILTER_TYPE_TONEMAP);
     rprpp::wrappers::filters::BloomFilter bloomFilter(ppContext);
     rprpp::wrappers::filters::ComposeColorShadowReflectionFilter composeColorShadowReflectionFilter(ppContext);
     rprpp::wrappers::filters::DenoiserFilter denoiserFilter(ppContext);
     rprpp::wrappers::filters::ToneMapFilter tonemapFilter(ppContext);
     rprpp::wrappers::Buffer buffer(ppContext, WIDTH * HEIGHT * rprpp::wrappers::to_pixel_size(format));
 
-    std::vector<RprPpVkFence> fences;
     std::vector<RprPpVkSemaphore> frameBuffersReleaseSemaphores;
     for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++) {
         RprPpVkSemaphore semaphore;
         RPRPP_CHECK(rprppVkCreateSemaphore(ppContext.getVkDevice(), &semaphore));
         frameBuffersReleaseSemaphores.push_back(semaphore);
-
-        RprPpVkFence fence;
-        RPRPP_CHECK(rprppVkCreateFence(ppContext.getVkDevice(), RPRPP_TRUE, &fence));
-        fences.push_back(fence);
     }
 
     // set frame buffers realese to signal state
@@ -146,30 +145,27 @@ void runWithInterop(const std::filesystem::path& exeDirPath, int deviceId)
     tonemapFilter.setInput(output);
     tonemapFilter.setFocalLength(renderer.getFocalLength() / 1000.0f);
 
+    rprpp::wrappers::Pipeline pipeline(ppContext);
+    pipeline.addFilter(composeColorShadowReflectionFilter);
+    pipeline.addFilter(denoiserFilter);
+    pipeline.addFilter(bloomFilter);
+    pipeline.addFilter(tonemapFilter);
+
+    // timeline value signaled once the pipeline run of the frame has finished
+    std::vector<uint64_t> frameFinishedValues(FRAMES_IN_FLIGHT, 0);
     uint32_t currentFrame = 0;
     for (size_t i = 0; i < ITERATIONS; i++) {
         renderer.render();
         renderer.flushFrameBuffers();
 
-        RprPpVkFence fence = fences[currentFrame];
-        RPRPP_CHECK(rprppVkWaitForFences(ppContext.getVkDevice(), 1, &fence, true, UINT64_MAX));
-        RPRPP_CHECK(rprppVkResetFences(ppContext.getVkDevice(), 1, &fence));
+        ppContext.waitTimelineValue(frameFinishedValues[currentFrame]);
 
         uint32_t semaphoreIndex = renderer.getSemaphoreIndex();
         RprPpVkSemaphore aovsReadySemaphore = frameBuffersReadySemaphores[semaphoreIndex];
         RprPpVkSemaphore aovReleasedSemaphore = frameBuffersReleaseSemaphores[semaphoreIndex];
 
-        RprPpVkSemaphore filterFinished = composeColorShadowReflectionFilter.run(aovsReadySemaphore);
-        filterFinished = denoiserFilter.run(filterFinished);
-        filterFinished = bloomFilter.run(filterFinished);
-        filterFinished = tonemapFilter.run(filterFinished);
-
-        RprPpVkSubmitInfo submitInfo;
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = &filterFinished;
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &aovReleasedSemaphore;
-        RPRPP_CHECK(rprppVkQueueSubmit(ppContext.getVkQueue(), submitInfo, fence));
+        // the renderer reuses the aovs once the pipeline has finished reading them
+        frameFinishedValues[currentFrame] = pipeline.runTimeline({ aovsReadySemaphore }, { 0 }, { aovReleasedSemaphore });
         currentFrame = (currentFrame + 1) % FRAMES_IN_FLIGHT;
 
         if (i == 0 || i == ITERATIONS - 1) {
@@ -186,10 +182,6 @@ void runWithInterop(const std::filesystem::path& exeDirPath, int deviceId)
 
     ppContext.waitQueueIdle();
 
-    for (auto f : fences) {
-        RPRPP_CHECK(rprppVkDestroyFence(ppContext.getVkDevice(), f));
-    }
-
     for (auto s : frameBuffersReleaseSemaphores) {
         RPRPP_CHECK(rprppVkDestroySemaphore(ppContext.getVkDevice(), s));
     }
@@ -157,7 +157,8 @@ void NoAovsInteropApp::resize(int width, int height)
                 .height = (uint32_t)height,
                 .format = RPRPP_IMAGE_FROMAT_R32G32B32A32_SFLOAT,
             };
-            m_buffer = std::make_unique<rprpp::wrappers::Buffer>(*m_ppContext, width * height * 4 * sizeof(float));
+            // every aov is staged at its own offset and uploaded at once
+            m_buffer = std::make_unique<rprpp::wrappers::Buffer>(*m_ppContext, UploadedAovs.size() * width * height * 4 * sizeof(float));
             m_rgba32Output = std::make_unique<rprpp::wrappers::Image>(rprpp::wrappers::Image::create(*m_ppContext, rgba32Desc));
             m_aovColor = std::make_unique<rprpp::wrappers::Image>(rprpp::wrappers::Image::create(*m_ppContext, rgba32Desc));
             m_aovOpacity = std::make_unique<rprpp::wrappers::Image>(rprpp::wrappers::Image::create(*m_ppContext, rgba32Desc));
@@ -207,19 +208,37 @@ void NoAovsInteropApp::onResize(GLFWwindow* window, int width, int height)
     app->resize(width, height);
 }
 
-void NoAovsInteropApp::copyRprFbToPpStagingBuffer(rpr_aov aov)
+rprpp::wrappers::TimelinePoint NoAovsInteropApp::uploadAovs()
 {
-    size_t size;
-    m_hybridproRenderer.getAov(aov, nullptr, 0u, &size);
-    m_hybridproRenderer.getAov(aov, m_buffer->map(size), size, nullptr);
+    const std::array<rprpp::wrappers::Image*, UploadedAovs.size()> images = {
+        m_aovColor.get(),
+        m_aovOpacity.get(),
+        m_aovShadowCatcher.get(),
+        m_aovReflectionCatcher.get(),
+        m_aovMattePass.get(),
+        m_aovBackground.get(),
+        m_aovDiffuseAlbedo.get(),
+        m_aovCameraNormal.get(),
+    };
+
+    size_t aovSize = m_buffer->size() / UploadedAovs.size();
+    uint8_t* data = static_cast<uint8_t*>(m_buffer->map(m_buffer->size()));
+    std::vector<RprPpImageUpload> uploads;
+    for (size_t i = 0; i < UploadedAovs.size(); i++) {
+        size_t size;
+        m_hybridproRenderer.getAov(UploadedAovs[i], nullptr, 0u, &size);
+        m_hybridproRenderer.getAov(UploadedAovs[i], data + i * aovSize, size, nullptr);
+        uploads.push_back({ images[i]->get(), nullptr, m_buffer->get(), i * aovSize });
+    }
     m_buffer->unmap();
+
+    return m_ppContext->uploadImages(uploads);
 }
 
 void NoAovsInteropApp::mainLoop()
 {
     clock_t deltaTime = 0;
     unsigned int frames = 0;
-    RprPpVkSemaphore filterFinished = nullptr;
     while (!glfwWindowShouldClose(m_window)) {
         clock_t beginFrame = clock();
         {
@@ -227,29 +246,15 @@ void NoAovsInteropApp::mainLoop()
             for (unsigned int i = 0; i < m_renderedIterations; i++) {
                 m_hybridproRenderer.render();
             }
-            copyRprFbToPpStagingBuffer(RPR_AOV_COLOR);
-            m_ppContext->copyBufferToImage(m_buffer->get(), m_aovColor->get());
-            copyRprFbToPpStagingBuffer(RPR_AOV_OPACITY);
-            m_ppContext->copyBufferToImage(m_buffer->get(), m_aovOpacity->get());
-            copyRprFbToPpStagingBuffer(RPR_AOV_SHADOW_CATCHER);
-            m_ppContext->copyBufferToImage(m_buffer->get(), m_aovShadowCatcher->get());
-            copyRprFbToPpStagingBuffer(RPR_AOV_REFLECTION_CATCHER);
-            m_ppContext->copyBufferToImage(m_buffer->get(), m_aovReflectionCatcher->get());
-            copyRprFbToPpStagingBuffer(RPR_AOV_MATTE_PASS);
-            m_ppContext->copyBufferToImage(m_buffer->get(), m_aovMattePass->get());
-            copyRprFbToPpStagingBuffer(RPR_AOV_BACKGROUND);
-            m_ppContext->copyBufferToImage(m_buffer->get(), m_aovBackground->get());
-            copyRprFbToPpStagingBuffer(RPR_AOV_DIFFUSE_ALBEDO);
-            m_ppContext->copyBufferToImage(m_buffer->get(), m_aovDiffuseAlbedo->get());
-            copyRprFbToPpStagingBuffer(RPR_AOV_CAMERA_NORMAL);
-            m_ppContext->copyBufferToImage(m_buffer->get(), m_aovCameraNormal->get());
+            rprpp::wrappers::TimelinePoint aovsUploaded = uploadAovs();
 
-            filterFinished = m_composeOpacityShadowFilter->run(filterFinished);
-            filterFinished = m_composeColorShadowReflectionFilter->run(filterFinished);
-            filterFinished = m_denoiserFilter->run(filterFinished);
-            // filterFinished = m_bloomFilter->run(filterFinished);
-            filterFinished = m_tonemapFilter->run(filterFinished);
-            m_ppContext->waitQueueIdle();
+            RprPpVkSemaphore timeline = m_ppContext->getTimelineSemaphore();
+            uint64_t filterFinished = m_composeOpacityShadowFilter->runTimeline({ aovsUploaded.semaphore }, { aovsUploaded.value });
+            filterFinished = m_composeColorShadowReflectionFilter->runTimeline({ timeline }, { filterFinished });
+            filterFinished = m_denoiserFilter->runTimeline({ timeline }, { filterFinished });
+            // filterFinished = m_bloomFilter->runTimeline({ timeline }, { filterFinished });
+            filterFinished = m_tonemapFilter->runTimeline({ timeline }, { filterFinished });
+            m_ppContext->waitTimelineValue(filterFinished);
             m_ppContext->copyImage(m_output->get(), m_dx11output->get());
 
             IDXGIKeyedMutex* km;
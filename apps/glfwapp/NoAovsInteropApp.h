@@ -7,6 +7,8 @@
 #pragma comment(lib, "dxgi.lib")
 #include <wrl/client.h>
 
+#include <array>
+
 #include "dx_helper.h"
 
 #include "common/HybridProRenderer.h"
@@ -28,6 +30,17 @@ public:
     void run();
 
 private:
+    static constexpr std::array<rpr_aov, 8> UploadedAovs = {
+        RPR_AOV_COLOR,
+        RPR_AOV_OPACITY,
+        RPR_AOV_SHADOW_CATCHER,
+        RPR_AOV_REFLECTION_CATCHER,
+        RPR_AOV_MATTE_PASS,
+        RPR_AOV_BACKGROUND,
+        RPR_AOV_DIFFUSE_ALBEDO,
+        RPR_AOV_CAMERA_NORMAL,
+    };
+
     int m_width;
     int m_height;
     int m_renderedIterations;
@@ -65,7 +78,7 @@ private:
     void initWindow();
     void findAdapter();
     void intiSwapChain();
-    void copyRprFbToPpStagingBuffer(rpr_aov aov);
+    rprpp::wrappers::TimelinePoint uploadAovs();
     void resize(int width, int height);
     static void onResize(GLFWwindow* window, int width, int height);
     void mainLoop();
@@ -0,0 +1,86 @@
+# Shader variants compiled by glslc at build time and embedded into the library.
+#
+# add_shader_variant(<shader> <NAME=VALUE>...) registers one variant of shaders/<shader>.comp,
+# a macro without a value is passed as NAME=. The macros have to be exactly the ones the filter
+# passes to ShaderManager, otherwise the variant is never found and the shader is compiled at runtime.
+#
+# generate_precompiled_shaders(<target> <shaders dir> <output cpp>) adds a glslc command per variant
+# and writes the table of variants. Without glslc the table is empty.
+
+set_property(GLOBAL PROPERTY RPRPP_SHADER_VARIANTS "")
+
+function(add_shader_variant shader)
+    string(JOIN "," defines ${ARGN})
+    set_property(GLOBAL APPEND PROPERTY RPRPP_SHADER_VARIANTS "${shader}:${defines}")
+endfunction()
+
+function(generate_precompiled_shaders target shaders_dir output)
+    get_property(variants GLOBAL PROPERTY RPRPP_SHADER_VARIANTS)
+    set(spirv_dir ${CMAKE_CURRENT_BINARY_DIR}/spirv)
+    set(arrays "")
+    set(entries "")
+    set(count 0)
+
+    if(RPRPP_PRECOMPILE_SHADERS AND Vulkan_GLSLC_EXECUTABLE)
+        file(MAKE_DIRECTORY ${spirv_dir})
+        # snippets shared by the shaders, every variant is rebuilt when one of them changes
+        file(GLOB includes ${shaders_dir}/*.glsl)
+        foreach(variant ${variants})
+            string(REPLACE ":" ";" parts "${variant}")
+            list(GET parts 0 shader)
+            list(LENGTH parts parts_length)
+            set(defines "")
+            if(parts_length GREATER 1)
+                list(GET parts 1 defines)
+                string(REPLACE "," ";" defines "${defines}")
+            endif()
+
+            set(glslc_defines "")
+            foreach(define ${defines})
+                list(APPEND glslc_defines "-D${define}")
+            endforeach()
+
+            set(spirv ${spirv_dir}/${shader}_${count}.inc)
+            add_custom_command(
+                OUTPUT ${spirv}
+                COMMAND ${Vulkan_GLSLC_EXECUTABLE} -fshader-stage=compute -O -mfmt=num -I ${shaders_dir} ${glslc_defines} -o ${spirv} ${shaders_dir}/${shader}.comp
+                MAIN_DEPENDENCY ${shaders_dir}/${shader}.comp
+                DEPENDS ${includes}
+                COMMENT "Compiling ${shader} ${defines}"
+                VERBATIM
+            )
+            target_sources(${target} PRIVATE ${spirv})
+
+            # macros are joined by ';' in the table, ShaderManager splits them back
+            string(JOIN ";" macros ${defines})
+            string(APPEND arrays "static const uint32_t spirv${count}[] = {\n#include \"spirv/${shader}_${count}.inc\"\n};\n")
+            string(APPEND entries "    PrecompiledShader { \"${shader}\", \"${macros}\", spirv${count}, std::size(spirv${count}) },\n")
+            math(EXPR count "${count} + 1")
+        endforeach()
+        message(STATUS "rprpp: ${count} shader variants are precompiled")
+    elseif(RPRPP_PRECOMPILE_SHADERS)
+        message(WARNING "glslc is not found, all shaders are compiled at runtime")
+    endif()
+
+    file(CONFIGURE OUTPUT ${output} CONTENT
+"// generated by cmake/PrecompiledShaders.cmake
+#include \"rprpp/vk/PrecompiledShaders.h\"
+
+#include <array>
+#include <iterator>
+
+namespace vk::helper {
+
+@arrays@
+static const std::array<PrecompiledShader, @count@> shaders = {
+@entries@};
+
+std::span<const PrecompiledShader> precompiledShaders()
+{
+    return shaders;
+}
+
+}
+" @ONLY)
+    target_sources(${target} PRIVATE ${output})
+endfunction()
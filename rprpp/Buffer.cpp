@@ -4,18 +4,22 @@
 
 namespace rprpp {
 
-Buffer::Buffer(Context* parent, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, bool win32Exportable)
+Buffer::Buffer(Context* parent, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, bool win32Exportable, bool crossQueueFamilies)
     : ContextObject(parent)
     , m_size(size)
-    , m_buffer(createBuffer(context()->deviceContext(), size, usage, win32Exportable))
-    , m_memory(allocateMemory(context()->deviceContext(), properties, win32Exportable))
+    , m_buffer(createBuffer(context()->deviceContext(), size, usage, win32Exportable, crossQueueFamilies))
+    , m_memory(allocateMemory(properties, win32Exportable))
 {
-    m_buffer.bindMemory(*m_memory, 0);
+    m_buffer.bindMemory(m_memory.memory(), m_memory.offset());
 }
 
-vk::raii::Buffer Buffer::createBuffer(const vk::helper::DeviceContext& dctx, vk::DeviceSize size, vk::BufferUsageFlags usage, bool win32Exportable)
+vk::raii::Buffer Buffer::createBuffer(const vk::helper::DeviceContext& dctx, vk::DeviceSize size, vk::BufferUsageFlags usage, bool win32Exportable, bool crossQueueFamilies)
 {
     vk::BufferCreateInfo info({}, size, usage, vk::SharingMode::eExclusive);
+    if (crossQueueFamilies) {
+        info.setSharingMode(dctx.sharingMode());
+        info.setQueueFamilyIndices(dctx.queueFamilyIndices);
+    }
     vk::ExternalMemoryBufferCreateInfo externalInfo(vk::ExternalMemoryHandleTypeFlagBits::eOpaqueWin32);
     if (win32Exportable) {
         info.pNext = &externalInfo;
@@ -24,16 +28,17 @@ vk::raii::Buffer Buffer::createBuffer(const vk::helper::DeviceContext& dctx, vk:
     return vk::raii::Buffer(dctx.device, info);
 }
 
-vk::raii::DeviceMemory Buffer::allocateMemory(const vk::helper::DeviceContext& dctx, const vk::MemoryPropertyFlags& properties, bool win32Exportable)
+MemoryAllocation Buffer::allocateMemory(const vk::MemoryPropertyFlags& properties, bool win32Exportable)
 {
     vk::MemoryRequirements memRequirements = m_buffer.getMemoryRequirements();
-    uint32_t memoryType = vk::helper::findMemoryType(dctx.physicalDevice, memRequirements.memoryTypeBits, properties);
-    vk::MemoryAllocateInfo info(memRequirements.size, memoryType);
-    vk::ExportMemoryAllocateInfo exportInfo(vk::ExternalMemoryHandleTypeFlagBits::eOpaqueWin32);
-    if (win32Exportable) {
-        info.pNext = &exportInfo;
+    if (!win32Exportable) {
+        return context()->memoryAllocator().allocate(memRequirements, properties, true);
     }
-    return dctx.device.allocateMemory(info);
+
+    uint32_t memoryType = vk::helper::findMemoryType(context()->deviceContext().physicalDevice, memRequirements.memoryTypeBits, properties);
+    vk::ExportMemoryAllocateInfo exportInfo(vk::ExternalMemoryHandleTypeFlagBits::eOpaqueWin32);
+    vk::MemoryAllocateInfo info(memRequirements.size, memoryType, &exportInfo);
+    return context()->memoryAllocator().allocateDedicated(info);
 }
 
 vk::Buffer Buffer::get() const noexcept
@@ -43,7 +48,7 @@ vk::Buffer Buffer::get() const noexcept
 
 vk::DeviceMemory Buffer::memory() const noexcept
 {
-    return *m_memory;
+    return m_memory.memory();
 }
 
 void* Buffer::map(size_t size)
@@ -52,11 +57,10 @@ void* Buffer::map(size_t size)
         throw InvalidParameter("size", "the buffer is smaller than " + std::to_string(size));
     }
 
-    return m_memory.mapMemory(0, size, {});
+    return m_memory.map();
 }
 
 void Buffer::unmap()
 {
-    m_memory.unmapMemory();
 }
 }
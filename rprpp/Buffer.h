@@ -1,13 +1,15 @@
 #pragma once
 
 #include "ContextObject.h"
+#include "MemoryAllocator.h"
 #include "vk/DeviceContext.h"
 
 namespace rprpp {
 
 class Buffer : public ContextObject {
 public:
-    explicit Buffer(Context* parent, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, bool win32Exportable = false);
+    // crossQueueFamilies for buffers copied on the transfer queue, the others are used by the main queue only
+    explicit Buffer(Context* parent, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, bool win32Exportable = false, bool crossQueueFamilies = false);
 
     [[nodiscard]] size_t size() const noexcept { return m_size; }
 
@@ -15,17 +17,20 @@ public:
 
     [[nodiscard]] vk::DeviceMemory memory() const noexcept;
 
+    // the whole memory is mapped on the first call and stays mapped until the buffer is destroyed
     [[nodiscard]] void* map(size_t size);
 
+    // doesn't unmap the memory, kept so callers don't depend on the mapping being persistent
     void unmap();
 
 private:
-    vk::raii::Buffer createBuffer(const vk::helper::DeviceContext& dctx, vk::DeviceSize size, vk::BufferUsageFlags usage, bool win32Exportable = false);
-    vk::raii::DeviceMemory allocateMemory(const vk::helper::DeviceContext& dctx, const vk::MemoryPropertyFlags& properties, bool win32Exportable = false);
+    vk::raii::Buffer createBuffer(const vk::helper::DeviceContext& dctx, vk::DeviceSize size, vk::BufferUsageFlags usage, bool win32Exportable, bool crossQueueFamilies);
+    // exportable memory is allocated on its own, everything else is sub-allocated
+    MemoryAllocation allocateMemory(const vk::MemoryPropertyFlags& properties, bool win32Exportable = false);
 
     size_t m_size;
     vk::raii::Buffer m_buffer;
-    vk::raii::DeviceMemory m_memory;
+    MemoryAllocation m_memory;
 };
 
 }
\ No newline at end of file
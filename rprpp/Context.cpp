@@ -12,11 +12,60 @@
 
 #include <boost/log/trivial.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
 namespace rprpp {
 
+// layout, access and stages an image is returned to after a copy
+struct CopyImageState {
+    vk::AccessFlags access;
+    vk::ImageLayout layout;
+    vk::PipelineStageFlags stages;
+};
+
+// a transfer only queue can't wait for or hand over to the stages filters use the image in,
+// its submission is synchronized with the main queue by a semaphore and a fence instead
+static CopyImageState beginCopy(Image* image, bool computeQueue)
+{
+    CopyImageState state { image->access(), image->layout(), image->stages() };
+    if (!computeQueue) {
+        image->markSynchronized(vk::PipelineStageFlagBits::eTransfer);
+        state.access = {};
+        state.stages = vk::PipelineStageFlagBits::eTransfer;
+    }
+
+    return state;
+}
+
+static void endCopy(const vk::raii::CommandBuffer& commandBuffer, Image* image, const CopyImageState& state)
+{
+    image->transitionImageLayout(commandBuffer, state.access, state.layout, state.stages);
+}
+
+// enough for a resize to give back a few full screen images at 4k
+constexpr size_t DefaultImagePoolCapacity = 512 * 1024 * 1024;
+
+static vk::raii::Semaphore createTimelineSemaphore(const vk::helper::DeviceContext& dctx)
+{
+    vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> createInfo {
+        vk::SemaphoreCreateInfo(),
+        vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, 0)
+    };
+    return dctx.device.createSemaphore(createInfo.get<vk::SemaphoreCreateInfo>());
+}
+
 Context::Context(uint32_t deviceId, uint8_t luid[vk::LuidSize], uint8_t uuid[vk::UuidSize])
     : m_deviceContext(vk::helper::DeviceContext::create(deviceId))
+    , m_memoryAllocator(&m_deviceContext)
     , m_denoiserDevice(createOidnDevice(luid, uuid))
+    , m_timelineSemaphore(createTimelineSemaphore(m_deviceContext))
+    , m_copyTimelineSemaphore(createTimelineSemaphore(m_deviceContext))
+    , m_copySemaphore(m_deviceContext.device.createSemaphore({}))
+    , m_copyFence(m_deviceContext.device.createFence({}))
+    , m_imagePool(DefaultImagePoolCapacity)
 {
 }
 
@@ -57,12 +106,23 @@ void Context::destroyFilter(filters::Filter* filter)
     m_objects.erase(filter);
 }
 
+Pipeline* Context::createPipeline()
+{
+    return m_objects.emplaceCastReturn<Pipeline>(this);
+}
+
+void Context::destroyPipeline(Pipeline* pipeline)
+{
+    m_objects.erase(pipeline);
+}
+
 Buffer* Context::createBuffer(size_t size)
 {
     auto usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
     auto props = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
 
-    return m_objects.emplaceCastReturn<Buffer>(this, size, usage, props);
+    // copied on the transfer queue
+    return m_objects.emplaceCastReturn<Buffer>(this, size, usage, props, false, true);
 }
 
 void Context::destroyBuffer(Buffer* buffer)
@@ -72,6 +132,23 @@ void Context::destroyBuffer(Buffer* buffer)
 
 Image* Context::createImage(const ImageDescription& desc)
 {
+    std::vector<TimelinePoint> lastUse;
+    if (ContextObjectRef pooled = m_imagePool.take(desc, lastUse)) {
+        // filters and copies submitted before the image was destroyed might still use it
+        std::vector<vk::Semaphore> semaphores;
+        std::vector<uint64_t> values;
+        for (const TimelinePoint& point : lastUse) {
+            semaphores.push_back(point.semaphore);
+            values.push_back(point.value);
+        }
+        vk::Result result = m_deviceContext.device.waitSemaphores(vk::SemaphoreWaitInfo({}, semaphores, values), UINT64_MAX);
+        if (result != vk::Result::eSuccess) {
+            throw InternalError("pooled image is still in use");
+        }
+
+        return static_cast<ImageSimple*>(m_objects.insert(std::move(pooled)));
+    }
+
     return m_objects.emplaceCastReturn<ImageSimple>(this, desc);
 }
 
@@ -88,105 +165,299 @@ Image* Context::createImageFromDx11Texture(HANDLE dx11textureHandle, const Image
 
 void Context::destroyImage(Image* image)
 {
-    m_objects.erase(image);
+    // external images can't be handed out by createImage()
+    if (dynamic_cast<ImageSimple*>(image) == nullptr) {
+        m_objects.erase(image);
+        return;
+    }
+
+    // every submission that could use the image signals one of the timelines with a value reserved by now
+    m_imagePool.put(m_objects.extract(image), { { *m_timelineSemaphore, m_timelineValue }, { *m_copyTimelineSemaphore, m_copyTimelineValue } });
+}
+
+void Context::setImagePoolCapacity(size_t capacity)
+{
+    m_imagePool.setCapacity(capacity);
 }
 
 void Context::copyBufferToImage(Buffer* buffer, Image* image)
+{
+    uint32_t queueFamilyIndex = copyQueueFamilyIndex({ image });
+    vk::helper::CommandBuffer commandBuffer(&m_deviceContext, queueFamilyIndex);
+    recordCopyBufferToImage(commandBuffer.get(), buffer, image, queueFamilyIndex);
+    submitCopy(commandBuffer, queueFamilyIndex);
+}
+
+void Context::copyImageToBuffer(Image* image, Buffer* buffer)
+{
+    uint32_t queueFamilyIndex = copyQueueFamilyIndex({ image });
+    vk::helper::CommandBuffer commandBuffer(&m_deviceContext, queueFamilyIndex);
+    recordCopyImageToBuffer(commandBuffer.get(), image, buffer, queueFamilyIndex);
+    submitCopy(commandBuffer, queueFamilyIndex);
+}
+
+void Context::copyImage(Image* src, Image* dst)
+{
+    uint32_t queueFamilyIndex = copyQueueFamilyIndex({ src, dst });
+    vk::helper::CommandBuffer commandBuffer(&m_deviceContext, queueFamilyIndex);
+    recordCopyImage(commandBuffer.get(), src, dst, queueFamilyIndex);
+    submitCopy(commandBuffer, queueFamilyIndex);
+}
+
+TimelinePoint Context::copyBufferToImageAsync(Buffer* buffer, Image* image, const std::vector<TimelinePoint>& waits)
+{
+    uint32_t queueFamilyIndex = copyQueueFamilyIndex({ image });
+    std::unique_ptr<vk::helper::CommandBuffer> commandBuffer = takeAsyncCopyCommandBuffer(queueFamilyIndex);
+    recordCopyBufferToImage(commandBuffer->get(), buffer, image, queueFamilyIndex);
+    return submitCopyAsync(std::move(commandBuffer), queueFamilyIndex, waits);
+}
+
+TimelinePoint Context::copyImageToBufferAsync(Image* image, Buffer* buffer, const std::vector<TimelinePoint>& waits)
+{
+    uint32_t queueFamilyIndex = copyQueueFamilyIndex({ image });
+    std::unique_ptr<vk::helper::CommandBuffer> commandBuffer = takeAsyncCopyCommandBuffer(queueFamilyIndex);
+    recordCopyImageToBuffer(commandBuffer->get(), image, buffer, queueFamilyIndex);
+    return submitCopyAsync(std::move(commandBuffer), queueFamilyIndex, waits);
+}
+
+TimelinePoint Context::copyImageAsync(Image* src, Image* dst, const std::vector<TimelinePoint>& waits)
+{
+    uint32_t queueFamilyIndex = copyQueueFamilyIndex({ src, dst });
+    std::unique_ptr<vk::helper::CommandBuffer> commandBuffer = takeAsyncCopyCommandBuffer(queueFamilyIndex);
+    recordCopyImage(commandBuffer->get(), src, dst, queueFamilyIndex);
+    return submitCopyAsync(std::move(commandBuffer), queueFamilyIndex, waits);
+}
+
+void Context::recordCopyBufferToImage(const vk::raii::CommandBuffer& commandBuffer, Buffer* buffer, Image* image, uint32_t queueFamilyIndex)
 {
     size_t size = image->description().width * image->description().height * to_pixel_size(image->description().format);
     if (buffer->size() < size) {
         throw InvalidParameter("buffer", "The provided buffer doesn't fit destination image");
     }
 
-    vk::AccessFlags oldAccess = image->access();
-    vk::ImageLayout oldLayout = image->layout();
-    vk::PipelineStageFlags oldStage = image->stages();
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    recordBufferToImageCommands(commandBuffer, buffer->get(), 0, image, queueFamilyIndex);
+    commandBuffer.end();
+}
 
-    vk::helper::CommandBuffer commandBuffer(&m_deviceContext);
-    commandBuffer.get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
-    image->transitionImageLayout(commandBuffer.get(),
+void Context::recordBufferToImageCommands(const vk::raii::CommandBuffer& commandBuffer, vk::Buffer buffer, vk::DeviceSize offset, Image* image, uint32_t queueFamilyIndex)
+{
+    CopyImageState imageState = beginCopy(image, queueFamilyIndex == m_deviceContext.queueFamilyIndex);
+    image->transitionImageLayout(commandBuffer,
         vk::AccessFlagBits::eTransferWrite,
         vk::ImageLayout::eTransferDstOptimal,
         vk::PipelineStageFlagBits::eTransfer);
     {
         vk::ImageSubresourceLayers imageSubresource(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
-        vk::BufferImageCopy region(0, 0, 0, imageSubresource, { 0, 0, 0 }, { image->description().width, image->description().height, 1 });
-        commandBuffer.get().copyBufferToImage(buffer->get(), image->image(), vk::ImageLayout::eTransferDstOptimal, region);
+        vk::BufferImageCopy region(offset, 0, 0, imageSubresource, { 0, 0, 0 }, { image->description().width, image->description().height, 1 });
+        commandBuffer.copyBufferToImage(buffer, image->image(), vk::ImageLayout::eTransferDstOptimal, region);
     }
-    image->transitionImageLayout(commandBuffer.get(), oldAccess, oldLayout, oldStage);
-    commandBuffer.get().end();
+    endCopy(commandBuffer, image, imageState);
+}
 
-    vk::SubmitInfo submitInfo(nullptr, nullptr, *commandBuffer.get());
-    m_deviceContext.queue.submit(submitInfo);
-    m_deviceContext.queue.waitIdle();
+TimelinePoint Context::uploadImages(const std::vector<ImageUpload>& uploads, const std::vector<TimelinePoint>& waits)
+{
+    if (uploads.empty()) {
+        throw InvalidParameter("uploads", "cannot be empty");
+    }
+
+    // offsets of buffer to image copies have to be a multiple of the texel size and 4
+    constexpr vk::DeviceSize stagingAlignment = 16;
+    vk::DeviceSize stagingSize = 0;
+    std::vector<const Image*> images;
+    for (const ImageUpload& upload : uploads) {
+        if (upload.image == nullptr) {
+            throw InvalidParameter("image", "cannot be null");
+        }
+
+        if ((upload.data == nullptr) == (upload.buffer == nullptr)) {
+            throw InvalidParameter("data and buffer", "exactly one of them has to be set");
+        }
+
+        size_t size = upload.image->description().width * upload.image->description().height * to_pixel_size(upload.image->description().format);
+        if (upload.buffer != nullptr && upload.buffer->size() < upload.offset + size) {
+            throw InvalidParameter("buffer", "The provided buffer doesn't fit destination image");
+        }
+
+        if (upload.data != nullptr) {
+            stagingSize += (size + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+        }
+        images.push_back(upload.image);
+    }
+
+    StagingRing::Allocation staging {};
+    if (stagingSize > 0) {
+        staging = stagingRing().allocate(stagingSize, stagingAlignment);
+    }
+
+    uint32_t queueFamilyIndex = copyQueueFamilyIndex(images);
+    std::unique_ptr<vk::helper::CommandBuffer> commandBuffer;
+    try {
+        commandBuffer = takeAsyncCopyCommandBuffer(queueFamilyIndex);
+        commandBuffer->get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        vk::DeviceSize stagingOffset = 0;
+        for (const ImageUpload& upload : uploads) {
+            if (upload.buffer != nullptr) {
+                recordBufferToImageCommands(commandBuffer->get(), upload.buffer->get(), upload.offset, upload.image, queueFamilyIndex);
+                continue;
+            }
+
+            size_t size = upload.image->description().width * upload.image->description().height * to_pixel_size(upload.image->description().format);
+            std::memcpy(static_cast<uint8_t*>(staging.data) + stagingOffset, upload.data, size);
+            recordBufferToImageCommands(commandBuffer->get(), staging.buffer, staging.offset + stagingOffset, upload.image, queueFamilyIndex);
+            stagingOffset += (size + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+        }
+        commandBuffer->get().end();
+    } catch (...) {
+        // nothing is submitted, the slice would block the ring until someone else retires it
+        stagingRing().abandon();
+        throw;
+    }
+
+    vk::Fence stagingFence = stagingSize > 0 ? stagingRing().retire() : nullptr;
+    return submitCopyAsync(std::move(commandBuffer), queueFamilyIndex, waits, stagingFence);
 }
 
-void Context::copyImageToBuffer(Image* image, Buffer* buffer)
+TimelinePoint Context::submitStagingCopy(const std::function<void(const vk::raii::CommandBuffer&)>& record)
+{
+    std::unique_ptr<vk::helper::CommandBuffer> commandBuffer;
+    try {
+        commandBuffer = takeAsyncCopyCommandBuffer(m_deviceContext.queueFamilyIndex);
+        commandBuffer->get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        record(commandBuffer->get());
+        commandBuffer->get().end();
+    } catch (...) {
+        stagingRing().abandon();
+        throw;
+    }
+
+    return submitCopyAsync(std::move(commandBuffer), m_deviceContext.queueFamilyIndex, {}, stagingRing().retire());
+}
+
+void Context::recordCopyImageToBuffer(const vk::raii::CommandBuffer& commandBuffer, Image* image, Buffer* buffer, uint32_t queueFamilyIndex)
 {
     size_t size = image->description().width * image->description().height * to_pixel_size(image->description().format);
     if (buffer->size() < size) {
         throw InvalidParameter("buffer", "The provided buffer doesn't fit destination image");
     }
 
-    vk::AccessFlags oldAccess = image->access();
-    vk::ImageLayout oldLayout = image->layout();
-    vk::PipelineStageFlags oldStage = image->stages();
+    CopyImageState imageState = beginCopy(image, queueFamilyIndex == m_deviceContext.queueFamilyIndex);
 
-    vk::helper::CommandBuffer commandBuffer(&m_deviceContext);
-    commandBuffer.get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
-    image->transitionImageLayout(commandBuffer.get(),
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    image->transitionImageLayout(commandBuffer,
         vk::AccessFlagBits::eTransferRead,
         vk::ImageLayout::eTransferSrcOptimal,
         vk::PipelineStageFlagBits::eTransfer);
     {
         vk::ImageSubresourceLayers imageSubresource(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
         vk::BufferImageCopy region(0, 0, 0, imageSubresource, { 0, 0, 0 }, { image->description().width, image->description().height, 1 });
-        commandBuffer.get().copyImageToBuffer(image->image(), vk::ImageLayout::eTransferSrcOptimal, buffer->get(), region);
+        commandBuffer.copyImageToBuffer(image->image(), vk::ImageLayout::eTransferSrcOptimal, buffer->get(), region);
     }
-    image->transitionImageLayout(commandBuffer.get(), oldAccess, oldLayout, oldStage);
-    commandBuffer.get().end();
-
-    vk::SubmitInfo submitInfo(nullptr, nullptr, *commandBuffer.get());
-    m_deviceContext.queue.submit(submitInfo);
-    m_deviceContext.queue.waitIdle();
+    endCopy(commandBuffer, image, imageState);
+    commandBuffer.end();
 }
 
-void Context::copyImage(Image* src, Image* dst)
+void Context::recordCopyImage(const vk::raii::CommandBuffer& commandBuffer, Image* src, Image* dst, uint32_t queueFamilyIndex)
 {
     if (src->description() != dst->description()) {
         throw InvalidParameter("dst", "Destination image description has to be equal to source description");
     }
 
-    vk::AccessFlags oldDstAccess = dst->access();
-    vk::ImageLayout oldDstLayout = dst->layout();
-    vk::PipelineStageFlags oldDstStage = dst->stages();
-
-    vk::AccessFlags oldSrcAccess = src->access();
-    vk::ImageLayout oldSrcLayout = src->layout();
-    vk::PipelineStageFlags oldSrcStage = src->stages();
+    bool computeQueue = queueFamilyIndex == m_deviceContext.queueFamilyIndex;
+    CopyImageState dstState = beginCopy(dst, computeQueue);
+    CopyImageState srcState = beginCopy(src, computeQueue);
 
-    vk::helper::CommandBuffer commandBuffer(&m_deviceContext);
-    commandBuffer.get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
-    dst->transitionImageLayout(commandBuffer.get(),
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    dst->transitionImageLayout(commandBuffer,
         vk::AccessFlagBits::eTransferWrite,
         vk::ImageLayout::eTransferDstOptimal,
         vk::PipelineStageFlagBits::eTransfer);
-    src->transitionImageLayout(commandBuffer.get(),
+    src->transitionImageLayout(commandBuffer,
         vk::AccessFlagBits::eTransferRead,
         vk::ImageLayout::eTransferSrcOptimal,
         vk::PipelineStageFlagBits::eTransfer);
     {
         vk::ImageSubresourceLayers imageSubresource(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
         vk::ImageCopy region(imageSubresource, { 0, 0, 0 }, imageSubresource, { 0, 0, 0 }, { src->description().width, src->description().height, 1 });
-        commandBuffer.get().copyImage(src->image(), vk::ImageLayout::eTransferSrcOptimal, dst->image(), vk::ImageLayout::eTransferDstOptimal, region);
+        commandBuffer.copyImage(src->image(), vk::ImageLayout::eTransferSrcOptimal, dst->image(), vk::ImageLayout::eTransferDstOptimal, region);
     }
-    src->transitionImageLayout(commandBuffer.get(), oldSrcAccess, oldSrcLayout, oldSrcStage);
-    dst->transitionImageLayout(commandBuffer.get(), oldDstAccess, oldDstLayout, oldDstStage);
-    commandBuffer.get().end();
+    endCopy(commandBuffer, src, srcState);
+    endCopy(commandBuffer, dst, dstState);
+    commandBuffer.end();
+}
+
+uint32_t Context::copyQueueFamilyIndex(const std::vector<const Image*>& images) const
+{
+    if (m_deviceContext.transferQueueFamilyIndex == m_deviceContext.queueFamilyIndex) {
+        return m_deviceContext.queueFamilyIndex;
+    }
+
+    for (const Image* image : images) {
+        if (!image->IsConcurrent()) {
+            return m_deviceContext.queueFamilyIndex;
+        }
+    }
+
+    return m_deviceContext.transferQueueFamilyIndex;
+}
+
+const vk::raii::Queue& Context::copyQueue(uint32_t queueFamilyIndex) const noexcept
+{
+    return queueFamilyIndex == m_deviceContext.transferQueueFamilyIndex ? m_deviceContext.transferQueue : m_deviceContext.queue;
+}
+
+void Context::submitCopy(const vk::helper::CommandBuffer& commandBuffer, uint32_t queueFamilyIndex)
+{
+    const vk::raii::Queue& queue = copyQueue(queueFamilyIndex);
 
     vk::SubmitInfo submitInfo(nullptr, nullptr, *commandBuffer.get());
-    m_deviceContext.queue.submit(submitInfo);
-    m_deviceContext.queue.waitIdle();
+    // layout transitions of the copy have to wait for the semaphore too
+    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+    vk::Semaphore copySemaphore = *m_copySemaphore;
+    if (*queue != *m_deviceContext.queue) {
+        // the signal is ordered after everything already submitted to the main queue, e.g. filters still reading the image
+        m_deviceContext.submit(m_deviceContext.queue, vk::SubmitInfo(nullptr, nullptr, nullptr, copySemaphore));
+        submitInfo.setWaitSemaphores(copySemaphore);
+        submitInfo.setWaitDstStageMask(waitStage);
+    }
+
+    m_deviceContext.submit(queue, submitInfo, *m_copyFence);
+    vk::Result result = m_deviceContext.device.waitForFences(*m_copyFence, vk::True, UINT64_MAX);
+    m_deviceContext.device.resetFences(*m_copyFence);
+    if (result != vk::Result::eSuccess) {
+        throw InternalError("copy hasn't finished");
+    }
+}
+
+std::unique_ptr<vk::helper::CommandBuffer> Context::takeAsyncCopyCommandBuffer(uint32_t queueFamilyIndex)
+{
+    // command buffers of finished copies go back to the pool
+    uint64_t completedValue = completedTimelineValue();
+    uint64_t completedCopyValue = m_copyTimelineSemaphore.getCounterValue();
+    std::erase_if(m_pendingCopies, [&](const PendingCopy& copy) {
+        bool onMainQueue = copy.finished.semaphore == *m_timelineSemaphore;
+        return (onMainQueue ? completedValue : completedCopyValue) >= copy.finished.value;
+    });
+
+    return std::make_unique<vk::helper::CommandBuffer>(&m_deviceContext, queueFamilyIndex);
+}
+
+TimelinePoint Context::submitCopyAsync(std::unique_ptr<vk::helper::CommandBuffer> commandBuffer, uint32_t queueFamilyIndex, const std::vector<TimelinePoint>& waits, vk::Fence fence)
+{
+    const vk::raii::Queue& queue = copyQueue(queueFamilyIndex);
+
+    // a timeline semaphore has to be signaled in increasing order, so copies on another queue can't use the main one
+    TimelinePoint finished;
+    if (*queue == *m_deviceContext.queue) {
+        finished = { *m_timelineSemaphore, nextTimelineValue() };
+    } else {
+        finished = { *m_copyTimelineSemaphore, ++m_copyTimelineValue };
+    }
+
+    SubmitSync sync { waits, { finished }, fence };
+    sync.submit(m_deviceContext, queue, *commandBuffer->get(), vk::PipelineStageFlagBits::eAllCommands);
+    m_pendingCopies.push_back({ std::move(commandBuffer), finished });
+    return finished;
 }
 
 VkPhysicalDevice Context::getVkPhysicalDevice() const noexcept
@@ -204,9 +475,120 @@ VkQueue Context::getVkQueue() const noexcept
     return *m_deviceContext.queue;
 }
 
+VkQueue Context::getVkTransferQueue() const noexcept
+{
+    return *m_deviceContext.transferQueue;
+}
+
+VkQueue Context::getVkAsyncComputeQueue() const noexcept
+{
+    return *m_deviceContext.asyncComputeQueue;
+}
+
 void Context::waitQueueIdle()
 {
-    m_deviceContext.queue.waitIdle();
+    m_deviceContext.waitIdle(m_deviceContext.queue);
+}
+
+StagingRing& Context::stagingRing()
+{
+    // grows on the first allocation that doesn't fit
+    constexpr vk::DeviceSize initialCapacity = 64 * 1024 * 1024;
+    if (!m_stagingRing) {
+        m_stagingRing = std::make_unique<StagingRing>(this, initialCapacity);
+    }
+
+    return *m_stagingRing;
+}
+
+TransientHeap& Context::transientHeap()
+{
+    if (!m_transientHeap) {
+        m_transientHeap = std::make_unique<TransientHeap>(this);
+    }
+
+    return *m_transientHeap;
+}
+
+PipelineRegistry& Context::pipelineRegistry()
+{
+    if (!m_pipelineRegistry) {
+        m_pipelineRegistry = std::make_unique<PipelineRegistry>(this);
+    }
+
+    return *m_pipelineRegistry;
+}
+
+void Context::prewarm(const std::vector<ImageFormat>& formats, uint32_t filterTypes)
+{
+    std::vector<filters::PrewarmTask> tasks;
+    auto append = [&tasks](std::vector<filters::PrewarmTask>&& filterTasks) {
+        std::move(filterTasks.begin(), filterTasks.end(), std::back_inserter(tasks));
+    };
+
+    for (ImageFormat outputFormat : formats) {
+        if (filterTypes & RPRPP_FILTER_TYPE_BLOOM) {
+            append(filters::BloomFilter::prewarmTasks(this, outputFormat));
+        }
+
+        // inputs of the other filters can have any of the formats
+        for (ImageFormat inputFormat : formats) {
+            if (filterTypes & RPRPP_FILTER_TYPE_COMPOSE_COLOR_SHADOW_REFLECTION) {
+                append(filters::ComposeColorShadowReflectionFilter::prewarmTasks(this, outputFormat, inputFormat));
+            }
+            if (filterTypes & RPRPP_FILTER_TYPE_COMPOSE_OPACITY_SHADOW) {
+                append(filters::ComposeOpacityShadowFilter::prewarmTasks(this, outputFormat, inputFormat));
+            }
+            if (filterTypes & RPRPP_FILTER_TYPE_TONEMAP) {
+                append(filters::ToneMapFilter::prewarmTasks(this, outputFormat, inputFormat));
+            }
+        }
+    }
+
+    if (!m_prewarmer) {
+        // half of the cores are left to the application
+        m_prewarmer = std::make_unique<Prewarmer>(std::max(1u, std::thread::hardware_concurrency() / 2));
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "Context: prewarming " << tasks.size() << " pipelines";
+    m_prewarmer->submit(std::move(tasks));
+}
+
+bool Context::prewarmFinished() const
+{
+    return !m_prewarmer || m_prewarmer->finished();
+}
+
+void Context::waitPrewarm()
+{
+    if (m_prewarmer) {
+        m_prewarmer->wait();
+    }
+}
+
+void Context::setFramesInFlight(uint32_t framesInFlight)
+{
+    if (framesInFlight == 0) {
+        throw InvalidParameter("framesInFlight", "has to be at least 1");
+    }
+
+    m_framesInFlight = framesInFlight;
+}
+
+uint64_t Context::completedTimelineValue() const
+{
+    return m_timelineSemaphore.getCounterValue();
+}
+
+bool Context::waitTimelineValue(uint64_t value, uint64_t timeout)
+{
+    if (value > m_timelineValue) {
+        throw InvalidParameter("value", "has not been reserved by any submission yet");
+    }
+
+    vk::Semaphore semaphore = *m_timelineSemaphore;
+    vk::SemaphoreWaitInfo waitInfo({}, semaphore, value);
+    return m_deviceContext.device.waitSemaphores(waitInfo, timeout) == vk::Result::eSuccess;
 }
 
 }
\ No newline at end of file
@@ -4,6 +4,14 @@
 
 #include "Buffer.h"
 #include "Image.h"
+#include "ImagePool.h"
+#include "MemoryAllocator.h"
+#include "Pipeline.h"
+#include "PipelineRegistry.h"
+#include "Prewarmer.h"
+#include "StagingRing.h"
+#include "SubmitSync.h"
+#include "TransientHeap.h"
 #include "filters/BloomFilter.h"
 #include "filters/ComposeColorShadowReflectionFilter.h"
 #include "filters/ComposeOpacityShadowFilter.h"
@@ -11,15 +19,28 @@
 #include "filters/Filter.h"
 #include "filters/ToneMapFilter.h"
 #include "oidn_helper.h"
+#include "vk/CommandBuffer.h"
 #include "vk/DeviceContext.h"
 
 #include <boost/noncopyable.hpp>
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 template <class T>
 using map = std::unordered_map<T*, std::unique_ptr<T>>;
 
 namespace rprpp {
 
+// pixels of image come either from host memory at data or from buffer at offset
+struct ImageUpload {
+    Image* image = nullptr;
+    const void* data = nullptr;
+    Buffer* buffer = nullptr;
+    size_t offset = 0;
+};
+
 class Context : public boost::noncopyable {
 public:
     explicit Context(uint32_t deviceId, uint8_t luid[vk::LuidSize], uint8_t uuid[vk::UuidSize]);
@@ -33,8 +54,28 @@ public:
     [[nodiscard]]
     VkQueue getVkQueue() const noexcept;
 
+    [[nodiscard]]
+    VkQueue getVkTransferQueue() const noexcept;
+
+    [[nodiscard]]
+    VkQueue getVkAsyncComputeQueue() const noexcept;
+
     void waitQueueIdle();
 
+    // depth of per-frame resource rings of filters and pipelines created afterwards
+    void setFramesInFlight(uint32_t framesInFlight);
+    [[nodiscard]] uint32_t framesInFlight() const noexcept { return m_framesInFlight; }
+
+    // timeline semaphore signaled by every run() of filters and pipelines
+    [[nodiscard]] vk::Semaphore timelineSemaphore() const noexcept { return *m_timelineSemaphore; }
+    // reserves the value the next timeline submission signals
+    [[nodiscard]] uint64_t nextTimelineValue() noexcept { return ++m_timelineValue; }
+    // the last reserved value
+    [[nodiscard]] uint64_t timelineValue() const noexcept { return m_timelineValue; }
+    [[nodiscard]] uint64_t completedTimelineValue() const;
+    // returns false if timeout (in nanoseconds) expired before value was signaled
+    bool waitTimelineValue(uint64_t value, uint64_t timeout);
+
     [[nodiscard]]
     Buffer* createBuffer(size_t size);
 
@@ -48,13 +89,49 @@ public:
 
     void destroyFilter(filters::Filter* filter);
 
+    Pipeline* createPipeline();
+    void destroyPipeline(Pipeline* pipeline);
+
     Image* createImage(const ImageDescription& desc);
     Image* createFromVkSampledImage(vk::Image image, const ImageDescription& desc);
     Image* createImageFromDx11Texture(HANDLE dx11textureHandle, const ImageDescription& desc);
+    // images created by createImage() aren't destroyed, they are pooled and reused by the next createImage() with the same description
     void destroyImage(Image* image);
+    // least recently destroyed images are freed while the pool holds more than capacity bytes
+    void setImagePoolCapacity(size_t capacity);
+    [[nodiscard]] size_t imagePoolCapacity() const noexcept { return m_imagePool.capacity(); }
     void copyBufferToImage(Buffer* buffer, Image* image);
     void copyImageToBuffer(Image* image, Buffer* buffer);
     void copyImage(Image* src, Image* dst);
+    // don't wait for anything except waits, finished point has to be waited before the images or the buffer are used again
+    [[nodiscard]] TimelinePoint copyBufferToImageAsync(Buffer* buffer, Image* image, const std::vector<TimelinePoint>& waits);
+    [[nodiscard]] TimelinePoint copyImageToBufferAsync(Image* image, Buffer* buffer, const std::vector<TimelinePoint>& waits);
+    [[nodiscard]] TimelinePoint copyImageAsync(Image* src, Image* dst, const std::vector<TimelinePoint>& waits);
+    // host data is staged in a ring buffer, all the copies are recorded into one command buffer and submitted at once
+    [[nodiscard]] TimelinePoint uploadImages(const std::vector<ImageUpload>& uploads, const std::vector<TimelinePoint>& waits);
+
+    // shared by every transient host to device copy
+    [[nodiscard]] StagingRing& stagingRing();
+    // records a one time command buffer submitted to the main queue after everything submitted before,
+    // staging ring allocations made since the last retire() are retired with it
+    TimelinePoint submitStagingCopy(const std::function<void(const vk::raii::CommandBuffer&)>& record);
+
+    // scratch of filters aliases the same memory
+    [[nodiscard]] TransientHeap& transientHeap();
+
+    // layouts and pipelines shared by filters
+    [[nodiscard]] PipelineRegistry& pipelineRegistry();
+
+    // compiles shaders and creates pipelines of the filter types (RPRPP_FILTER_TYPE_* bits) for images of the formats
+    // on background threads, filters find them in the pipeline registry. doesn't wait for anything
+    void prewarm(const std::vector<ImageFormat>& formats, uint32_t filterTypes);
+    [[nodiscard]] bool prewarmFinished() const;
+    // rethrows the first error of the prewarm tasks
+    void waitPrewarm();
+
+    // device memory of buffers and images is sub-allocated from it
+    [[nodiscard]] MemoryAllocator& memoryAllocator() noexcept { return m_memoryAllocator; }
+    [[nodiscard]] const MemoryStatistics& memoryStatistics() const noexcept { return m_memoryAllocator.statistics(); }
 
     [[nodiscard]] boost::uuids::uuid generateNextTag() { return m_objects.generateNextTag(); }
 
@@ -63,10 +140,43 @@ public:
     [[nodiscard]] const vk::helper::DeviceContext& deviceContext() const noexcept { return m_deviceContext; }
 
 private:
+    // transfer family if every image can be accessed there, otherwise the main one
+    [[nodiscard]] uint32_t copyQueueFamilyIndex(const std::vector<const Image*>& images) const;
+    [[nodiscard]] const vk::raii::Queue& copyQueue(uint32_t queueFamilyIndex) const noexcept;
+    void recordCopyBufferToImage(const vk::raii::CommandBuffer& commandBuffer, Buffer* buffer, Image* image, uint32_t queueFamilyIndex);
+    void recordBufferToImageCommands(const vk::raii::CommandBuffer& commandBuffer, vk::Buffer buffer, vk::DeviceSize offset, Image* image, uint32_t queueFamilyIndex);
+    void recordCopyImageToBuffer(const vk::raii::CommandBuffer& commandBuffer, Image* image, Buffer* buffer, uint32_t queueFamilyIndex);
+    void recordCopyImage(const vk::raii::CommandBuffer& commandBuffer, Image* src, Image* dst, uint32_t queueFamilyIndex);
+    // waits only for the copy and the work submitted to the main queue before it
+    void submitCopy(const vk::helper::CommandBuffer& commandBuffer, uint32_t queueFamilyIndex);
+    std::unique_ptr<vk::helper::CommandBuffer> takeAsyncCopyCommandBuffer(uint32_t queueFamilyIndex);
+    TimelinePoint submitCopyAsync(std::unique_ptr<vk::helper::CommandBuffer> commandBuffer, uint32_t queueFamilyIndex, const std::vector<TimelinePoint>& waits, vk::Fence fence = nullptr);
+
+    struct PendingCopy {
+        std::unique_ptr<vk::helper::CommandBuffer> commandBuffer;
+        TimelinePoint finished;
+    };
+
     // order is matter. First should be cleared all m_objects, then denoiser dev, than main graph. dev
     vk::helper::DeviceContext m_deviceContext;
+    MemoryAllocator m_memoryAllocator;
     oidn::DeviceRef m_denoiserDevice;
+    vk::raii::Semaphore m_timelineSemaphore;
+    // signaled by async copies on the transfer queue
+    vk::raii::Semaphore m_copyTimelineSemaphore;
+    vk::raii::Semaphore m_copySemaphore;
+    vk::raii::Fence m_copyFence;
+    std::vector<PendingCopy> m_pendingCopies;
+    std::unique_ptr<StagingRing> m_stagingRing;
+    std::unique_ptr<TransientHeap> m_transientHeap;
+    std::unique_ptr<PipelineRegistry> m_pipelineRegistry;
+    // uses the registry, so it's stopped before the registry is destroyed
+    std::unique_ptr<Prewarmer> m_prewarmer;
+    ImagePool m_imagePool;
     ContextObjectContainer m_objects;
+    uint32_t m_framesInFlight = 1;
+    uint64_t m_timelineValue = 0;
+    uint64_t m_copyTimelineValue = 0;
 };
 
 }
\ No newline at end of file
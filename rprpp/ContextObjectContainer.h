@@ -34,6 +34,18 @@ public:
         erase(address->tag());
     }
 
+    // removes the object without destroying it
+    [[nodiscard]] ContextObjectRef extract(ContextObject* address)
+    {
+        auto node = m_objects.extract(m_objects.find(address->tag()));
+        return std::move(node.value());
+    }
+
+    ContextObject* insert(ContextObjectRef&& object)
+    {
+        return m_objects.insert(std::move(object)).first->get();
+    }
+
     [[nodiscard]] boost::uuids::uuid generateNextTag();
 
 private:
@@ -13,7 +13,7 @@ DxImage::DxImage(Context* context, const ImageDescription& desc, HANDLE dx11text
     vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eTopOfPipe;
 
     vk::raii::Image image = createImage(context, imageDescription, usage);
-    vk::raii::DeviceMemory memory = allocateDeviceMemory(context, &image, dx11textureHandle);
+    MemoryAllocation memory = allocateDeviceMemory(context, &image, dx11textureHandle);
     vk::raii::ImageView view = createImageView(context, &image, imageDescription);
 
     m_imageDataPtr = std::make_unique<ImageData>(
@@ -53,7 +53,7 @@ vk::raii::Image DxImage::createImage(Context* context, const ImageDescription& d
     return vk::raii::Image(context->deviceContext().device, imageInfo);
 }
 
-vk::raii::DeviceMemory DxImage::allocateDeviceMemory(Context* context, vk::raii::Image* image, HANDLE dx11textureHandle)
+MemoryAllocation DxImage::allocateDeviceMemory(Context* context, vk::raii::Image* image, HANDLE dx11textureHandle)
 {
     vk::MemoryDedicatedRequirements memoryDedicatedRequirements;
     vk::MemoryRequirements2 memoryRequirements2({}, &memoryDedicatedRequirements);
@@ -68,8 +68,9 @@ vk::raii::DeviceMemory DxImage::allocateDeviceMemory(Context* context, vk::raii:
     vk::MemoryAllocateInfo memoryAllocateInfo(memoryRequirements2.memoryRequirements.size,
         memoryType,
         &importMemoryInfo);
-    vk::raii::DeviceMemory memory = context->deviceContext().device.allocateMemory(memoryAllocateInfo);
-    image->bindMemory(*memory, 0);
+    // imported memory is dedicated to the image
+    MemoryAllocation memory = context->memoryAllocator().allocateDedicated(memoryAllocateInfo);
+    image->bindMemory(memory.memory(), 0);
 
     return memory;
 }
@@ -99,6 +100,12 @@ bool DxImage::IsSampled() const
     return m_imageDataPtr->IsSampled();
 }
 
+bool DxImage::IsConcurrent() const
+{
+    // keeps exclusive sharing of the imported texture
+    return false;
+}
+
 const ImageDescription& DxImage::description() const
 {
     assert(m_imageDataPtr);
@@ -13,6 +13,8 @@ public:
 
     [[nodiscard]] bool IsSampled() const override;
 
+    [[nodiscard]] bool IsConcurrent() const override;
+
     [[nodiscard]] const ImageDescription& description() const override;
 
     [[nodiscard]] const vk::raii::ImageView& view() const override;
@@ -33,7 +35,7 @@ protected:
 private:
     // constructors
     static vk::raii::Image createImage(Context* context, const ImageDescription& desc, vk::ImageUsageFlags imageUsageFlags);
-    static vk::raii::DeviceMemory allocateDeviceMemory(Context* context, vk::raii::Image* image, HANDLE dx11textureHandle);
+    static MemoryAllocation allocateDeviceMemory(Context* context, vk::raii::Image* image, HANDLE dx11textureHandle);
     static vk::raii::ImageView createImageView(Context* context, vk::raii::Image* image, const ImageDescription& imageDescription);
 
     std::unique_ptr<ImageData> m_imageDataPtr;
@@ -0,0 +1,102 @@
+#include "FusedPass.h"
+#include "Context.h"
+#include "Image.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr int WorkgroupSize = 32;
+
+namespace rprpp {
+
+FusedPass::FusedPass(Context* context)
+    : ContextObject(context)
+{
+}
+
+static bool samePipeline(const std::vector<filters::PointwiseStage>& a, const std::vector<filters::PointwiseStage>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].shader != b[i].shader
+            || a[i].descriptorSetLayout != b[i].descriptorSetLayout
+            || a[i].specializationEntries != b[i].specializationEntries
+            || a[i].specializationData != b[i].specializationData) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool FusedPass::update(const std::vector<filters::PointwiseStage>& stages)
+{
+    if (m_computePipeline && stages == m_stages) {
+        return false;
+    }
+
+    bool rebuild = !m_computePipeline || !samePipeline(stages, m_stages);
+    m_stages = stages;
+    if (rebuild) {
+        createComputePipeline();
+    }
+
+    return true;
+}
+
+void FusedPass::createComputePipeline()
+{
+    std::vector<vk::helper::FusedShaderStage> shaderStages;
+    std::vector<vk::DescriptorSetLayout> descriptorSetLayouts;
+    std::vector<vk::SpecializationMapEntry> specializationEntries;
+    std::vector<uint8_t> specializationData;
+    uint32_t constantIdBase = 0;
+    for (const filters::PointwiseStage& stage : m_stages) {
+        // the shader adds the base to the constant ids of the stage, the ids of the entries are moved the same way
+        vk::helper::FusedShaderStage shader = stage.shader;
+        shader.constantIdBase = constantIdBase;
+        shaderStages.push_back(shader);
+        descriptorSetLayouts.push_back(stage.descriptorSetLayout);
+
+        uint32_t constantIdEnd = constantIdBase;
+        for (vk::SpecializationMapEntry entry : stage.specializationEntries) {
+            entry.constantID += constantIdBase;
+            entry.offset += static_cast<uint32_t>(specializationData.size());
+            specializationEntries.push_back(entry);
+            constantIdEnd = std::max(constantIdEnd, entry.constantID + 1);
+        }
+        constantIdBase = constantIdEnd;
+        specializationData.insert(specializationData.end(), stage.specializationData.begin(), stage.specializationData.end());
+    }
+
+    PipelineRegistry& registry = context()->pipelineRegistry();
+    m_pipelineLayout = registry.pipelineLayout(descriptorSetLayouts);
+
+    vk::SpecializationInfo specializationInfo(static_cast<uint32_t>(specializationEntries.size()), specializationEntries.data(), specializationData.size(), specializationData.data());
+    m_computePipeline = registry.computePipeline(
+        vk::helper::ShaderManager::fusedVariantKey(shaderStages, WorkgroupSize),
+        m_pipelineLayout,
+        [&] { return vk::helper::ShaderManager().getFusedShader(deviceContext().device, shaderStages, WorkgroupSize); },
+        &specializationInfo);
+}
+
+void FusedPass::record(const vk::raii::CommandBuffer& commandBuffer, uint32_t frameIndex) const
+{
+    std::vector<vk::DescriptorSet> descriptorSets;
+    std::vector<uint32_t> dynamicOffsets;
+    for (const filters::PointwiseStage& stage : m_stages) {
+        descriptorSets.push_back(stage.descriptorSet);
+        dynamicOffsets.push_back(frameIndex * stage.dynamicOffsetStride);
+    }
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_computePipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, descriptorSets, dynamicOffsets);
+
+    const ImageDescription& desc = m_stages.back().output->description();
+    commandBuffer.dispatch((uint32_t)ceil(desc.width / float(WorkgroupSize)), (uint32_t)ceil(desc.height / float(WorkgroupSize)), 1);
+}
+
+}
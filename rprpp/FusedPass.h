@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ContextObject.h"
+#include "filters/ComputeFilter.h"
+#include "vk/ShaderManager.h"
+
+#include <vector>
+
+namespace rprpp {
+
+// one dispatch running the pointwise stages of adjacent filters, intermediate colors stay in registers.
+// descriptor sets are owned by the filters, stage i is bound to set i.
+class FusedPass : public ContextObject {
+public:
+    explicit FusedPass(Context* context);
+
+    // returns true if the recorded commands are out of date
+    bool update(const std::vector<filters::PointwiseStage>& stages);
+    void record(const vk::raii::CommandBuffer& commandBuffer, uint32_t frameIndex) const;
+
+private:
+    void createComputePipeline();
+
+    std::vector<filters::PointwiseStage> m_stages;
+    // owned by the context's pipeline registry
+    vk::PipelineLayout m_pipelineLayout;
+    vk::Pipeline m_computePipeline;
+};
+
+}
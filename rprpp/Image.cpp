@@ -17,8 +17,8 @@ void Image::transitionImageLayout(vk::AccessFlags dstAccessFlags, vk::ImageLayou
     commandBuffer.end();
 
     vk::SubmitInfo submitInfo(nullptr, nullptr, *commandBuffer);
-    deviceContext().queue.submit(submitInfo);
-    deviceContext().queue.waitIdle();
+    deviceContext().submit(deviceContext().queue, submitInfo);
+    deviceContext().waitIdle(deviceContext().queue);
     deviceContext().returnCommandBuffer(std::move(commandBuffer));
 }
 
@@ -50,4 +50,10 @@ void Image::transitionImageLayout(const vk::raii::CommandBuffer& commandBuffer,
     updateStages(dstPipelineStageFlags);
 }
 
+void Image::markSynchronized(vk::PipelineStageFlags stages)
+{
+    updateAccess({});
+    updateStages(stages);
+}
+
 } // namespace rprpp
\ No newline at end of file
@@ -13,6 +13,9 @@ public:
 
     [[nodiscard]] virtual bool IsSampled() const = 0;
 
+    // created with concurrent sharing, so it can be used on every queue of the context without ownership transfers
+    [[nodiscard]] virtual bool IsConcurrent() const = 0;
+
     [[nodiscard]] virtual const ImageDescription& description() const = 0;
 
     [[nodiscard]] virtual const vk::raii::ImageView& view() const = 0;
@@ -37,6 +40,10 @@ public:
         vk::ImageLayout newImageLayout,
         vk::PipelineStageFlags newPipelineStageFlags);
 
+    // previous accesses are already synchronized by a semaphore or a fence, e.g. the image is used on another queue.
+    // so the next barrier only has to wait for the given stages, that have to be supported by the queue it's recorded for
+    void markSynchronized(vk::PipelineStageFlags stages);
+
 protected:
     virtual void updateLayout(vk::ImageLayout newLayout) = 0;
     virtual void updateStages(vk::PipelineStageFlags newPipelineStageFlags) = 0;
@@ -4,16 +4,16 @@ namespace rprpp {
 ImageData::ImageData(Context* context,
     vk::raii::Image&& _image,
     ImageDescription _description,
-    vk::raii::DeviceMemory&& _memory,
+    MemoryAllocation&& _memory,
     vk::raii::ImageView&& _view,
     vk::ImageUsageFlags _usage,
     vk::AccessFlags _access,
     vk::ImageLayout _layout,
     vk::PipelineStageFlags _stages)
     : Image(context)
+    , m_memory(std::move(_memory))
     , m_image(std::move(_image))
     , m_description(_description)
-    , m_memory(std::move(_memory))
     , m_view(std::move(_view))
     , m_usage(_usage)
     , m_access(_access)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Image.h"
+#include "MemoryAllocator.h"
 
 namespace rprpp {
 
@@ -9,7 +10,7 @@ public:
     ImageData(Context* context,
         vk::raii::Image&& _image,
         ImageDescription _description,
-        vk::raii::DeviceMemory&& _memory,
+        MemoryAllocation&& _memory,
         vk::raii::ImageView&& _view,
         vk::ImageUsageFlags _usage,
         vk::AccessFlags _access,
@@ -37,9 +38,10 @@ public:
     void updateAccess(vk::AccessFlags newFlags) override;
 
 private:
+    // declared before the image, so the memory is freed after the image is destroyed
+    MemoryAllocation m_memory;
     vk::raii::Image m_image;
     ImageDescription m_description;
-    vk::raii::DeviceMemory m_memory;
     vk::raii::ImageView m_view;
 
     vk::ImageUsageFlags m_usage;
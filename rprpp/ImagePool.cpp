@@ -0,0 +1,61 @@
+#include "ImagePool.h"
+
+#include <cassert>
+
+namespace rprpp {
+
+static size_t imageSize(const ImageDescription& desc)
+{
+    return size_t(desc.width) * desc.height * to_pixel_size(desc.format);
+}
+
+ImagePool::ImagePool(size_t capacity)
+    : m_capacity(capacity)
+{
+}
+
+ContextObjectRef ImagePool::take(const ImageDescription& desc, std::vector<TimelinePoint>& lastUse)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (static_cast<Image*>(it->image.get())->description() == desc) {
+            ContextObjectRef image = std::move(it->image);
+            lastUse = std::move(it->lastUse);
+            m_size -= it->size;
+            m_entries.erase(it);
+            return image;
+        }
+    }
+
+    return nullptr;
+}
+
+void ImagePool::put(ContextObjectRef&& image, std::vector<TimelinePoint> lastUse)
+{
+    assert(dynamic_cast<Image*>(image.get()));
+    size_t size = imageSize(static_cast<Image*>(image.get())->description());
+    m_entries.push_front(Entry { std::move(image), size, std::move(lastUse) });
+    m_size += size;
+    evict();
+}
+
+void ImagePool::setCapacity(size_t capacity)
+{
+    m_capacity = capacity;
+    evict();
+}
+
+void ImagePool::clear() noexcept
+{
+    m_entries.clear();
+    m_size = 0;
+}
+
+void ImagePool::evict()
+{
+    while (m_size > m_capacity) {
+        m_size -= m_entries.back().size;
+        m_entries.pop_back();
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ContextObject.h"
+#include "Image.h"
+#include "SubmitSync.h"
+
+#include <list>
+#include <vector>
+
+namespace rprpp {
+
+// images destroyed by the user, kept to be handed out again by createImage() with the same description.
+// only ImageSimple is pooled, its usage is always the same, so the description is the whole key.
+// the pool doesn't wait for the GPU, work submitted before an image was returned might still use it
+class ImagePool : public boost::noncopyable {
+public:
+    explicit ImagePool(size_t capacity);
+
+    // the most recently returned idle image with the description, nullptr if there is none.
+    // lastUse receives the timeline points passed to put(), they have to be waited before the image is used
+    [[nodiscard]] ContextObjectRef take(const ImageDescription& desc, std::vector<TimelinePoint>& lastUse);
+    // lastUse are signaled once the work submitted before the image was returned has finished.
+    // the least recently returned images are destroyed while the pool holds more than capacity bytes
+    void put(ContextObjectRef&& image, std::vector<TimelinePoint> lastUse);
+
+    void setCapacity(size_t capacity);
+    [[nodiscard]] size_t capacity() const noexcept { return m_capacity; }
+    // bytes held by idle images
+    [[nodiscard]] size_t size() const noexcept { return m_size; }
+
+    void clear() noexcept;
+
+private:
+    struct Entry {
+        ContextObjectRef image;
+        size_t size;
+        std::vector<TimelinePoint> lastUse;
+    };
+
+    void evict();
+
+    // front is the most recently returned one, the pool is small so lookup is a linear scan
+    std::list<Entry> m_entries;
+    size_t m_capacity;
+    size_t m_size = 0;
+};
+
+}
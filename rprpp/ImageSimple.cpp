@@ -17,19 +17,18 @@ vk::raii::Image ImageSimple::createImage(
         vk::SampleCountFlagBits::e1,
         vk::ImageTiling::eOptimal,
         imageUsageFlags,
-        vk::SharingMode::eExclusive,
-        nullptr,
+        context->deviceContext().sharingMode(),
+        context->deviceContext().queueFamilyIndices,
         vk::ImageLayout::eUndefined);
 
     return vk::raii::Image(context->deviceContext().device, imageInfo);
 }
 
-vk::raii::DeviceMemory ImageSimple::allocateDeviceMemory(Context* context, vk::raii::Image* image)
+MemoryAllocation ImageSimple::allocateDeviceMemory(Context* context, vk::raii::Image* image)
 {
     vk::MemoryRequirements memRequirements = image->getMemoryRequirements();
-    uint32_t memoryType = vk::helper::findMemoryType(context->deviceContext().physicalDevice, memRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
-    vk::raii::DeviceMemory memory = context->deviceContext().device.allocateMemory(vk::MemoryAllocateInfo(memRequirements.size, memoryType));
-    image->bindMemory(*memory, 0);
+    MemoryAllocation memory = context->memoryAllocator().allocate(memRequirements, vk::MemoryPropertyFlagBits::eDeviceLocal, false);
+    image->bindMemory(memory.memory(), memory.offset());
 
     return memory;
 }
@@ -55,7 +54,7 @@ ImageSimple::ImageSimple(Context* context, const ImageDescription& desc)
     vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eTopOfPipe;
 
     vk::raii::Image image = createImage(context, imageDescription, usage);
-    vk::raii::DeviceMemory memory = allocateDeviceMemory(context, &image);
+    MemoryAllocation memory = allocateDeviceMemory(context, &image);
     vk::raii::ImageView view = createImageView(context, &image, imageDescription);
 
     m_imageDataPtr = std::make_unique<ImageData>(
@@ -85,6 +84,11 @@ bool ImageSimple::IsSampled() const
     return m_imageDataPtr->IsSampled();
 }
 
+bool ImageSimple::IsConcurrent() const
+{
+    return context()->deviceContext().sharingMode() == vk::SharingMode::eConcurrent;
+}
+
 const ImageDescription& ImageSimple::description() const
 {
     assert(m_imageDataPtr);
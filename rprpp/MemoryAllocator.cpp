@@ -0,0 +1,422 @@
+#include "MemoryAllocator.h"
+#include "Error.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <utility>
+
+namespace rprpp {
+
+namespace {
+
+    constexpr vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // two level segregated fit over offsets [0, size). Free ranges are kept in lists indexed by the power of two
+    // of their size and by a linear subdivision of it, bitmaps of non empty lists make both allocate and free O(1)
+    class Tlsf {
+    public:
+        static constexpr uint32_t InvalidNode = UINT32_MAX;
+        // every range is a multiple of it, so smaller alignments come for free
+        static constexpr vk::DeviceSize Granularity = 256;
+
+        explicit Tlsf(vk::DeviceSize size)
+        {
+            for (auto& heads : m_freeHeads) {
+                heads.fill(InvalidNode);
+            }
+            insertFree(createNode(0, size, InvalidNode, InvalidNode));
+        }
+
+        // returns InvalidNode if no free range fits
+        [[nodiscard]] uint32_t allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+        {
+            size = alignUp(size, Granularity);
+            alignment = std::max(alignment, Granularity);
+            // a range found for the padded size fits at any offset alignment
+            const vk::DeviceSize searchSize = alignment > Granularity ? size + alignment - Granularity : size;
+
+            uint32_t node = findFree(searchSize);
+            if (node == InvalidNode) {
+                return InvalidNode;
+            }
+            removeFree(node);
+
+            const vk::DeviceSize padding = alignUp(m_nodes[node].offset, alignment) - m_nodes[node].offset;
+            if (padding > 0) {
+                // the previous range is in use, otherwise it would have been merged with this one
+                uint32_t front = createNode(m_nodes[node].offset, padding, m_nodes[node].prevPhysical, node);
+                if (m_nodes[node].prevPhysical != InvalidNode) {
+                    m_nodes[m_nodes[node].prevPhysical].nextPhysical = front;
+                }
+                m_nodes[node].prevPhysical = front;
+                m_nodes[node].offset += padding;
+                m_nodes[node].size -= padding;
+                insertFree(front);
+            }
+
+            if (m_nodes[node].size > size) {
+                uint32_t back = createNode(m_nodes[node].offset + size, m_nodes[node].size - size, node, m_nodes[node].nextPhysical);
+                if (m_nodes[node].nextPhysical != InvalidNode) {
+                    m_nodes[m_nodes[node].nextPhysical].prevPhysical = back;
+                }
+                m_nodes[node].nextPhysical = back;
+                m_nodes[node].size = size;
+                insertFree(back);
+            }
+
+            ++m_usedCount;
+            return node;
+        }
+
+        void free(uint32_t node)
+        {
+            assert(!m_nodes[node].free);
+            --m_usedCount;
+
+            uint32_t prev = m_nodes[node].prevPhysical;
+            if (prev != InvalidNode && m_nodes[prev].free) {
+                removeFree(prev);
+                m_nodes[prev].size += m_nodes[node].size;
+                unlinkPhysical(node);
+                node = prev;
+            }
+
+            uint32_t next = m_nodes[node].nextPhysical;
+            if (next != InvalidNode && m_nodes[next].free) {
+                removeFree(next);
+                m_nodes[node].size += m_nodes[next].size;
+                unlinkPhysical(next);
+            }
+
+            insertFree(node);
+        }
+
+        [[nodiscard]] vk::DeviceSize offset(uint32_t node) const noexcept { return m_nodes[node].offset; }
+        [[nodiscard]] vk::DeviceSize size(uint32_t node) const noexcept { return m_nodes[node].size; }
+        [[nodiscard]] bool empty() const noexcept { return m_usedCount == 0; }
+
+    private:
+        static constexpr uint32_t SecondLevelLog2 = 4;
+        static constexpr uint32_t SecondLevelCount = 1 << SecondLevelLog2;
+        static constexpr uint32_t FirstLevelCount = 64;
+
+        struct Node {
+            vk::DeviceSize offset;
+            vk::DeviceSize size;
+            uint32_t prevPhysical;
+            uint32_t nextPhysical;
+            uint32_t prevFree = InvalidNode;
+            uint32_t nextFree = InvalidNode;
+            bool free = false;
+        };
+
+        static void mapping(vk::DeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel) noexcept
+        {
+            firstLevel = static_cast<uint32_t>(std::bit_width(size)) - 1;
+            secondLevel = static_cast<uint32_t>(size >> (firstLevel - SecondLevelLog2)) - SecondLevelCount;
+        }
+
+        uint32_t createNode(vk::DeviceSize offset, vk::DeviceSize size, uint32_t prevPhysical, uint32_t nextPhysical)
+        {
+            Node node { offset, size, prevPhysical, nextPhysical };
+            if (m_unusedNodes.empty()) {
+                m_nodes.push_back(node);
+                return static_cast<uint32_t>(m_nodes.size() - 1);
+            }
+
+            uint32_t index = m_unusedNodes.back();
+            m_unusedNodes.pop_back();
+            m_nodes[index] = node;
+            return index;
+        }
+
+        void unlinkPhysical(uint32_t node)
+        {
+            uint32_t prev = m_nodes[node].prevPhysical;
+            uint32_t next = m_nodes[node].nextPhysical;
+            if (prev != InvalidNode) {
+                m_nodes[prev].nextPhysical = next;
+            }
+            if (next != InvalidNode) {
+                m_nodes[next].prevPhysical = prev;
+            }
+            m_unusedNodes.push_back(node);
+        }
+
+        void insertFree(uint32_t node)
+        {
+            uint32_t firstLevel, secondLevel;
+            mapping(m_nodes[node].size, firstLevel, secondLevel);
+
+            uint32_t head = m_freeHeads[firstLevel][secondLevel];
+            m_nodes[node].free = true;
+            m_nodes[node].prevFree = InvalidNode;
+            m_nodes[node].nextFree = head;
+            if (head != InvalidNode) {
+                m_nodes[head].prevFree = node;
+            }
+            m_freeHeads[firstLevel][secondLevel] = node;
+            m_firstLevelBitmap |= uint64_t(1) << firstLevel;
+            m_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+        }
+
+        void removeFree(uint32_t node)
+        {
+            uint32_t firstLevel, secondLevel;
+            mapping(m_nodes[node].size, firstLevel, secondLevel);
+
+            uint32_t prev = m_nodes[node].prevFree;
+            uint32_t next = m_nodes[node].nextFree;
+            if (prev != InvalidNode) {
+                m_nodes[prev].nextFree = next;
+            } else {
+                m_freeHeads[firstLevel][secondLevel] = next;
+            }
+            if (next != InvalidNode) {
+                m_nodes[next].prevFree = prev;
+            }
+            m_nodes[node].free = false;
+
+            if (m_freeHeads[firstLevel][secondLevel] == InvalidNode) {
+                m_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+                if (m_secondLevelBitmaps[firstLevel] == 0) {
+                    m_firstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+                }
+            }
+        }
+
+        // head of the first non empty list whose every range is at least size
+        [[nodiscard]] uint32_t findFree(vk::DeviceSize size) const noexcept
+        {
+            uint32_t firstLevel, secondLevel;
+            // rounding up to the next list skips the lists that also hold smaller ranges
+            mapping(size + (vk::DeviceSize(1) << (std::bit_width(size) - 1 - SecondLevelLog2)) - 1, firstLevel, secondLevel);
+            if (firstLevel >= FirstLevelCount) {
+                return InvalidNode;
+            }
+
+            uint32_t secondLevelMap = m_secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+            if (secondLevelMap == 0) {
+                uint64_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? m_firstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+                if (firstLevelMap == 0) {
+                    return InvalidNode;
+                }
+                firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+                secondLevelMap = m_secondLevelBitmaps[firstLevel];
+            }
+
+            return m_freeHeads[firstLevel][std::countr_zero(secondLevelMap)];
+        }
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_unusedNodes;
+        uint64_t m_firstLevelBitmap = 0;
+        std::array<uint32_t, FirstLevelCount> m_secondLevelBitmaps {};
+        std::array<std::array<uint32_t, SecondLevelCount>, FirstLevelCount> m_freeHeads;
+        uint32_t m_usedCount = 0;
+    };
+
+}
+
+struct MemoryAllocator::Block {
+    Block(vk::raii::DeviceMemory&& memory, vk::DeviceSize size, Pool* pool)
+        : memory(std::move(memory))
+        , size(size)
+        , pool(pool)
+        , heap(size)
+    {
+    }
+
+    vk::raii::DeviceMemory memory;
+    vk::DeviceSize size;
+    Pool* pool;
+    Tlsf heap;
+    void* mapped = nullptr;
+};
+
+MemoryAllocator::MemoryAllocator(const vk::helper::DeviceContext* deviceContext)
+    : m_deviceContext(deviceContext)
+    , m_memoryProperties(deviceContext->physicalDevice.getMemoryProperties())
+{
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+    assert(m_statistics.allocationCount == 0 && m_statistics.dedicatedAllocationCount == 0);
+}
+
+vk::DeviceSize MemoryAllocator::blockSize(uint32_t memoryType) const noexcept
+{
+    constexpr vk::DeviceSize LargeHeapSize = 4ull * 1024 * 1024 * 1024;
+    const vk::DeviceSize heapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[memoryType].heapIndex].size;
+    return heapSize >= LargeHeapSize ? 256 * 1024 * 1024 : 64 * 1024 * 1024;
+}
+
+MemoryAllocation MemoryAllocator::allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool linear)
+{
+    const uint32_t memoryType = vk::helper::findMemoryType(m_deviceContext->physicalDevice, requirements.memoryTypeBits, properties);
+    const vk::DeviceSize size = blockSize(memoryType);
+    // a resource that takes most of a block would leave the rest of it unusable
+    if (requirements.size > size / 2) {
+        return allocateDedicated(vk::MemoryAllocateInfo(requirements.size, memoryType));
+    }
+
+    Pool& pool = m_pools[memoryType * 2 + (linear ? 1 : 0)];
+    Block* block = nullptr;
+    uint32_t node = Tlsf::InvalidNode;
+    for (auto& candidate : pool.blocks) {
+        node = candidate->heap.allocate(requirements.size, requirements.alignment);
+        if (node != Tlsf::InvalidNode) {
+            block = candidate.get();
+            break;
+        }
+    }
+
+    if (block == nullptr) {
+        pool.blocks.push_back(std::make_unique<Block>(m_deviceContext->device.allocateMemory(vk::MemoryAllocateInfo(size, memoryType)), size, &pool));
+        block = pool.blocks.back().get();
+        node = block->heap.allocate(requirements.size, requirements.alignment);
+        if (node == Tlsf::InvalidNode) {
+            throw InternalError("Failed to sub-allocate " + std::to_string(requirements.size) + " bytes from an empty block");
+        }
+        ++m_statistics.blockCount;
+        m_statistics.blockBytes += size;
+    }
+
+    ++m_statistics.allocationCount;
+    m_statistics.allocationBytes += block->heap.size(node);
+    return MemoryAllocation(this, block, node, block->heap.offset(node), requirements.size);
+}
+
+MemoryAllocation MemoryAllocator::allocateDedicated(const vk::MemoryAllocateInfo& info)
+{
+    vk::raii::DeviceMemory memory = m_deviceContext->device.allocateMemory(info);
+    ++m_statistics.dedicatedAllocationCount;
+    m_statistics.dedicatedAllocationBytes += info.allocationSize;
+    return MemoryAllocation(this, std::move(memory), info.allocationSize);
+}
+
+void MemoryAllocator::free(Block* block, uint32_t node) noexcept
+{
+    --m_statistics.allocationCount;
+    m_statistics.allocationBytes -= block->heap.size(node);
+    block->heap.free(node);
+    if (!block->heap.empty()) {
+        return;
+    }
+
+    // one empty block per pool is kept, resizing frees and allocates the same amount right away
+    Pool* pool = block->pool;
+    auto emptyBlocks = std::count_if(pool->blocks.begin(), pool->blocks.end(), [](const std::unique_ptr<Block>& b) { return b->heap.empty(); });
+    if (emptyBlocks > 1) {
+        --m_statistics.blockCount;
+        m_statistics.blockBytes -= block->size;
+        std::erase_if(pool->blocks, [block](const std::unique_ptr<Block>& b) { return b.get() == block; });
+    }
+}
+
+void MemoryAllocator::freeDedicated(vk::DeviceSize size) noexcept
+{
+    --m_statistics.dedicatedAllocationCount;
+    m_statistics.dedicatedAllocationBytes -= size;
+}
+
+MemoryAllocation::MemoryAllocation(MemoryAllocator* allocator, MemoryAllocator::Block* block, uint32_t node, vk::DeviceSize offset, vk::DeviceSize size) noexcept
+    : m_allocator(allocator)
+    , m_block(block)
+    , m_node(node)
+    , m_offset(offset)
+    , m_size(size)
+{
+}
+
+MemoryAllocation::MemoryAllocation(MemoryAllocator* allocator, vk::raii::DeviceMemory&& memory, vk::DeviceSize size) noexcept
+    : m_allocator(allocator)
+    , m_size(size)
+    , m_dedicated(std::move(memory))
+{
+}
+
+MemoryAllocation::MemoryAllocation(MemoryAllocation&& other) noexcept
+    : m_allocator(std::exchange(other.m_allocator, nullptr))
+    , m_block(std::exchange(other.m_block, nullptr))
+    , m_node(other.m_node)
+    , m_offset(other.m_offset)
+    , m_size(other.m_size)
+    , m_dedicated(std::move(other.m_dedicated))
+    , m_mapped(std::exchange(other.m_mapped, nullptr))
+{
+    other.m_dedicated.reset();
+}
+
+MemoryAllocation& MemoryAllocation::operator=(MemoryAllocation&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_allocator = std::exchange(other.m_allocator, nullptr);
+        m_block = std::exchange(other.m_block, nullptr);
+        m_node = other.m_node;
+        m_offset = other.m_offset;
+        m_size = other.m_size;
+        m_dedicated = std::move(other.m_dedicated);
+        other.m_dedicated.reset();
+        m_mapped = std::exchange(other.m_mapped, nullptr);
+    }
+
+    return *this;
+}
+
+MemoryAllocation::~MemoryAllocation()
+{
+    release();
+}
+
+void MemoryAllocation::release() noexcept
+{
+    if (m_allocator == nullptr) {
+        return;
+    }
+
+    if (m_dedicated.has_value()) {
+        m_dedicated.reset();
+        m_allocator->freeDedicated(m_size);
+    } else {
+        m_allocator->free(m_block, m_node);
+    }
+
+    m_allocator = nullptr;
+    m_block = nullptr;
+    m_mapped = nullptr;
+}
+
+vk::DeviceMemory MemoryAllocation::memory() const noexcept
+{
+    if (m_dedicated.has_value()) {
+        return **m_dedicated;
+    }
+
+    return m_block ? *m_block->memory : vk::DeviceMemory();
+}
+
+void* MemoryAllocation::map()
+{
+    if (m_mapped == nullptr) {
+        if (m_dedicated.has_value()) {
+            m_mapped = m_dedicated->mapMemory(0, VK_WHOLE_SIZE, {});
+        } else {
+            if (m_block->mapped == nullptr) {
+                m_block->mapped = m_block->memory.mapMemory(0, VK_WHOLE_SIZE, {});
+            }
+            m_mapped = static_cast<uint8_t*>(m_block->mapped) + m_offset;
+        }
+    }
+
+    return m_mapped;
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "vk/DeviceContext.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace rprpp {
+
+class MemoryAllocation;
+
+struct MemoryStatistics {
+    // device memory objects sub-allocated by the allocator
+    uint64_t blockCount = 0;
+    uint64_t blockBytes = 0;
+    // live sub-allocations in these blocks
+    uint64_t allocationCount = 0;
+    uint64_t allocationBytes = 0;
+    // device memory objects owned by a single resource: imported, exportable or too large for a block
+    uint64_t dedicatedAllocationCount = 0;
+    uint64_t dedicatedAllocationBytes = 0;
+};
+
+// sub-allocates resources from large blocks of device memory, a two level segregated fit heap per block.
+// buffers and images never share a block, so bufferImageGranularity doesn't have to be taken into account
+class MemoryAllocator : public boost::noncopyable {
+public:
+    explicit MemoryAllocator(const vk::helper::DeviceContext* deviceContext);
+    ~MemoryAllocator();
+
+    // linear is true for buffers and false for optimal tiling images
+    [[nodiscard]] MemoryAllocation allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool linear);
+    // imported and exportable memory can't be shared with other resources
+    [[nodiscard]] MemoryAllocation allocateDedicated(const vk::MemoryAllocateInfo& info);
+
+    [[nodiscard]] const MemoryStatistics& statistics() const noexcept { return m_statistics; }
+
+private:
+    friend class MemoryAllocation;
+    struct Block;
+    struct Pool {
+        std::vector<std::unique_ptr<Block>> blocks;
+    };
+
+    [[nodiscard]] vk::DeviceSize blockSize(uint32_t memoryType) const noexcept;
+    void free(Block* block, uint32_t node) noexcept;
+    void freeDedicated(vk::DeviceSize size) noexcept;
+
+    const vk::helper::DeviceContext* m_deviceContext;
+    vk::PhysicalDeviceMemoryProperties m_memoryProperties;
+    // blocks of linear and optimal resources are kept apart, the key is memory type * 2 + linear
+    std::unordered_map<uint32_t, Pool> m_pools;
+    MemoryStatistics m_statistics;
+};
+
+// range of device memory, returned to the allocator when destroyed
+class MemoryAllocation {
+public:
+    MemoryAllocation() = default;
+    MemoryAllocation(MemoryAllocation&& other) noexcept;
+    MemoryAllocation& operator=(MemoryAllocation&& other) noexcept;
+    MemoryAllocation(const MemoryAllocation&) = delete;
+    MemoryAllocation& operator=(const MemoryAllocation&) = delete;
+    ~MemoryAllocation();
+
+    [[nodiscard]] vk::DeviceMemory memory() const noexcept;
+    [[nodiscard]] vk::DeviceSize offset() const noexcept { return m_offset; }
+    [[nodiscard]] vk::DeviceSize size() const noexcept { return m_size; }
+    [[nodiscard]] bool dedicated() const noexcept { return m_dedicated.has_value(); }
+
+    // the block is mapped once on the first call and stays mapped until it is freed
+    [[nodiscard]] void* map();
+
+private:
+    friend class MemoryAllocator;
+    MemoryAllocation(MemoryAllocator* allocator, MemoryAllocator::Block* block, uint32_t node, vk::DeviceSize offset, vk::DeviceSize size) noexcept;
+    MemoryAllocation(MemoryAllocator* allocator, vk::raii::DeviceMemory&& memory, vk::DeviceSize size) noexcept;
+    void release() noexcept;
+
+    MemoryAllocator* m_allocator = nullptr;
+    MemoryAllocator::Block* m_block = nullptr;
+    uint32_t m_node = 0;
+    vk::DeviceSize m_offset = 0;
+    vk::DeviceSize m_size = 0;
+    std::optional<vk::raii::DeviceMemory> m_dedicated;
+    void* m_mapped = nullptr;
+};
+
+}
@@ -0,0 +1,337 @@
+#include "Pipeline.h"
+#include "Context.h"
+#include "Error.h"
+#include "Image.h"
+
+#include <algorithm>
+
+namespace rprpp {
+
+namespace {
+
+    template <class T>
+    bool intersects(const std::vector<T>& a, const std::vector<T>& b)
+    {
+        return std::ranges::any_of(a, [&](const T& item) { return std::ranges::find(b, item) != b.end(); });
+    }
+
+    template <class T>
+    void append(std::vector<T>& to, const std::vector<T>& from)
+    {
+        to.insert(to.end(), from.begin(), from.end());
+    }
+
+    // read after write and write after write need the writes to be visible, write after read only needs the execution order
+    bool hazard(const filters::FilterAccesses& before, const filters::FilterAccesses& after)
+    {
+        return intersects(before.writtenImages, after.readImages)
+            || intersects(before.writtenImages, after.writtenImages)
+            || intersects(before.readImages, after.writtenImages)
+            || intersects(before.writtenBuffers, after.readBuffers)
+            || intersects(before.writtenBuffers, after.writtenBuffers)
+            || intersects(before.readBuffers, after.writtenBuffers);
+    }
+
+    // orders everything recorded before and makes the writes of before visible
+    void recordBarrier(const vk::raii::CommandBuffer& commandBuffer, const filters::FilterAccesses& before)
+    {
+        vk::AccessFlags srcAccess = vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite;
+        vk::AccessFlags dstAccess = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+
+        std::vector<vk::ImageMemoryBarrier> imageBarriers;
+        for (Image* image : before.writtenImages) {
+            imageBarriers.emplace_back(srcAccess,
+                dstAccess,
+                image->layout(),
+                image->layout(),
+                VK_QUEUE_FAMILY_IGNORED,
+                VK_QUEUE_FAMILY_IGNORED,
+                image->image(),
+                vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS));
+        }
+
+        std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+        for (vk::Buffer buffer : before.writtenBuffers) {
+            bufferBarriers.emplace_back(srcAccess, dstAccess, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, buffer, 0, VK_WHOLE_SIZE);
+        }
+
+        vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer;
+        commandBuffer.pipelineBarrier(stages, stages, {}, nullptr, bufferBarriers, imageBarriers);
+    }
+
+}
+
+Pipeline::Pipeline(Context* context)
+    : ContextObject(context)
+    , m_framesInFlight(context->framesInFlight())
+{
+    for (uint32_t i = 0; i < m_framesInFlight; i++) {
+        m_finishedSemaphores.push_back(deviceContext().device.createSemaphore({}));
+    }
+}
+
+void Pipeline::addFilter(filters::Filter* filter)
+{
+    if (filter == nullptr) {
+        throw InvalidParameter("filter", "cannot be null");
+    }
+
+    auto computeFilter = dynamic_cast<filters::ComputeFilter*>(filter);
+    if (computeFilter != nullptr && computeFilter->framesInFlight() != m_framesInFlight) {
+        throw InvalidParameter("filter", "has to be created with the same frames in flight as the pipeline");
+    }
+
+    m_filters.push_back(filter);
+    m_segmentsDirty = true;
+}
+
+void Pipeline::clear() noexcept
+{
+    m_filters.clear();
+    m_segmentsDirty = true;
+}
+
+void Pipeline::setFusion(bool fusion) noexcept
+{
+    m_fusion = fusion;
+}
+
+bool Pipeline::getFusion() const noexcept
+{
+    return m_fusion;
+}
+
+void Pipeline::buildSegments()
+{
+    // command buffers and semaphores of the previous segments might still be in use by the runs in flight
+    uint64_t completedValue = context()->completedTimelineValue();
+    std::erase_if(m_retiredSegments, [&](const RetiredSegments& retired) { return retired.lastUse <= completedValue; });
+    if (!m_segments.empty()) {
+        m_retiredSegments.push_back({ std::move(m_segments), m_submittedTimelineValue });
+        m_segments.clear();
+    }
+
+    for (filters::Filter* filter : m_filters) {
+        auto computeFilter = dynamic_cast<filters::ComputeFilter*>(filter);
+        if (computeFilter == nullptr) {
+            Segment segment;
+            segment.filter = filter;
+            for (uint32_t i = 0; i < m_framesInFlight; i++) {
+                segment.frames.push_back(SegmentFrame {
+                    .finishedSemaphore = deviceContext().device.createSemaphore({}),
+                });
+            }
+            m_segments.push_back(std::move(segment));
+            continue;
+        }
+
+        if (m_segments.empty() || m_segments.back().filter != nullptr) {
+            Segment segment;
+            for (uint32_t i = 0; i < m_framesInFlight; i++) {
+                segment.frames.push_back(SegmentFrame {
+                    .commandBuffer = std::make_unique<vk::helper::CommandBuffer>(&deviceContext()),
+                    .finishedSemaphore = deviceContext().device.createSemaphore({}),
+                });
+            }
+            m_segments.push_back(std::move(segment));
+        }
+        m_segments.back().computeFilters.push_back(computeFilter);
+    }
+}
+
+std::vector<size_t> Pipeline::fusionGroups(const std::vector<std::optional<filters::PointwiseStage>>& stages) const
+{
+    std::vector<size_t> groupSizes;
+    for (size_t i = 0; i < stages.size(); i++) {
+        bool fuse = i > 0
+            && stages[i - 1].has_value()
+            && stages[i].has_value()
+            && stages[i]->input != nullptr
+            && stages[i]->input == stages[i - 1]->output;
+
+        if (fuse) {
+            groupSizes.back()++;
+        } else {
+            groupSizes.push_back(1);
+        }
+    }
+
+    return groupSizes;
+}
+
+bool Pipeline::updateFusedPasses(Segment& segment, const std::vector<std::optional<filters::PointwiseStage>>& stages)
+{
+    std::vector<size_t> groupSizes = fusionGroups(stages);
+    bool changed = groupSizes != segment.groupSizes;
+    if (changed) {
+        segment.groupSizes = groupSizes;
+        segment.fusedPasses.clear();
+        segment.fusedPasses.resize(groupSizes.size());
+    }
+
+    size_t first = 0;
+    for (size_t group = 0; group < segment.groupSizes.size(); group++) {
+        size_t size = segment.groupSizes[group];
+        if (size > 1) {
+            if (!segment.fusedPasses[group]) {
+                segment.fusedPasses[group] = std::make_unique<FusedPass>(context());
+            }
+
+            std::vector<filters::PointwiseStage> groupStages;
+            for (size_t i = first; i < first + size; i++) {
+                groupStages.push_back(stages[i].value());
+            }
+            changed = segment.fusedPasses[group]->update(groupStages) || changed;
+        }
+        first += size;
+    }
+
+    if (changed) {
+        segment.fusionVersion++;
+    }
+
+    return changed;
+}
+
+void Pipeline::recordSegment(Segment& segment, SegmentFrame& frame)
+{
+    const vk::raii::CommandBuffer& commandBuffer = frame.commandBuffer->get();
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
+
+    frame.recordedCommandsVersions.clear();
+    // accesses recorded since the last barrier, the work of the previous submissions is ordered by semaphores.
+    // groups that don't touch what the previous ones have accessed run without a barrier and may overlap
+    filters::FilterAccesses pending;
+    size_t first = 0;
+    for (size_t group = 0; group < segment.groupSizes.size(); group++) {
+        size_t last = first + segment.groupSizes[group] - 1;
+        filters::FilterAccesses accesses;
+        for (size_t i = first; i <= last; i++) {
+            filters::FilterAccesses filterAccesses = segment.computeFilters[i]->accesses();
+            append(accesses.readImages, filterAccesses.readImages);
+            append(accesses.writtenImages, filterAccesses.writtenImages);
+            append(accesses.readBuffers, filterAccesses.readBuffers);
+            append(accesses.writtenBuffers, filterAccesses.writtenBuffers);
+        }
+
+        if (hazard(pending, accesses)) {
+            recordBarrier(commandBuffer, pending);
+            pending = {};
+        }
+        append(pending.readImages, accesses.readImages);
+        append(pending.writtenImages, accesses.writtenImages);
+        append(pending.readBuffers, accesses.readBuffers);
+        append(pending.writtenBuffers, accesses.writtenBuffers);
+
+        if (segment.fusedPasses[group]) {
+            segment.fusedPasses[group]->record(commandBuffer, m_frameIndex);
+        } else {
+            segment.computeFilters[first]->record(commandBuffer);
+        }
+
+        for (size_t i = first; i <= last; i++) {
+            frame.recordedCommandsVersions.push_back(segment.computeFilters[i]->commandsVersion());
+        }
+        first = last + 1;
+    }
+
+    commandBuffer.end();
+    frame.recordedFusionVersion = segment.fusionVersion;
+}
+
+vk::Semaphore Pipeline::run(std::optional<vk::Semaphore> waitSemaphore)
+{
+    SubmitSync sync;
+    if (waitSemaphore.has_value()) {
+        sync.waits.push_back({ waitSemaphore.value() });
+    }
+
+    vk::Semaphore finishedSemaphore = *m_finishedSemaphores[m_frameIndex];
+    sync.signals.push_back({ finishedSemaphore });
+    // the context timeline tells when resources used by this run can be freed
+    uint64_t value = context()->nextTimelineValue();
+    sync.signals.push_back({ context()->timelineSemaphore(), value });
+    submit(sync);
+    markSubmitted(value);
+    return finishedSemaphore;
+}
+
+uint64_t Pipeline::run(const std::vector<TimelinePoint>& waits, const std::vector<TimelinePoint>& signals)
+{
+    uint64_t value = context()->nextTimelineValue();
+    SubmitSync sync { waits, signals };
+    sync.signals.push_back({ context()->timelineSemaphore(), value });
+    submit(sync);
+    markSubmitted(value);
+    return value;
+}
+
+void Pipeline::markSubmitted(uint64_t timelineValue)
+{
+    m_submittedTimelineValue = timelineValue;
+    for (filters::Filter* filter : m_filters) {
+        filter->setSubmittedTimelineValue(timelineValue);
+    }
+}
+
+void Pipeline::submit(const SubmitSync& sync)
+{
+    if (m_filters.empty()) {
+        throw InvalidOperation("pipeline doesn't have any filters");
+    }
+
+    if (m_segmentsDirty) {
+        buildSegments();
+        m_segmentsDirty = false;
+    }
+
+    for (size_t segmentIndex = 0; segmentIndex < m_segments.size(); segmentIndex++) {
+        Segment& segment = m_segments[segmentIndex];
+        SegmentFrame& frame = segment.frames[m_frameIndex];
+
+        SubmitSync segmentSync;
+        if (segmentIndex == 0) {
+            segmentSync.waits = sync.waits;
+        } else {
+            segmentSync.waits.push_back({ *m_segments[segmentIndex - 1].frames[m_frameIndex].finishedSemaphore });
+        }
+
+        if (segmentIndex + 1 == m_segments.size()) {
+            segmentSync.signals = sync.signals;
+            segmentSync.fence = sync.fence;
+        } else {
+            segmentSync.signals.push_back({ *frame.finishedSemaphore });
+        }
+
+        if (segment.filter != nullptr) {
+            segment.filter->submit(segmentSync);
+            continue;
+        }
+
+        std::vector<std::optional<filters::PointwiseStage>> stages;
+        for (filters::ComputeFilter* filter : segment.computeFilters) {
+            filter->setFrameIndex(m_frameIndex);
+            filter->prepare();
+            stages.push_back(m_fusion ? filter->pointwiseStage() : std::nullopt);
+        }
+
+        updateFusedPasses(segment, stages);
+
+        bool recordDirty = frame.recordedFusionVersion != segment.fusionVersion
+            || frame.recordedCommandsVersions.size() != segment.computeFilters.size();
+        for (size_t i = 0; i < segment.computeFilters.size() && !recordDirty; i++) {
+            recordDirty = frame.recordedCommandsVersions[i] != segment.computeFilters[i]->commandsVersion();
+        }
+
+        if (recordDirty) {
+            recordSegment(segment, frame);
+        }
+
+        vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer;
+        segmentSync.submit(deviceContext(), deviceContext().queue, *frame.commandBuffer->get(), waitStage);
+    }
+
+    m_frameIndex = (m_frameIndex + 1) % m_framesInFlight;
+}
+
+}
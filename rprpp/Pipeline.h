@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ContextObject.h"
+#include "FusedPass.h"
+#include "SubmitSync.h"
+#include "filters/ComputeFilter.h"
+#include "filters/Filter.h"
+#include "vk/CommandBuffer.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace rprpp {
+
+// runs filters one after another. Consecutive compute filters are recorded back to back into a single command buffer
+// with barriers on the image passed between them, so they cost one submission. Filters that need a host round trip,
+// like the cpu denoiser, split the chain and are run on their own.
+// with fusion enabled adjacent pointwise filters are merged into one dispatch, their intermediate images aren't written.
+// filters aren't owned and have to outlive the pipeline, compute filters must have as many frames in flight as the pipeline.
+class Pipeline : public ContextObject {
+public:
+    explicit Pipeline(Context* context);
+
+    void addFilter(filters::Filter* filter);
+    void clear() noexcept;
+    void setFusion(bool fusion) noexcept;
+    bool getFusion() const noexcept;
+
+    // returns a binary semaphore of the pipeline's ring, it has to be waited before the ring comes around, the context timeline is signaled too
+    vk::Semaphore run(std::optional<vk::Semaphore> waitSemaphore);
+    // signals the context timeline semaphore and the binary semaphores of signals, returns the signaled timeline value
+    uint64_t run(const std::vector<TimelinePoint>& waits, const std::vector<TimelinePoint>& signals = {});
+    // the first segment waits and the last one signals exactly the semaphores of sync
+    void submit(const SubmitSync& sync);
+
+private:
+    struct SegmentFrame {
+        // null for host filters
+        std::unique_ptr<vk::helper::CommandBuffer> commandBuffer;
+        // waited by the next segment
+        vk::raii::Semaphore finishedSemaphore;
+        std::vector<uint64_t> recordedCommandsVersions;
+        uint64_t recordedFusionVersion = 0;
+    };
+
+    struct Segment {
+        // host filter, run on its own
+        filters::Filter* filter = nullptr;
+        std::vector<filters::ComputeFilter*> computeFilters;
+        // number of consecutive compute filters recorded as one dispatch, fusedPasses[i] is null for single filters
+        std::vector<size_t> groupSizes;
+        std::vector<std::unique_ptr<FusedPass>> fusedPasses;
+        // changes every time groups or fused passes change
+        uint64_t fusionVersion = 1;
+        std::vector<SegmentFrame> frames;
+    };
+
+    // segments replaced by buildSegments(), freed once the runs that used them have finished
+    struct RetiredSegments {
+        std::vector<Segment> segments;
+        uint64_t lastUse = 0;
+    };
+
+    void buildSegments();
+    [[nodiscard]] std::vector<size_t> fusionGroups(const std::vector<std::optional<filters::PointwiseStage>>& stages) const;
+    bool updateFusedPasses(Segment& segment, const std::vector<std::optional<filters::PointwiseStage>>& stages);
+    void recordSegment(Segment& segment, SegmentFrame& frame);
+    // lets the filters know which timeline value covers the run
+    void markSubmitted(uint64_t timelineValue);
+
+    bool m_segmentsDirty = true;
+    uint32_t m_framesInFlight;
+    uint32_t m_frameIndex = 0;
+    bool m_fusion = false;
+    std::vector<filters::Filter*> m_filters;
+    std::vector<Segment> m_segments;
+    std::vector<RetiredSegments> m_retiredSegments;
+    uint64_t m_submittedTimelineValue = 0;
+    std::vector<vk::raii::Semaphore> m_finishedSemaphores;
+};
+
+}
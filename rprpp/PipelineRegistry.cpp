@@ -0,0 +1,194 @@
+#include "PipelineRegistry.h"
+#include "Error.h"
+#include "vk/ShaderManager.h"
+
+#include <boost/log/trivial.hpp>
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+
+namespace rprpp {
+
+template <class T>
+static uint64_t handleValue(T handle)
+{
+    return std::bit_cast<uint64_t>(static_cast<typename T::CType>(handle));
+}
+
+template <class T>
+static void appendBytes(std::string& key, const T& value)
+{
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+PipelineRegistry::PipelineRegistry(Context* context)
+    : ContextObject(context)
+    , m_pipelineCache(deviceContext().device, vk::PipelineCacheCreateInfo())
+{
+}
+
+vk::DescriptorSetLayout PipelineRegistry::descriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+{
+    std::vector<uint32_t> key;
+    key.reserve(bindings.size() * 4);
+    for (const vk::DescriptorSetLayoutBinding& binding : bindings) {
+        if (binding.pImmutableSamplers != nullptr) {
+            throw InternalError("shared descriptor set layouts can't have immutable samplers");
+        }
+        key.insert(key.end(), { binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, static_cast<uint32_t>(binding.stageFlags) });
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_descriptorSetLayouts.find(key);
+    if (it == m_descriptorSetLayouts.end()) {
+        it = m_descriptorSetLayouts.emplace(std::move(key), deviceContext().device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, bindings))).first;
+    }
+
+    return *it->second;
+}
+
+vk::PipelineLayout PipelineRegistry::pipelineLayout(const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts,
+    const std::vector<vk::PushConstantRange>& pushConstantRanges)
+{
+    std::vector<uint64_t> key;
+    key.reserve(1 + descriptorSetLayouts.size() + pushConstantRanges.size() * 3);
+    key.push_back(descriptorSetLayouts.size());
+    for (vk::DescriptorSetLayout descriptorSetLayout : descriptorSetLayouts) {
+        key.push_back(handleValue(descriptorSetLayout));
+    }
+    for (const vk::PushConstantRange& range : pushConstantRanges) {
+        key.insert(key.end(), { static_cast<uint32_t>(range.stageFlags), range.offset, range.size });
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_pipelineLayouts.find(key);
+    if (it == m_pipelineLayouts.end()) {
+        vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, descriptorSetLayouts, pushConstantRanges);
+        it = m_pipelineLayouts.emplace(std::move(key), vk::raii::PipelineLayout(deviceContext().device, pipelineLayoutInfo)).first;
+    }
+
+    return *it->second;
+}
+
+vk::Pipeline PipelineRegistry::computePipeline(const std::string& variant,
+    vk::PipelineLayout layout,
+    const std::function<vk::raii::ShaderModule()>& createShaderModule,
+    const vk::SpecializationInfo* specializationInfo)
+{
+    std::string key = std::to_string(variant.size()) + ":" + variant;
+    appendBytes(key, handleValue(layout));
+    if (specializationInfo != nullptr) {
+        for (uint32_t i = 0; i < specializationInfo->mapEntryCount; i++) {
+            const vk::SpecializationMapEntry& entry = specializationInfo->pMapEntries[i];
+            appendBytes(key, entry.constantID);
+            appendBytes(key, entry.offset);
+            appendBytes(key, static_cast<uint64_t>(entry.size));
+        }
+        key.append(static_cast<const char*>(specializationInfo->pData), specializationInfo->dataSize);
+    }
+
+    // shaders of different pipelines are compiled in parallel, the same pipeline is created only once
+    std::shared_future<vk::Pipeline> pipeline;
+    std::optional<std::promise<vk::Pipeline>> creation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pipelines.find(key);
+        if (it == m_pipelines.end()) {
+            creation.emplace();
+            it = m_pipelines.emplace(key, creation->get_future().share()).first;
+        }
+        pipeline = it->second;
+    }
+
+    if (creation.has_value()) {
+        try {
+            vk::raii::ShaderModule shaderModule = createShaderModule();
+            vk::PipelineShaderStageCreateInfo shaderStageInfo({}, vk::ShaderStageFlagBits::eCompute, *shaderModule, "main", specializationInfo);
+            vk::ComputePipelineCreateInfo pipelineInfo({}, shaderStageInfo, layout);
+            std::shared_lock<std::shared_mutex> cacheLock(m_pipelineCacheMutex);
+            vk::raii::Pipeline createdPipeline = deviceContext().device.createComputePipeline(m_pipelineCache, pipelineInfo);
+            cacheLock.unlock();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ownedPipelines.push_back(std::move(createdPipeline));
+            creation->set_value(*m_ownedPipelines.back());
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_pipelines.erase(key);
+            }
+            creation->set_exception(std::current_exception());
+        }
+    }
+
+    return pipeline.get();
+}
+
+vk::Pipeline PipelineRegistry::computePipeline(const std::string& shaderName,
+    const std::unordered_map<std::string, std::string>& macroDefinitions,
+    vk::PipelineLayout layout,
+    const vk::SpecializationInfo* specializationInfo)
+{
+    return computePipeline(
+        vk::helper::ShaderManager::variantKey(shaderName, macroDefinitions),
+        layout,
+        [&] { return vk::helper::ShaderManager().getShader(deviceContext().device, shaderName, macroDefinitions); },
+        specializationInfo);
+}
+
+void PipelineRegistry::savePipelineCache(const std::filesystem::path& path) const
+{
+    std::vector<uint8_t> data;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_pipelineCacheMutex);
+        data = m_pipelineCache.getData();
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.close();
+    if (!file) {
+        throw InvalidParameter("path", "can't write pipeline cache to " + path.string());
+    }
+}
+
+void PipelineRegistry::loadPipelineCache(const std::filesystem::path& path)
+{
+    std::error_code error;
+    if (!std::filesystem::exists(path, error)) {
+        BOOST_LOG_TRIVIAL(info) << "PipelineRegistry: no pipeline cache at " << path.string();
+        return;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (file.bad()) {
+        throw InvalidParameter("path", "can't read pipeline cache from " + path.string());
+    }
+
+    // drivers ignore incompatible data on their own, the check only makes the reason visible
+    vk::PhysicalDeviceProperties properties = deviceContext().physicalDevice.getProperties();
+    VkPipelineCacheHeaderVersionOne header;
+    bool compatible = data.size() >= sizeof(header);
+    if (compatible) {
+        std::memcpy(&header, data.data(), sizeof(header));
+        compatible = header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == properties.vendorID
+            && header.deviceID == properties.deviceID
+            && std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+    }
+    if (!compatible) {
+        BOOST_LOG_TRIVIAL(info) << "PipelineRegistry: pipeline cache " << path.string() << " was saved by another device or driver";
+        return;
+    }
+
+    vk::raii::PipelineCache loadedCache(deviceContext().device, vk::PipelineCacheCreateInfo({}, data.size(), data.data()));
+    // merging needs the cache exclusively, pipelines are created through it by any thread
+    std::unique_lock<std::shared_mutex> lock(m_pipelineCacheMutex);
+    m_pipelineCache.merge(*loadedCache);
+}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ContextObject.h"
+
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rprpp {
+
+// descriptor set layouts, pipeline layouts and compute pipelines shared by all filters of a context.
+// equal layouts give the same handle, so every filter with the same shader variant and bindings gets the same pipeline.
+// everything lives as long as the context, pipelines are created through a pipeline cache that can be saved between processes
+class PipelineRegistry : public ContextObject {
+public:
+    explicit PipelineRegistry(Context* context);
+
+    // bindings must not have immutable samplers
+    [[nodiscard]] vk::DescriptorSetLayout descriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings);
+    [[nodiscard]] vk::PipelineLayout pipelineLayout(const std::vector<vk::DescriptorSetLayout>& descriptorSetLayouts,
+        const std::vector<vk::PushConstantRange>& pushConstantRanges = {});
+
+    // variant identifies the shader returned by createShaderModule, which is called only if there is no such pipeline yet.
+    // safe to call from any thread, a pipeline being created by another thread is waited for
+    [[nodiscard]] vk::Pipeline computePipeline(const std::string& variant,
+        vk::PipelineLayout layout,
+        const std::function<vk::raii::ShaderModule()>& createShaderModule,
+        const vk::SpecializationInfo* specializationInfo = nullptr);
+    // pipeline of a shader known to ShaderManager
+    [[nodiscard]] vk::Pipeline computePipeline(const std::string& shaderName,
+        const std::unordered_map<std::string, std::string>& macroDefinitions,
+        vk::PipelineLayout layout,
+        const vk::SpecializationInfo* specializationInfo = nullptr);
+
+    void savePipelineCache(const std::filesystem::path& path) const;
+    // merges a cache saved by savePipelineCache(), nothing is loaded if the file doesn't exist or was saved by another device or driver
+    void loadPipelineCache(const std::filesystem::path& path);
+
+private:
+    std::mutex m_mutex;
+    mutable std::shared_mutex m_pipelineCacheMutex;
+    vk::raii::PipelineCache m_pipelineCache;
+    std::map<std::vector<uint32_t>, vk::raii::DescriptorSetLayout> m_descriptorSetLayouts;
+    std::map<std::vector<uint64_t>, vk::raii::PipelineLayout> m_pipelineLayouts;
+    std::unordered_map<std::string, std::shared_future<vk::Pipeline>> m_pipelines;
+    std::vector<vk::raii::Pipeline> m_ownedPipelines;
+};
+
+}
@@ -0,0 +1,88 @@
+#include "Prewarmer.h"
+
+#include <boost/log/trivial.hpp>
+
+namespace rprpp {
+
+Prewarmer::Prewarmer(uint32_t threadCount)
+{
+    m_threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        m_threads.emplace_back([this](std::stop_token stopToken) { work(stopToken); });
+    }
+}
+
+Prewarmer::~Prewarmer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.clear();
+    }
+
+    for (std::jthread& thread : m_threads) {
+        thread.request_stop();
+    }
+    m_threads.clear();
+}
+
+void Prewarmer::submit(std::vector<filters::PrewarmTask> tasks)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (filters::PrewarmTask& task : tasks) {
+            m_tasks.push_back(std::move(task));
+        }
+    }
+
+    m_taskAvailable.notify_all();
+}
+
+bool Prewarmer::finished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tasks.empty() && m_runningTasks == 0;
+}
+
+void Prewarmer::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_tasksFinished.wait(lock, [this] { return m_tasks.empty() && m_runningTasks == 0; });
+
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void Prewarmer::work(std::stop_token stopToken)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_taskAvailable.wait(lock, stopToken, [this] { return !m_tasks.empty(); })) {
+        filters::PrewarmTask task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        m_runningTasks++;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (const std::exception& e) {
+            BOOST_LOG_TRIVIAL(error) << "Prewarmer: " << e.what();
+            error = std::current_exception();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        m_runningTasks--;
+        if (error && !m_error) {
+            m_error = error;
+        }
+        if (m_tasks.empty() && m_runningTasks == 0) {
+            m_tasksFinished.notify_all();
+        }
+    }
+}
+
+}
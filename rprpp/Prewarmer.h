@@ -0,0 +1,43 @@
+#pragma once
+
+#include "filters/ComputeFilter.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace rprpp {
+
+// runs prewarm tasks of filters on its own worker threads, so shaders are compiled and pipelines are created
+// in parallel and off the thread that runs filters. tasks left in the queue are dropped on destruction
+class Prewarmer : public boost::noncopyable {
+public:
+    explicit Prewarmer(uint32_t threadCount);
+    ~Prewarmer();
+
+    void submit(std::vector<filters::PrewarmTask> tasks);
+    // true if every submitted task has finished
+    [[nodiscard]] bool finished() const;
+    // waits for every submitted task and rethrows the first error since the previous wait
+    void wait();
+
+private:
+    void work(std::stop_token stopToken);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable_any m_taskAvailable;
+    std::condition_variable m_tasksFinished;
+    std::deque<filters::PrewarmTask> m_tasks;
+    size_t m_runningTasks = 0;
+    std::exception_ptr m_error;
+    // the last one, threads are stopped and joined before the rest is destroyed
+    std::vector<std::jthread> m_threads;
+};
+
+}
@@ -0,0 +1,124 @@
+#include "StagingRing.h"
+#include "Context.h"
+#include "Error.h"
+
+#include <algorithm>
+
+namespace rprpp {
+
+StagingRing::StagingRing(Context* context, vk::DeviceSize capacity)
+    : ContextObject(context)
+{
+    resize(capacity);
+}
+
+void StagingRing::resize(vk::DeviceSize capacity)
+{
+    while (!m_ranges.empty()) {
+        if (!m_ranges.front().fence) {
+            throw InvalidOperation("staging ring cannot grow while it has allocations that aren't retired");
+        }
+        releaseOldest(UINT64_MAX);
+    }
+
+    m_head = 0;
+    m_data = nullptr;
+    m_buffer.reset();
+
+    auto usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+    auto props = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+    // image uploads copy from the ring on the transfer queue
+    m_buffer = std::make_unique<Buffer>(context(), capacity, usage, props, false, true);
+    m_data = m_buffer->map(capacity);
+    m_capacity = capacity;
+}
+
+bool StagingRing::releaseOldest(uint64_t timeout)
+{
+    vk::Fence fence = m_ranges.front().fence;
+    if (deviceContext().device.waitForFences(fence, vk::True, timeout) != vk::Result::eSuccess) {
+        return false;
+    }
+
+    m_ranges.pop_front();
+    // ranges retired together are next to each other, the fence is free after the last of them
+    if (m_ranges.empty() || m_ranges.front().fence != fence) {
+        deviceContext().device.resetFences(fence);
+        m_freeFences.push_back(fence);
+    }
+
+    return true;
+}
+
+bool StagingRing::overlaps(vk::DeviceSize begin, vk::DeviceSize end) const noexcept
+{
+    for (const Range& range : m_ranges) {
+        if (begin < range.end && range.begin < end) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+StagingRing::Allocation StagingRing::allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+{
+    if (size > m_capacity) {
+        resize(std::max(size, m_capacity * 2));
+    }
+
+    while (!m_ranges.empty() && m_ranges.front().fence && releaseOldest(0)) {
+    }
+
+    // back-pressure: the host doesn't run further ahead of the device than the frames in flight allow
+    while (m_fences.size() - m_freeFences.size() >= context()->framesInFlight() && m_ranges.front().fence) {
+        releaseOldest(UINT64_MAX);
+    }
+
+    vk::DeviceSize offset = (m_head + alignment - 1) / alignment * alignment;
+    if (offset + size > m_capacity) {
+        offset = 0;
+    }
+
+    // the ring is filled in order, so the oldest allocations are the ones in the way
+    while (overlaps(offset, offset + size)) {
+        if (!m_ranges.front().fence) {
+            throw InvalidOperation("staging ring is too small for allocations that aren't retired");
+        }
+        releaseOldest(UINT64_MAX);
+    }
+
+    m_ranges.push_back({ offset, offset + size, nullptr });
+    m_head = offset + size;
+    return { m_buffer->get(), offset, static_cast<uint8_t*>(m_data) + offset };
+}
+
+vk::Fence StagingRing::retire()
+{
+    if (m_ranges.empty() || m_ranges.back().fence) {
+        return nullptr;
+    }
+
+    if (m_freeFences.empty()) {
+        m_fences.push_back(deviceContext().device.createFence({}));
+        m_freeFences.push_back(*m_fences.back());
+    }
+
+    vk::Fence fence = m_freeFences.back();
+    m_freeFences.pop_back();
+    for (auto it = m_ranges.rbegin(); it != m_ranges.rend() && !it->fence; ++it) {
+        it->fence = fence;
+    }
+
+    return fence;
+}
+
+void StagingRing::abandon() noexcept
+{
+    while (!m_ranges.empty() && !m_ranges.back().fence) {
+        m_ranges.pop_back();
+    }
+    m_head = m_ranges.empty() ? 0 : m_ranges.back().end;
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Buffer.h"
+#include "ContextObject.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace rprpp {
+
+// host visible buffer mapped once and sub-allocated in a ring, sized for a few frames in flight.
+// allocations are reused once the fence returned by the retire() after them is signaled.
+// an allocation that is neither retired nor abandoned is retired by the next retire() of any user,
+// until then the ring can't reuse the space after it nor grow
+class StagingRing : public ContextObject {
+public:
+    struct Allocation {
+        vk::Buffer buffer;
+        vk::DeviceSize offset;
+        void* data;
+    };
+
+    explicit StagingRing(Context* context, vk::DeviceSize capacity);
+
+    // waits for retired allocations if the ring is full or frames in flight retires are pending, grows if size doesn't fit at all
+    [[nodiscard]] Allocation allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+    // every allocation since the previous retire() is in use until the returned fence is signaled,
+    // it has to be passed to the submission reading or writing them. Null if there is nothing to retire
+    [[nodiscard]] vk::Fence retire();
+    // drops the allocations since the previous retire() when nothing is going to use them, e.g. recording has failed
+    void abandon() noexcept;
+
+    [[nodiscard]] vk::DeviceSize capacity() const noexcept { return m_capacity; }
+
+private:
+    struct Range {
+        vk::DeviceSize begin;
+        vk::DeviceSize end;
+        vk::Fence fence;
+    };
+
+    void resize(vk::DeviceSize capacity);
+    // returns false if timeout expired
+    bool releaseOldest(uint64_t timeout);
+    [[nodiscard]] bool overlaps(vk::DeviceSize begin, vk::DeviceSize end) const noexcept;
+
+    vk::DeviceSize m_capacity = 0;
+    vk::DeviceSize m_head = 0;
+    std::unique_ptr<Buffer> m_buffer;
+    void* m_data = nullptr;
+    std::deque<Range> m_ranges;
+    std::vector<vk::raii::Fence> m_fences;
+    std::vector<vk::Fence> m_freeFences;
+};
+
+}
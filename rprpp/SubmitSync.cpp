@@ -0,0 +1,29 @@
+#include "SubmitSync.h"
+#include "vk/DeviceContext.h"
+
+namespace rprpp {
+
+void SubmitSync::submit(const vk::helper::DeviceContext& deviceContext, const vk::raii::Queue& queue, vk::ArrayProxy<const vk::CommandBuffer> commandBuffers, vk::PipelineStageFlags waitStage) const
+{
+    std::vector<vk::Semaphore> waitSemaphores;
+    std::vector<uint64_t> waitValues;
+    std::vector<vk::PipelineStageFlags> waitStages;
+    for (const TimelinePoint& wait : waits) {
+        waitSemaphores.push_back(wait.semaphore);
+        waitValues.push_back(wait.value);
+        waitStages.push_back(waitStage);
+    }
+
+    std::vector<vk::Semaphore> signalSemaphores;
+    std::vector<uint64_t> signalValues;
+    for (const TimelinePoint& signal : signals) {
+        signalSemaphores.push_back(signal.semaphore);
+        signalValues.push_back(signal.value);
+    }
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo(waitValues, signalValues);
+    vk::SubmitInfo submitInfo(waitSemaphores, waitStages, commandBuffers, signalSemaphores, &timelineInfo);
+    deviceContext.submit(queue, submitInfo, fence);
+}
+
+}
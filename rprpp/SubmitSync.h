@@ -0,0 +1,29 @@
+#pragma once
+
+#include "vk/vk.h"
+
+#include <vector>
+
+namespace vk::helper {
+struct DeviceContext;
+}
+
+namespace rprpp {
+
+// value is ignored for binary semaphores
+struct TimelinePoint {
+    vk::Semaphore semaphore;
+    uint64_t value = 0;
+};
+
+// semaphores waited and signaled by a single queue submission
+struct SubmitSync {
+    std::vector<TimelinePoint> waits;
+    std::vector<TimelinePoint> signals;
+    // optional, signaled with the semaphores
+    vk::Fence fence = nullptr;
+
+    void submit(const vk::helper::DeviceContext& deviceContext, const vk::raii::Queue& queue, vk::ArrayProxy<const vk::CommandBuffer> commandBuffers, vk::PipelineStageFlags waitStage) const;
+};
+
+}
@@ -0,0 +1,81 @@
+#include "TransientHeap.h"
+#include "Context.h"
+
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+
+namespace rprpp {
+
+// the heap is sub-allocated, aligning it to a large page keeps the alignment of every buffer bound at an aligned offset
+constexpr vk::DeviceSize MinAlignment = 64 * 1024;
+
+TransientBuffer::TransientBuffer(const TransientHeap* heap, std::shared_ptr<MemoryAllocation> memory, vk::raii::Buffer&& buffer, size_t size)
+    : m_heap(heap)
+    , m_memory(std::move(memory))
+    , m_buffer(std::move(buffer))
+    , m_size(size)
+{
+}
+
+bool TransientBuffer::valid() const noexcept
+{
+    return m_memory == m_heap->m_memory;
+}
+
+TransientHeap::TransientHeap(Context* context)
+    : ContextObject(context)
+{
+}
+
+std::vector<std::unique_ptr<TransientBuffer>> TransientHeap::createBuffers(const std::vector<TransientBufferInfo>& infos)
+{
+    const vk::helper::DeviceContext& dctx = deviceContext();
+    std::vector<vk::raii::Buffer> buffers;
+    std::vector<vk::DeviceSize> offsets;
+    vk::DeviceSize end = 0;
+    vk::DeviceSize alignment = MinAlignment;
+    uint32_t memoryTypeBits = ~0u;
+    buffers.reserve(infos.size());
+    offsets.reserve(infos.size());
+    for (const TransientBufferInfo& info : infos) {
+        buffers.emplace_back(dctx.device, vk::BufferCreateInfo({}, info.size, info.usage, vk::SharingMode::eExclusive));
+        vk::MemoryRequirements requirements = buffers.back().getMemoryRequirements();
+        vk::DeviceSize offset = (end + requirements.alignment - 1) & ~(requirements.alignment - 1);
+        offsets.push_back(offset);
+        end = offset + requirements.size;
+        alignment = std::max(alignment, requirements.alignment);
+        memoryTypeBits &= requirements.memoryTypeBits;
+    }
+
+    bool fits = m_memory && end <= m_memory->size() && alignment <= m_alignment && (memoryTypeBits & (1u << m_memoryType)) != 0;
+    if (!fits) {
+        // buffers bound to the previous memory keep it alive until their filters create them again
+        m_memoryType = vk::helper::findMemoryType(dctx.physicalDevice, memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+        vk::MemoryRequirements requirements(std::max(end, size()), std::max(alignment, m_alignment), 1u << m_memoryType);
+        m_memory = std::make_shared<MemoryAllocation>(context()->memoryAllocator().allocate(requirements, vk::MemoryPropertyFlagBits::eDeviceLocal, true));
+        m_alignment = requirements.alignment;
+        BOOST_LOG_TRIVIAL(info) << "TransientHeap: size " << requirements.size << " bytes";
+    }
+
+    std::vector<std::unique_ptr<TransientBuffer>> result;
+    result.reserve(infos.size());
+    for (size_t i = 0; i < infos.size(); i++) {
+        buffers[i].bindMemory(m_memory->memory(), m_memory->offset() + offsets[i]);
+        result.emplace_back(new TransientBuffer(this, m_memory, std::move(buffers[i]), infos[i].size));
+    }
+
+    return result;
+}
+
+void TransientHeap::barrier(const vk::raii::CommandBuffer& commandBuffer)
+{
+    // the heap is written by compute shaders and transfer clears of whichever filter ran before
+    vk::MemoryBarrier memoryBarrier(
+        vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite);
+    vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer;
+    commandBuffer.pipelineBarrier(stages, stages, {}, memoryBarrier, nullptr, nullptr);
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ContextObject.h"
+#include "MemoryAllocator.h"
+
+#include <memory>
+#include <vector>
+
+namespace rprpp {
+
+class TransientHeap;
+
+struct TransientBufferInfo {
+    vk::DeviceSize size;
+    vk::BufferUsageFlags usage;
+};
+
+// scratch buffer of a filter, its contents are undefined outside of the commands recorded by the filter
+class TransientBuffer : public boost::noncopyable {
+public:
+    [[nodiscard]] vk::Buffer get() const noexcept { return *m_buffer; }
+    [[nodiscard]] size_t size() const noexcept { return m_size; }
+    // false once the heap has moved to a larger memory, the buffer has to be created again to alias the others
+    [[nodiscard]] bool valid() const noexcept;
+
+private:
+    friend class TransientHeap;
+    TransientBuffer(const TransientHeap* heap, std::shared_ptr<MemoryAllocation> memory, vk::raii::Buffer&& buffer, size_t size);
+
+    const TransientHeap* m_heap;
+    // keeps the memory alive while the buffer is bound to it
+    std::shared_ptr<MemoryAllocation> m_memory;
+    vk::raii::Buffer m_buffer;
+    size_t m_size;
+};
+
+// device local memory shared by scratch buffers of all filters.
+// filters submit to one queue and don't overlap, so scratch of different filters aliases the same memory,
+// every filter has to record barrier() before it touches its scratch
+class TransientHeap : public ContextObject {
+public:
+    explicit TransientHeap(Context* context);
+
+    // buffers of one filter don't overlap each other, they start at the beginning of the heap
+    [[nodiscard]] std::vector<std::unique_ptr<TransientBuffer>> createBuffers(const std::vector<TransientBufferInfo>& infos);
+
+    // makes the previous writes to the heap by any filter available and orders them before the following access
+    static void barrier(const vk::raii::CommandBuffer& commandBuffer);
+
+    [[nodiscard]] vk::DeviceSize size() const noexcept { return m_memory ? m_memory->size() : 0; }
+
+private:
+    friend class TransientBuffer;
+
+    std::shared_ptr<MemoryAllocation> m_memory;
+    uint32_t m_memoryType = 0;
+    vk::DeviceSize m_alignment = 0;
+};
+
+}
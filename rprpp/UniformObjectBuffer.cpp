@@ -0,0 +1,11 @@
+#include "UniformObjectBuffer.h"
+#include "Context.h"
+
+namespace rprpp {
+
+vk::DeviceSize uniformBufferOffsetAlignment(Context* context)
+{
+    return context->deviceContext().physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment;
+}
+
+}
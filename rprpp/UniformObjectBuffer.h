@@ -2,51 +2,72 @@
 
 #include "Buffer.h"
 
+#include <cstring>
+#include <vector>
+
 namespace rprpp {
 
 class Context;
 
+// minUniformBufferOffsetAlignment of the context device
+vk::DeviceSize uniformBufferOffsetAlignment(Context* context);
+
+// one copy of T per frame in flight, bound as a dynamic uniform buffer.
+// a change is written to the copy of each frame right before that frame uses it
 template <class T>
 class UniformObjectBuffer {
 public:
-    explicit UniformObjectBuffer(Context* context);
+    explicit UniformObjectBuffer(Context* context, uint32_t framesInFlight = 1);
 
     T& data() noexcept;
     const T& data() const noexcept;
 
+    // size of a single copy, it's the range of the descriptor
     [[nodiscard]] size_t size() const noexcept;
 
     [[nodiscard]] vk::Buffer buffer() const noexcept;
 
-    [[nodiscard]] bool dirty() const noexcept;
+    // dynamic offset of the copy used by the frame
+    [[nodiscard]] uint32_t offset(uint32_t frameIndex) const noexcept;
+
+    [[nodiscard]] uint32_t stride() const noexcept;
+
+    [[nodiscard]] bool dirty(uint32_t frameIndex) const noexcept;
     void markDirty() noexcept;
 
-    void update();
+    void update(uint32_t frameIndex);
 
     UniformObjectBuffer(const Buffer&) = delete;
     UniformObjectBuffer& operator=(const Buffer&) = delete;
 
 private:
-    Buffer createBuffer(Context* context);
+    static size_t alignedSize(Context* context);
 
-    bool m_dirty;
     T m_data;
+    size_t m_stride;
+    uint64_t m_version = 1;
+    std::vector<uint64_t> m_frameVersions;
     Buffer m_buffer;
+    // the buffer stays mapped while it exists
+    uint8_t* m_mapped;
 };
 
 template <class T>
-Buffer UniformObjectBuffer<T>::createBuffer(Context* context)
+size_t UniformObjectBuffer<T>::alignedSize(Context* context)
 {
-    return Buffer(context,
-        sizeof(T),
-        vk::BufferUsageFlagBits::eUniformBuffer,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+    vk::DeviceSize alignment = uniformBufferOffsetAlignment(context);
+    return (sizeof(T) + alignment - 1) / alignment * alignment;
 }
 
 template <class T>
-UniformObjectBuffer<T>::UniformObjectBuffer(Context* context)
-    : m_buffer(createBuffer(context))
-    , m_dirty(true)
+UniformObjectBuffer<T>::UniformObjectBuffer(Context* context, uint32_t framesInFlight)
+    : m_stride(alignedSize(context))
+    , m_frameVersions(framesInFlight, 0)
+    , m_buffer(context,
+          m_stride * framesInFlight,
+          vk::BufferUsageFlagBits::eUniformBuffer,
+          vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
+    , m_mapped(static_cast<uint8_t*>(m_buffer.map(m_buffer.size())))
 {
 }
 
@@ -63,15 +84,15 @@ const T& UniformObjectBuffer<T>::data() const noexcept
 }
 
 template <class T>
-bool UniformObjectBuffer<T>::dirty() const noexcept
+bool UniformObjectBuffer<T>::dirty(uint32_t frameIndex) const noexcept
 {
-    return m_dirty;
+    return m_frameVersions[frameIndex] != m_version;
 }
 
 template <class T>
 size_t UniformObjectBuffer<T>::size() const noexcept
 {
-    return m_buffer.size();
+    return sizeof(T);
 }
 
 template <class T>
@@ -81,18 +102,28 @@ vk::Buffer UniformObjectBuffer<T>::buffer() const noexcept
 }
 
 template <class T>
-void UniformObjectBuffer<T>::update()
+uint32_t UniformObjectBuffer<T>::offset(uint32_t frameIndex) const noexcept
 {
-    void* data = m_buffer.map(sizeof(T));
-    std::memcpy(data, &m_data, sizeof(T));
-    m_buffer.unmap();
-    m_dirty = false;
+    return static_cast<uint32_t>(frameIndex * m_stride);
+}
+
+template <class T>
+uint32_t UniformObjectBuffer<T>::stride() const noexcept
+{
+    return static_cast<uint32_t>(m_stride);
+}
+
+template <class T>
+void UniformObjectBuffer<T>::update(uint32_t frameIndex)
+{
+    std::memcpy(m_mapped + offset(frameIndex), &m_data, sizeof(T));
+    m_frameVersions[frameIndex] = m_version;
 }
 
 template <class T>
 void UniformObjectBuffer<T>::markDirty() noexcept
 {
-    m_dirty = true;
+    m_version++;
 }
 
-}
\ No newline at end of file
+}
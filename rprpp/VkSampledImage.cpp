@@ -37,6 +37,12 @@ vk::raii::ImageView VkSampledImage::createImageView(Context* context, vk::Image
     return (m_usage & vk::ImageUsageFlagBits::eSampled) == vk::ImageUsageFlagBits::eSampled;
 }
 
+[[nodiscard]] bool VkSampledImage::IsConcurrent() const
+{
+    // sharing mode of the external image is unknown
+    return false;
+}
+
 const ImageDescription& VkSampledImage::description() const
 {
     return m_description;
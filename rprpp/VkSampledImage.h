@@ -13,6 +13,8 @@ public:
 
     [[nodiscard]] bool IsSampled() const override;
 
+    [[nodiscard]] bool IsConcurrent() const override;
+
     [[nodiscard]] const ImageDescription& description() const override;
 
     [[nodiscard]] const vk::raii::ImageView& view() const override;
@@ -5,7 +5,28 @@
 #include "rprpp/rprpp.h"
 #include "rprpp/vk/DescriptorBuilder.h"
 
+#include <array>
+#include <bit>
+#include <complex>
+#include <numbers>
+
+#include <boost/log/trivial.hpp>
+
 constexpr int WorkgroupSize = 1024;
+// horizontal tiled pass processes a row segment per workgroup,
+// vertical one processes a narrow column strip so global loads stay coalesced
+constexpr int TiledHorizontalTileSize = 256;
+constexpr int TiledHorizontalTileLines = 1;
+constexpr int TiledVerticalTileSize = 32;
+constexpr int TiledVerticalTileLines = 8;
+constexpr uint32_t MaxKernelCacheSize = 4096;
+static_assert(TiledHorizontalTileSize * TiledHorizontalTileLines == TiledVerticalTileSize * TiledVerticalTileLines);
+constexpr int PyramidWorkgroupSize = 16;
+constexpr int ResampleWorkgroupSize = 16;
+constexpr int FftWorkgroupSize = 256;
+// rough estimate: tiled convolution costs 2R+1 shared memory taps per pixel and axis,
+// fft costs 2*log2(N) global memory round trips, bloombench measures the crossover of a device
+constexpr uint32_t DefaultFftCrossoverKernelRadius = 512;
 
 namespace rprpp::filters {
 
@@ -22,11 +43,60 @@ static int gaussianKernelDataSize(const ImageDescription& description, float rad
     return kernelCenterOffset * 2 + 1;
 }
 
+// padded line length, so circular convolution of the line matches the linear one
+static uint32_t fftSize(uint32_t length, int kernelRadius)
+{
+    uint32_t taps = std::min(uint32_t(kernelRadius), length - 1);
+    return std::max(2u, std::bit_ceil(length + taps));
+}
+
+// in-place iterative radix-2 fft, data size has to be a power of two
+static void fft(std::vector<std::complex<double>>& data)
+{
+    size_t n = data.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (size_t length = 2; length <= n; length <<= 1) {
+        double angle = -2.0 * std::numbers::pi / double(length);
+        std::complex<double> lengthTwiddle(cos(angle), sin(angle));
+        for (size_t i = 0; i < n; i += length) {
+            std::complex<double> twiddle(1.0);
+            for (size_t j = 0; j < length / 2; j++) {
+                std::complex<double> u = data[i + j];
+                std::complex<double> v = data[i + j + length / 2] * twiddle;
+                data[i + j] = u + v;
+                data[i + j + length / 2] = u - v;
+                twiddle *= lengthTwiddle;
+            }
+        }
+    }
+}
+
+static uint32_t kernelCacheSize(const vk::raii::PhysicalDevice& physicalDevice)
+{
+    uint32_t sharedMemorySize = physicalDevice.getProperties().limits.maxComputeSharedMemorySize;
+    uint32_t tileSizeInBytes = TiledHorizontalTileSize * TiledHorizontalTileLines * 4 * sizeof(float);
+    // a power of two, so it's one of the sizes precompiled by shaders/variants.cmake,
+    // the 16 KiB of shared memory guaranteed by vulkan give 2048
+    return std::bit_floor(std::min(MaxKernelCacheSize, (sharedMemorySize - tileSizeInBytes) / uint32_t(sizeof(float))));
+}
+
 BloomFilter::BloomFilter(Context* context) noexcept
-    : Filter(context)
-    , m_finishedSemaphore(deviceContext().device.createSemaphore({}))
-    , m_ubo(UniformObjectBuffer<filters::BloomParams>(context))
-    , m_commandBuffer(&deviceContext())
+    : ComputeFilter(context)
+    , m_kernelCacheSize(kernelCacheSize(deviceContext().physicalDevice))
+    , m_fftCrossoverRadius(DefaultFftCrossoverKernelRadius)
+    , m_ubo(context, framesInFlight())
+    , m_kernelFrameVersions(framesInFlight(), 0)
+    , m_descriptorSets(context, framesInFlight())
 {
 }
 
@@ -50,33 +120,114 @@ void BloomFilter::validateInputsAndOutput()
     }
 }
 
-void BloomFilter::createShaderModules()
+std::vector<BloomFilter::PipelineShader> BloomFilter::pipelineShaders(const PipelineState& state, bool halfPrecision, uint32_t kernelCacheSize)
 {
+    auto [mode, fftConvolution, resampled, format] = state;
+    std::vector<PipelineShader> shaders;
+
+    // input and output have the same description
     std::unordered_map<std::string, std::string> macroDefinitions = {
-        { "OUTPUT_FORMAT", to_glslformat(m_output->description().format) },
-        { "INPUT_FORMAT", to_glslformat(m_input->description().format) },
+        { "OUTPUT_FORMAT", to_glslformat(format) },
+        { "INPUT_FORMAT", to_glslformat(format) },
         { "WORKGROUP_SIZE", std::to_string(WorkgroupSize) },
     };
-    m_thresholdShaderModule = m_shaderManager.getBloomThresholdShader(deviceContext().device, macroDefinitions);
+    if (halfPrecision) {
+        macroDefinitions["HALF_PRECISION"] = "";
+    }
+
+    if (mode == BloomMode::ePyramid) {
+        macroDefinitions["WORKGROUP_SIZE"] = std::to_string(PyramidWorkgroupSize);
+        macroDefinitions["DOWNSAMPLE"] = "";
+        shaders.push_back({ &BloomFilter::m_pyramidDownsampleComputePipeline, "bloom_pyramid", macroDefinitions });
+        macroDefinitions.erase("DOWNSAMPLE");
+        macroDefinitions["UPSAMPLE"] = "";
+        shaders.push_back({ &BloomFilter::m_pyramidUpsampleComputePipeline, "bloom_pyramid", macroDefinitions });
+        macroDefinitions.erase("UPSAMPLE");
+        macroDefinitions["COMPOSITE"] = "";
+        shaders.push_back({ &BloomFilter::m_pyramidCompositeComputePipeline, "bloom_pyramid", macroDefinitions });
+        return shaders;
+    }
 
 #if defined(USE_2D_CONVOLUTION)
-    m_convolve2dShaderModule = m_shaderManager.getBloomConvolve2dShader(deviceContext().device, macroDefinitions);
+    (void)fftConvolution;
+    (void)resampled;
+    (void)kernelCacheSize;
+    shaders.push_back({ &BloomFilter::m_convolve2dComputePipeline, "bloom_convolve2d", macroDefinitions });
 #else
-    m_convolve1dVerticalShaderModule = m_shaderManager.getBloomConvolve1dShader(deviceContext().device, macroDefinitions);
-    macroDefinitions["HORIZONTAL"] = "";
-    m_convolve1dHorizontalShaderModule = m_shaderManager.getBloomConvolve1dShader(deviceContext().device, macroDefinitions);
+    if (resampled) {
+        std::unordered_map<std::string, std::string> resampleMacroDefinitions = macroDefinitions;
+        resampleMacroDefinitions["WORKGROUP_SIZE"] = std::to_string(ResampleWorkgroupSize);
+        resampleMacroDefinitions["DOWNSAMPLE"] = "";
+        shaders.push_back({ &BloomFilter::m_resampleDownsampleComputePipeline, "bloom_resample", resampleMacroDefinitions });
+        resampleMacroDefinitions.erase("DOWNSAMPLE");
+        resampleMacroDefinitions["COMPOSITE"] = "";
+        shaders.push_back({ &BloomFilter::m_resampleCompositeComputePipeline, "bloom_resample", resampleMacroDefinitions });
+        macroDefinitions["DOWNSCALED"] = "";
+    }
+
+    if (fftConvolution) {
+        macroDefinitions["WORKGROUP_SIZE"] = std::to_string(FftWorkgroupSize);
+        shaders.push_back({ &BloomFilter::m_fftVerticalComputePipeline, "bloom_fft", macroDefinitions });
+        macroDefinitions["HORIZONTAL"] = "";
+        shaders.push_back({ &BloomFilter::m_fftHorizontalComputePipeline, "bloom_fft", macroDefinitions });
+        return shaders;
+    }
+
+    // the naive convolution always reads the resampled input
+    if (resampled) {
+        shaders.push_back({ &BloomFilter::m_convolve1dVerticalComputePipeline, "bloom_convolve1d", macroDefinitions });
+        macroDefinitions["HORIZONTAL"] = "";
+        shaders.push_back({ &BloomFilter::m_convolve1dHorizontalComputePipeline, "bloom_convolve1d", macroDefinitions });
+    }
+
+    std::unordered_map<std::string, std::string> tiledMacroDefinitions = {
+        { "OUTPUT_FORMAT", to_glslformat(format) },
+        { "INPUT_FORMAT", to_glslformat(format) },
+        { "TILE_SIZE", std::to_string(TiledVerticalTileSize) },
+        { "TILE_LINES", std::to_string(TiledVerticalTileLines) },
+        { "KERNEL_CACHE_SIZE", std::to_string(kernelCacheSize) },
+    };
+    if (halfPrecision) {
+        tiledMacroDefinitions["HALF_PRECISION"] = "";
+    }
+    if (resampled) {
+        tiledMacroDefinitions["DOWNSCALED"] = "";
+    }
+    shaders.push_back({ &BloomFilter::m_convolve1dTiledVerticalComputePipeline, "bloom_convolve1d_tiled", tiledMacroDefinitions });
+    tiledMacroDefinitions["TILE_SIZE"] = std::to_string(TiledHorizontalTileSize);
+    tiledMacroDefinitions["TILE_LINES"] = std::to_string(TiledHorizontalTileLines);
+    tiledMacroDefinitions["HORIZONTAL"] = "";
+    shaders.push_back({ &BloomFilter::m_convolve1dTiledHorizontalComputePipeline, "bloom_convolve1d_tiled", tiledMacroDefinitions });
 #endif
+
+    return shaders;
+}
+
+vk::PipelineLayout BloomFilter::pipelineLayout(PipelineRegistry& registry, vk::DescriptorSetLayout descriptorSetLayout)
+{
+    vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, std::max(sizeof(BloomPyramidLevel), sizeof(BloomFftStage)));
+    return registry.pipelineLayout({ descriptorSetLayout }, { pushConstantRange });
+}
+
+void BloomFilter::createComputePipelines()
+{
+    PipelineRegistry& registry = context()->pipelineRegistry();
+    m_pipelineLayout = pipelineLayout(registry, m_descriptorSetLayout);
+    m_pipelineState = pipelineState();
+
+    for (const PipelineShader& shader : pipelineShaders(m_pipelineState.value(), deviceContext().supportHalfPrecision, m_kernelCacheSize)) {
+        this->*shader.pipeline = registry.computePipeline(shader.shaderName, shader.macroDefinitions, m_pipelineLayout);
+    }
 }
 
 void BloomFilter::createDescriptorSet()
 {
-    assert(m_threshold);
     assert(m_kernelData);
     assert(m_tmpBuffer);
 
     vk::helper::DescriptorBuilder builder;
     vk::DescriptorBufferInfo uboDescriptorInfo(m_ubo.buffer(), 0, m_ubo.size()); // binding 0
-    builder.bindUniformBuffer(&uboDescriptorInfo);
+    builder.bindDynamicUniformBuffer(&uboDescriptorInfo);
 
     vk::DescriptorBufferInfo kernelDataDescriptorInfo(m_kernelData->get(), 0, m_kernelData->size()); // binding 1
     builder.bindStorageBuffer(&kernelDataDescriptorInfo);
@@ -84,111 +235,309 @@ void BloomFilter::createDescriptorSet()
     vk::DescriptorBufferInfo tmpBufferDescriptorInfo(m_tmpBuffer->get(), 0, m_tmpBuffer->size()); // binding 2
     builder.bindStorageBuffer(&tmpBufferDescriptorInfo);
 
-    vk::DescriptorBufferInfo thresholdDescriptorInfo(m_threshold->get(), 0, m_threshold->size()); // binding 3
-    builder.bindStorageBuffer(&thresholdDescriptorInfo);
-
-    vk::DescriptorImageInfo outputDescriptorInfo(nullptr, *m_output->view(), m_output->layout()); // binding 4
+    vk::DescriptorImageInfo outputDescriptorInfo(nullptr, *m_output->view(), m_output->layout()); // binding 3
     builder.bindStorageImage(&outputDescriptorInfo);
 
-    vk::DescriptorImageInfo inputDescriptorInfo(nullptr, *m_input->view(), m_input->layout()); // binding 5
+    vk::DescriptorImageInfo inputDescriptorInfo(nullptr, *m_input->view(), m_input->layout()); // binding 4
     builder.bindStorageImage(&inputDescriptorInfo);
 
-    const std::vector<vk::DescriptorPoolSize>& poolSizes = builder.poolSizes();
-    m_descriptorSetLayout = deviceContext().device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, builder.bindings()));
-    m_descriptorPool = deviceContext().device.createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, 1, poolSizes));
-    m_descriptorSet = std::move(vk::raii::DescriptorSets(deviceContext().device, vk::DescriptorSetAllocateInfo(*m_descriptorPool.value(), *m_descriptorSetLayout.value())).front());
+    std::optional<vk::DescriptorBufferInfo> fftBufferDescriptorInfo;
+    if (m_fftBuffer) {
+        fftBufferDescriptorInfo = vk::DescriptorBufferInfo(m_fftBuffer->get(), 0, m_fftBuffer->size()); // binding 5
+        builder.bindStorageBuffer(&fftBufferDescriptorInfo.value());
+    }
+
+    // buffers don't change between sets, the cache is cleared when one of them is recreated
+    m_descriptorSetLayout = context()->pipelineRegistry().descriptorSetLayout(builder.bindings());
+    m_descriptorSet = m_descriptorSets.get({ m_output->tag(), m_input->tag() }, m_descriptorSetLayout, builder);
+}
 
-    builder.updateDescriptorSet(*m_descriptorSet.value());
-    deviceContext().device.updateDescriptorSets(builder.writes(), nullptr);
+void BloomFilter::record(const vk::raii::CommandBuffer& commandBuffer)
+{
+    TransientHeap::barrier(commandBuffer);
+    if (m_mode == BloomMode::ePyramid) {
+        recordPyramidCommands(commandBuffer);
+    } else {
+        recordConvolutionCommands(commandBuffer);
+    }
 }
 
-void BloomFilter::recordComputeCommandBuffers()
+void BloomFilter::recordConvolutionCommands(const vk::raii::CommandBuffer& commandBuffer)
 {
-    uint32_t pixelsCount = m_output->description().width * m_output->description().height;
+    ImageDescription description = convolutionDescription();
+    uint32_t width = description.width;
+    uint32_t height = description.height;
+    uint32_t pixelsCount = width * height;
+    bool resampled = resampledConvolution();
+
+    vk::BufferMemoryBarrier tmpBufferBarrier(
+        vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        m_tmpBuffer->get(),
+        0,
+        m_tmpBuffer->size());
 
-    m_commandBuffer.get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
     {
-        m_commandBuffer.get().bindPipeline(vk::PipelineBindPoint::eCompute, *m_thresholdComputePipeline.value());
-        m_commandBuffer.get().bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipelineLayout.value(), 0, *m_descriptorSet.value(), nullptr);
-        m_commandBuffer.get().dispatch((uint32_t)ceil(pixelsCount / float(WorkgroupSize)), 1, 1);
+#if defined(USE_2D_CONVOLUTION)
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_convolve2dComputePipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+        commandBuffer.dispatch((uint32_t)ceil(pixelsCount / float(WorkgroupSize)), 1, 1);
+#else
+        if (resampled) {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_resampleDownsampleComputePipeline);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+            commandBuffer.dispatch((uint32_t)ceil(width / float(ResampleWorkgroupSize)), (uint32_t)ceil(height / float(ResampleWorkgroupSize)), 1);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, tmpBufferBarrier, nullptr);
+        }
+
+        if (m_fftConvolution) {
+            recordFftConvolutionCommands(commandBuffer);
+        } else if (m_tiledConvolution) {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_convolve1dTiledVerticalComputePipeline);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+            commandBuffer.dispatch((uint32_t)ceil(width / float(TiledVerticalTileLines)), (uint32_t)ceil(height / float(TiledVerticalTileSize)), 1);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, tmpBufferBarrier, nullptr);
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_convolve1dTiledHorizontalComputePipeline);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+            commandBuffer.dispatch((uint32_t)ceil(width / float(TiledHorizontalTileSize)), (uint32_t)ceil(height / float(TiledHorizontalTileLines)), 1);
+        } else {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_convolve1dVerticalComputePipeline);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+            commandBuffer.dispatch((uint32_t)ceil(pixelsCount / float(WorkgroupSize)), 1, 1);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, tmpBufferBarrier, nullptr);
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_convolve1dHorizontalComputePipeline);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+            commandBuffer.dispatch((uint32_t)ceil(pixelsCount / float(WorkgroupSize)), 1, 1);
+        }
+
+        if (resampled) {
+            uint32_t outputWidth = m_output->description().width;
+            uint32_t outputHeight = m_output->description().height;
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, tmpBufferBarrier, nullptr);
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_resampleCompositeComputePipeline);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+            commandBuffer.dispatch((uint32_t)ceil(outputWidth / float(ResampleWorkgroupSize)), (uint32_t)ceil(outputHeight / float(ResampleWorkgroupSize)), 1);
+        }
+#endif
+    }
+}
+
+void BloomFilter::recordFftConvolutionCommands(const vk::raii::CommandBuffer& commandBuffer)
+{
+    ImageDescription description = convolutionDescription();
+    int kernelRadius = m_ubo.data().kernelRadius;
+    int halfBufferSize = int(m_fftBuffer->size() / (2 * 4 * sizeof(float)));
 
-        vk::BufferMemoryBarrier thresholdBufferBarrier(
+    std::array<vk::BufferMemoryBarrier, 2> barriers = {
+        vk::BufferMemoryBarrier(
             vk::AccessFlagBits::eShaderWrite,
-            vk::AccessFlagBits::eShaderRead,
+            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
             VK_QUEUE_FAMILY_IGNORED,
             VK_QUEUE_FAMILY_IGNORED,
-            m_threshold->get(),
+            m_fftBuffer->get(),
             0,
-            m_threshold->size()
-        );
-        m_commandBuffer.get().pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, thresholdBufferBarrier, nullptr);
-
-#if defined(USE_2D_CONVOLUTION)
-        m_commandBuffer.get().bindPipeline(vk::PipelineBindPoint::eCompute, *m_convolve2dComputePipeline.value());
-        m_commandBuffer.get().bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipelineLayout.value(), 0, *m_descriptorSet.value(), nullptr);
-        m_commandBuffer.get().dispatch((uint32_t)ceil(pixelsCount / float(WorkgroupSize)), 1, 1);
-#else
-
-        m_commandBuffer.get().bindPipeline(vk::PipelineBindPoint::eCompute, *m_convolve1dVerticalComputePipeline.value());
-        m_commandBuffer.get().bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipelineLayout.value(), 0, *m_descriptorSet.value(), nullptr);
-        m_commandBuffer.get().dispatch((uint32_t)ceil(pixelsCount / float(WorkgroupSize)), 1, 1);
-
-        vk::BufferMemoryBarrier tmpBufferBarrier(
+            m_fftBuffer->size()),
+        vk::BufferMemoryBarrier(
             vk::AccessFlagBits::eShaderWrite,
             vk::AccessFlagBits::eShaderRead,
             VK_QUEUE_FAMILY_IGNORED,
             VK_QUEUE_FAMILY_IGNORED,
             m_tmpBuffer->get(),
             0,
-            m_tmpBuffer->size()
-       );
-        m_commandBuffer.get().pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, tmpBufferBarrier, nullptr);
-        m_commandBuffer.get().bindPipeline(vk::PipelineBindPoint::eCompute, *m_convolve1dHorizontalComputePipeline.value());
-        m_commandBuffer.get().bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipelineLayout.value(), 0, *m_descriptorSet.value(), nullptr);
-        m_commandBuffer.get().dispatch((uint32_t)ceil(pixelsCount / float(WorkgroupSize)), 1, 1);
+            m_tmpBuffer->size()),
+    };
 
-#endif
+    // vertical pass goes first, the horizontal one composites the result
+    BloomFftStage stage;
+    for (bool horizontal : { false, true }) {
+        uint32_t length = horizontal ? description.width : description.height;
+        uint32_t lines = horizontal ? description.height : description.width;
+        vk::Pipeline pipeline = horizontal ? m_fftHorizontalComputePipeline : m_fftVerticalComputePipeline;
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+
+        // forward transform reads the source line, inverse one multiplies by the spectrum first and writes the result at the end
+        stage.size = int(fftSize(length, kernelRadius));
+        int current = 0;
+        for (int inverse = 0; inverse < 2; inverse++) {
+            for (int p = 1; p < stage.size; p <<= 1) {
+                stage.p = p;
+                stage.srcOffset = current * halfBufferSize;
+                stage.dstOffset = (1 - current) * halfBufferSize;
+                stage.inverse = inverse;
+                stage.first = p == 1;
+                stage.last = p == stage.size / 2;
+                current = 1 - current;
+
+                commandBuffer.pushConstants<BloomFftStage>(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, stage);
+                commandBuffer.dispatch((uint32_t)ceil(stage.size / 2 / float(FftWorkgroupSize)), lines, 1);
+                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, barriers, nullptr);
+            }
+        }
+        stage.spectrumOffset += stage.size;
     }
-    m_commandBuffer.get().end();
 }
 
-void BloomFilter::createComputePipelines()
+void BloomFilter::recordPyramidCommands(const vk::raii::CommandBuffer& commandBuffer)
 {
-    vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, *m_descriptorSetLayout.value());
-    m_pipelineLayout = vk::raii::PipelineLayout(deviceContext().device, pipelineLayoutInfo);
-    // threshold
-    {
-        vk::PipelineShaderStageCreateInfo shaderStageInfo({}, vk::ShaderStageFlagBits::eCompute, *m_thresholdShaderModule.value(), "main");
-        vk::ComputePipelineCreateInfo pipelineInfo({}, shaderStageInfo, *m_pipelineLayout.value());
-        m_thresholdComputePipeline = deviceContext().device.createComputePipeline(nullptr, pipelineInfo);
+    assert(!m_pyramidLevels.empty());
+
+    vk::BufferMemoryBarrier pyramidBarrier(
+        vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        m_tmpBuffer->get(),
+        0,
+        m_tmpBuffer->size());
+
+    // downsample, the first level thresholds the input
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pyramidDownsampleComputePipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+    for (const BloomPyramidLevel& level : m_pyramidLevels) {
+        commandBuffer.pushConstants<BloomPyramidLevel>(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, level);
+        commandBuffer.dispatch((uint32_t)ceil(level.dstWidth / float(PyramidWorkgroupSize)), (uint32_t)ceil(level.dstHeight / float(PyramidWorkgroupSize)), 1);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, pyramidBarrier, nullptr);
     }
-#if defined(USE_2D_CONVOLUTION)
-    // convolve2d
+
+    // upsample, every coarser level is accumulated into the next finer one
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pyramidUpsampleComputePipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+    for (size_t i = m_pyramidLevels.size() - 1; i > 0; i--) {
+        const BloomPyramidLevel& coarse = m_pyramidLevels[i];
+        const BloomPyramidLevel& fine = m_pyramidLevels[i - 1];
+        BloomPyramidLevel level;
+        level.srcOffset = coarse.dstOffset;
+        level.srcWidth = coarse.dstWidth;
+        level.srcHeight = coarse.dstHeight;
+        level.dstOffset = fine.dstOffset;
+        level.dstWidth = fine.dstWidth;
+        level.dstHeight = fine.dstHeight;
+        commandBuffer.pushConstants<BloomPyramidLevel>(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, level);
+        commandBuffer.dispatch((uint32_t)ceil(level.dstWidth / float(PyramidWorkgroupSize)), (uint32_t)ceil(level.dstHeight / float(PyramidWorkgroupSize)), 1);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, pyramidBarrier, nullptr);
+    }
+
+    // composite, every level has contributed once so the sum is averaged to keep intensity comparable to convolution mode
     {
-        vk::PipelineShaderStageCreateInfo shaderStageInfo({}, vk::ShaderStageFlagBits::eCompute, *m_convolve2dShaderModule.value(), "main");
-        vk::ComputePipelineCreateInfo pipelineInfo({}, shaderStageInfo, *m_pipelineLayout.value());
-        m_convolve2dComputePipeline = deviceContext().device.createComputePipeline(nullptr, pipelineInfo);
+        const BloomPyramidLevel& first = m_pyramidLevels.front();
+        BloomPyramidLevel level;
+        level.srcOffset = first.dstOffset;
+        level.srcWidth = first.dstWidth;
+        level.srcHeight = first.dstHeight;
+        level.dstWidth = first.srcWidth;
+        level.dstHeight = first.srcHeight;
+        level.weight = 1.0f / float(m_pyramidLevels.size());
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_pyramidCompositeComputePipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+        commandBuffer.pushConstants<BloomPyramidLevel>(m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, level);
+        commandBuffer.dispatch((uint32_t)ceil(level.dstWidth / float(PyramidWorkgroupSize)), (uint32_t)ceil(level.dstHeight / float(PyramidWorkgroupSize)), 1);
     }
+}
+
+uint32_t BloomFilter::convolutionDownscale() const noexcept
+{
+#if defined(USE_2D_CONVOLUTION)
+    return 1;
 #else
-    // convolve1d vertical
-    {
-        vk::PipelineShaderStageCreateInfo shaderStageInfo({}, vk::ShaderStageFlagBits::eCompute, *m_convolve1dVerticalShaderModule.value(), "main");
-        vk::ComputePipelineCreateInfo pipelineInfo({}, shaderStageInfo, *m_pipelineLayout.value());
-        m_convolve1dVerticalComputePipeline = deviceContext().device.createComputePipeline(nullptr, pipelineInfo);
+    // pyramid mode works at reduced resolution by itself
+    return m_mode == BloomMode::ePyramid ? 1 : m_downscale;
+#endif
+}
+
+bool BloomFilter::resampledConvolution() const noexcept
+{
+#if defined(USE_2D_CONVOLUTION)
+    return false;
+#else
+    // without downscaling the resample passes only threshold the input, which the fft and the tiled passes
+    // do once per pixel on their own
+    return m_mode == BloomMode::eConvolution && (m_ubo.data().downscale > 1 || (!m_fftConvolution && !m_tiledConvolution));
+#endif
+}
+
+ImageDescription BloomFilter::convolutionDescription() const
+{
+    const ImageDescription& description = m_input->description();
+    uint32_t downscale = convolutionDownscale();
+    return ImageDescription((description.width + downscale - 1) / downscale, (description.height + downscale - 1) / downscale, description.format);
+}
+
+size_t BloomFilter::fftBufferSize(int kernelRadius) const
+{
+    ImageDescription description = convolutionDescription();
+    size_t rows = size_t(description.height) * fftSize(description.width, kernelRadius);
+    size_t columns = size_t(description.width) * fftSize(description.height, kernelRadius);
+    // two ping-pong halves of vec4
+    return 2 * std::max(rows, columns) * 4 * sizeof(float);
+}
+
+BloomFilter::PipelineState BloomFilter::pipelineState() const
+{
+    return { m_mode, m_fftConvolution, resampledConvolution(), m_output->description().format };
+}
+
+void BloomFilter::updatePyramidLevels()
+{
+    // blur extent doubles with every level, so the chain stops once it covers the gaussian kernel radius
+    int kernelRadius = std::max(1, m_ubo.data().kernelRadius);
+    size_t levelCount = std::max(1, int(std::log2(float(kernelRadius)) + /*rounding*/ 0.5f));
+
+    m_pyramidLevels.clear();
+    BloomPyramidLevel level;
+    level.srcWidth = m_input->description().width;
+    level.srcHeight = m_input->description().height;
+    level.srcIsInput = 1;
+    while (m_pyramidLevels.size() < levelCount) {
+        if (!m_pyramidLevels.empty() && level.srcWidth == 1 && level.srcHeight == 1) {
+            break;
+        }
+
+        level.dstWidth = std::max(1, level.srcWidth / 2);
+        level.dstHeight = std::max(1, level.srcHeight / 2);
+        m_pyramidLevels.push_back(level);
+
+        level.srcOffset = level.dstOffset;
+        level.srcWidth = level.dstWidth;
+        level.srcHeight = level.dstHeight;
+        level.srcIsInput = 0;
+        level.dstOffset += level.dstWidth * level.dstHeight;
     }
-    // convolve1d horizontal
-    {
-        vk::PipelineShaderStageCreateInfo shaderStageInfo({}, vk::ShaderStageFlagBits::eCompute, *m_convolve1dHorizontalShaderModule.value(), "main");
-        vk::ComputePipelineCreateInfo pipelineInfo({}, shaderStageInfo, *m_pipelineLayout.value());
-        m_convolve1dHorizontalComputePipeline = deviceContext().device.createComputePipeline(nullptr, pipelineInfo);
+}
+
+float* BloomFilter::mapKernelData()
+{
+    auto data = static_cast<float*>(m_kernelData->map(m_kernelData->size()));
+    return data + frameIndex() * m_kernelDataFrameSize;
+}
+
+void BloomFilter::retireBuffers(bool scratch, bool kernelData)
+{
+    RetiredBuffers retired { .lastUse = submittedTimelineValue() };
+    if (scratch) {
+        retired.tmpBuffer = std::move(m_tmpBuffer);
+        retired.fftBuffer = std::move(m_fftBuffer);
     }
-#endif
+    if (kernelData) {
+        retired.kernelData = std::move(m_kernelData);
+    }
+    m_retiredBuffers.push_back(std::move(retired));
+    // the descriptor sets still referencing the buffers are retired the same way
+    m_descriptorSets.clear();
+}
+
+void BloomFilter::freeRetiredBuffers()
+{
+    uint64_t completedValue = context()->completedTimelineValue();
+    std::erase_if(m_retiredBuffers, [&](const RetiredBuffers& retired) { return retired.lastUse <= completedValue; });
 }
 
 void BloomFilter::generateGaussianKernel1d()
 {
-    float* mappedKernelData = static_cast<float*>(m_kernelData->map(m_ubo.data().getKernelData1DBufferSizeInBytes()));
-    float sigma = gaussianKernelDataSigma(m_input->description(), m_radius);
+    float* mappedKernelData = mapKernelData();
+    float sigma = gaussianKernelDataSigma(convolutionDescription(), m_radius);
     float sum = 0.0f;
     const float distNormalization = -1.0f / (2.0f * sigma * sigma);
     for (int i = 0; i < m_ubo.data().kernelRadius + 1; i++) {
@@ -207,10 +556,48 @@ void BloomFilter::generateGaussianKernel1d()
     m_kernelData->unmap();
 }
 
+void BloomFilter::generateGaussianKernelSpectrum()
+{
+    ImageDescription description = convolutionDescription();
+    int kernelRadius = m_ubo.data().kernelRadius;
+    double sigma = gaussianKernelDataSigma(description, m_radius);
+    const double distNormalization = -1.0 / (2.0 * sigma * sigma);
+
+    // same weights as generateGaussianKernel1d, where the center tap is counted twice
+    double sum = 0.0;
+    for (int i = 0; i < kernelRadius + 1; i++) {
+        sum += exp(distNormalization * i * i);
+    }
+
+    size_t spectrumSize = fftSize(description.height, kernelRadius) + fftSize(description.width, kernelRadius);
+    float* mappedKernelData = mapKernelData();
+    size_t offset = 0;
+    // vertical pass goes first
+    for (uint32_t length : { description.height, description.width }) {
+        uint32_t size = fftSize(length, kernelRadius);
+        int taps = std::min(kernelRadius, int(length) - 1);
+        std::vector<std::complex<double>> data(size);
+        data[0] = 1.0 / sum;
+        for (int i = 1; i <= taps; i++) {
+            double weight = 0.5 * exp(distNormalization * i * i) / sum;
+            data[i] = weight;
+            data[size - i] = weight;
+        }
+
+        fft(data);
+        for (uint32_t k = 0; k < size; k++) {
+            mappedKernelData[offset + k] = float(data[k].real());
+        }
+        offset += size;
+    }
+
+    m_kernelData->unmap();
+}
+
 void BloomFilter::generateGaussianKernel2d()
 {
-    float* mappedKernelData = static_cast<float*>(m_kernelData->map(m_ubo.data().getKernelData2DBufferSizeInBytes()));
-    float sigma = gaussianKernelDataSigma(m_input->description(), m_radius);
+    float* mappedKernelData = mapKernelData();
+    float sigma = gaussianKernelDataSigma(convolutionDescription(), m_radius);
     float sum = 0.0f;
     const float distNormalization = -1.0f / (2.0f * sigma * sigma);
     const float xShift = -0.5f * (float)(m_ubo.data().kernelSize - 1);
@@ -238,87 +625,146 @@ void BloomFilter::generateGaussianKernel2d()
     m_kernelData->unmap();
 }
 
-vk::Semaphore BloomFilter::run(std::optional<vk::Semaphore> waitSemaphore)
+void BloomFilter::prepare()
 {
     validateInputsAndOutput();
+    freeRetiredBuffers();
+
+    // very large kernels switch to the fft path, which needs its own shaders and buffer
+    int kernelRadius = (gaussianKernelDataSize(convolutionDescription(), m_radius) - 1) / 2;
+#if !defined(USE_2D_CONVOLUTION)
+    bool fftConvolution = m_mode == BloomMode::eConvolution && static_cast<uint32_t>(kernelRadius) > m_fftCrossoverRadius;
+    if (fftConvolution != m_fftConvolution
+        || (fftConvolution && (!m_fftBuffer || m_fftBuffer->size() < fftBufferSize(kernelRadius)))) {
+        m_fftConvolution = fftConvolution;
+        m_descriptorsDirty = true;
+        // kernel data is either weights or spectrum
+        m_kernelDirty = true;
+    }
 
-    if (m_descriptorsDirty) {
-        m_thresholdComputePipeline.reset();
-        m_thresholdShaderModule.reset();
-#if defined(USE_2D_CONVOLUTION)
-        m_convolve2dComputePipeline.reset();
-        m_convolve2dShaderModule.reset();
-#else
-        m_convolve1dVerticalComputePipeline.reset();
-        m_convolve1dVerticalShaderModule.reset();
-        m_convolve1dHorizontalComputePipeline.reset();
-        m_convolve1dHorizontalShaderModule.reset();
+    // switching between the tiled and the naive convolution switches the resample passes on or off
+    bool tiledConvolution = static_cast<uint32_t>(kernelRadius) < m_kernelCacheSize;
+    if (tiledConvolution != m_tiledConvolution) {
+        m_tiledConvolution = tiledConvolution;
+        m_descriptorsDirty = true;
+    }
 #endif
-        m_pipelineLayout.reset();
-        m_descriptorSet.reset();
-        m_descriptorPool.reset();
-        m_descriptorSetLayout.reset();
-
-        size_t thresholdSize = sizeof(float) * 4 * m_input->description().width * m_input->description().height;
-        if (!m_threshold || m_threshold->size() != thresholdSize) {
-            m_threshold.reset();
-            m_threshold = std::make_unique<Buffer>(context(), thresholdSize, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
-
-            m_tmpBuffer.reset();
-            m_tmpBuffer = std::make_unique<Buffer>(context(), thresholdSize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+    // another filter grew the transient heap, scratch has to be bound to the new memory to keep aliasing it,
+    // the old buffers keep the old memory alive until the frames in flight are done with them
+    if ((m_tmpBuffer && !m_tmpBuffer->valid()) || (m_fftBuffer && !m_fftBuffer->valid())) {
+        retireBuffers(true, false);
+        m_descriptorsDirty = true;
+    }
+
+    if (m_descriptorsDirty) {
+        m_ubo.data().downscale = static_cast<int>(convolutionDownscale());
+        m_ubo.markDirty();
+
+        // intermediates are stored as f16vec4 if device supports half precision
+        // resampled convolution keeps two low resolution images in the same buffer
+        size_t intermediatePixelSize = 4 * (deviceContext().supportHalfPrecision ? sizeof(uint16_t) : sizeof(float));
+        ImageDescription description = convolutionDescription();
+        size_t intermediatePixelsCount = std::max(
+            size_t(m_input->description().width) * m_input->description().height,
+            size_t(2) * description.width * description.height);
+        size_t tmpBufferSize = intermediatePixelSize * intermediatePixelsCount;
+        size_t fftBufferSizeInBytes = m_fftConvolution ? fftBufferSize(kernelRadius) : 0;
+        bool fftBufferFits = m_fftConvolution ? m_fftBuffer && m_fftBuffer->size() >= fftBufferSizeInBytes : !m_fftBuffer;
+        if (!m_tmpBuffer || m_tmpBuffer->size() != tmpBufferSize || !fftBufferFits) {
+            // frames in flight might still use the scratch
+            retireBuffers(true, false);
+            // both are scratch, they alias the scratch of other filters but not each other
+            std::vector<TransientBufferInfo> scratch { { tmpBufferSize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst } };
+            if (m_fftConvolution) {
+                scratch.push_back({ fftBufferSizeInBytes, vk::BufferUsageFlagBits::eStorageBuffer });
+            }
+            std::vector<std::unique_ptr<TransientBuffer>> buffers = context()->transientHeap().createBuffers(scratch);
+            m_tmpBuffer = std::move(buffers[0]);
+            BOOST_LOG_TRIVIAL(info) << "BloomFilter: intermediate buffer size " << tmpBufferSize << " bytes";
+            if (m_fftConvolution) {
+                m_fftBuffer = std::move(buffers[1]);
+                BOOST_LOG_TRIVIAL(info) << "BloomFilter: fft buffer size " << fftBufferSizeInBytes << " bytes";
+            }
         }
 
         // m_radius cannot be more than 1.0f
         size_t maxKernelDataSize = gaussianKernelDataSize(m_input->description(), 1.0f);
         size_t maxKernelRadius = (maxKernelDataSize - 1) / 2;
-        size_t kernelDataBufferSizeInBytes = 
+        size_t kernelDataFrameSize =
 #if defined(USE_2D_CONVOLUTION)
-            maxKernelDataSize * maxKernelDataSize * sizeof(float);
+            maxKernelDataSize * maxKernelDataSize;
 #else
-            (maxKernelDataSize + 1) * sizeof(float);
+            // fft path stores the kernel spectrum of both axes instead of the weights
+            std::max(maxKernelDataSize + 1, size_t(fftSize(m_input->description().width, maxKernelRadius) + fftSize(m_input->description().height, maxKernelRadius)));
 #endif
-        if (!m_kernelData || m_kernelData->size() < kernelDataBufferSizeInBytes) {
-            m_kernelData.reset();
-            m_kernelData = std::make_unique<Buffer>(context(), kernelDataBufferSizeInBytes, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+        if (!m_kernelData || m_kernelDataFrameSize < kernelDataFrameSize) {
+            // frames in flight might still read the kernel data
+            if (m_kernelData) {
+                retireBuffers(false, true);
+            }
+            m_kernelDataFrameSize = kernelDataFrameSize;
+            m_kernelData = std::make_unique<Buffer>(context(), kernelDataFrameSize * sizeof(float) * framesInFlight(), vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
             m_kernelDirty = true;
         }
 
-        createShaderModules();
+        vk::DescriptorSetLayout descriptorSetLayout = m_descriptorSetLayout;
         createDescriptorSet();
-        createComputePipelines();
-        recordComputeCommandBuffers();
+        // images of the same format are rebound without touching the pipelines
+        if (m_descriptorSetLayout != descriptorSetLayout || pipelineState() != m_pipelineState) {
+            createComputePipelines();
+        }
         m_descriptorsDirty = false;
+        markCommandsDirty();
     }
 
-    if (m_ubo.dirty() || m_kernelDirty) {
-        m_ubo.data().kernelSize = gaussianKernelDataSize(m_input->description(), m_radius);
+    if (m_kernelDirty) {
+        m_ubo.data().kernelSize = gaussianKernelDataSize(convolutionDescription(), m_radius);
         m_ubo.data().kernelRadius = (m_ubo.data().kernelSize - 1) / 2;
-        m_ubo.update();
+        m_ubo.markDirty();
+
+        if (m_mode == BloomMode::ePyramid) {
+            updatePyramidLevels();
+            markCommandsDirty();
+        } else {
+            m_kernelVersion++;
+            if (m_fftConvolution) {
+                // padded line length depends on the radius
+                markCommandsDirty();
+            }
+        }
+        m_kernelDirty = false;
     }
 
-    if (m_kernelDirty) {
+    // the kernel data of a frame is written right before the frame uses it, the previous use of the copy has finished
+    if (m_mode != BloomMode::ePyramid && m_kernelFrameVersions[frameIndex()] != m_kernelVersion) {
+        if (m_fftConvolution) {
+            generateGaussianKernelSpectrum();
+        } else {
 #if defined(USE_2D_CONVOLUTION)
-        generateGaussianKernel2d();
+            generateGaussianKernel2d();
 #else
-        generateGaussianKernel1d();
+            generateGaussianKernel1d();
 #endif
-        m_kernelDirty = false;
-    }
-
-    // threshold
-    {
-        vk::SubmitInfo submitInfo;
-        vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
-        if (waitSemaphore.has_value()) {
-            submitInfo.setWaitDstStageMask(waitStage);
-            submitInfo.setWaitSemaphores(waitSemaphore.value());
         }
+        m_kernelFrameVersions[frameIndex()] = m_kernelVersion;
+    }
 
-        submitInfo.setSignalSemaphores(*m_finishedSemaphore);
-        submitInfo.setCommandBuffers(*m_commandBuffer.get());
-        deviceContext().queue.submit(submitInfo);
+    // every copy of the ubo points at the kernel data of its own frame
+    m_ubo.data().kernelDataOffset = static_cast<int>(frameIndex() * m_kernelDataFrameSize);
+    if (m_ubo.dirty(frameIndex())) {
+        m_ubo.update(frameIndex());
     }
-    return *m_finishedSemaphore;
+}
+
+Image* BloomFilter::output() const noexcept
+{
+    return m_output;
+}
+
+FilterAccesses BloomFilter::accesses() const
+{
+    return { .readImages = { m_input }, .writtenImages = { m_output } };
 }
 
 void BloomFilter::setInput(Image* image)
@@ -353,6 +799,28 @@ void BloomFilter::setThreshold(float threshold) noexcept
     m_ubo.markDirty();
 }
 
+void BloomFilter::setMode(BloomMode mode) noexcept
+{
+    if (m_mode != mode) {
+        m_mode = mode;
+        m_descriptorsDirty = true;
+        m_kernelDirty = true;
+    }
+}
+
+void BloomFilter::setDownscale(uint32_t downscale)
+{
+    if (downscale != 1 && downscale != 2 && downscale != 4 && downscale != 8) {
+        throw InvalidParameter("downscale", "should be 1, 2, 4 or 8");
+    }
+
+    if (m_downscale != downscale) {
+        m_downscale = downscale;
+        m_descriptorsDirty = true;
+        m_kernelDirty = true;
+    }
+}
+
 float BloomFilter::getRadius() const noexcept
 {
     return m_radius;
@@ -368,4 +836,61 @@ float BloomFilter::getThreshold() const noexcept
     return m_ubo.data().threshold;
 }
 
+BloomMode BloomFilter::getMode() const noexcept
+{
+    return m_mode;
+}
+
+uint32_t BloomFilter::getDownscale() const noexcept
+{
+    return m_downscale;
+}
+
+void BloomFilter::setFftCrossoverRadius(uint32_t radius) noexcept
+{
+    m_fftCrossoverRadius = radius;
+}
+
+uint32_t BloomFilter::getFftCrossoverRadius() const noexcept
+{
+    return m_fftCrossoverRadius;
+}
+
+std::vector<PrewarmTask> BloomFilter::prewarmTasks(Context* context, ImageFormat format)
+{
+    PipelineRegistry* registry = &context->pipelineRegistry();
+    bool halfPrecision = context->deviceContext().supportHalfPrecision;
+    uint32_t cacheSize = kernelCacheSize(context->deviceContext().physicalDevice);
+
+    std::vector<PipelineState> states = { { BloomMode::ePyramid, false, false, format } };
+    for (bool fftConvolution : { false, true }) {
+        for (bool resampled : { false, true }) {
+            states.push_back({ BloomMode::eConvolution, fftConvolution, resampled, format });
+        }
+    }
+
+    std::vector<PrewarmTask> tasks;
+    for (const PipelineState& state : states) {
+        vk::helper::DescriptorBuilder builder;
+        builder.bindDynamicUniformBuffer(nullptr);
+        builder.bindStorageBuffer(nullptr);
+        builder.bindStorageBuffer(nullptr);
+        builder.bindStorageImage(nullptr);
+        builder.bindStorageImage(nullptr);
+        // the fft buffer is bound only while the filter convolves in frequency domain
+        if (std::get<1>(state)) {
+            builder.bindStorageBuffer(nullptr);
+        }
+        vk::PipelineLayout layout = pipelineLayout(*registry, registry->descriptorSetLayout(builder.bindings()));
+
+        for (PipelineShader& shader : pipelineShaders(state, halfPrecision, cacheSize)) {
+            tasks.push_back([registry, layout, shaderName = std::move(shader.shaderName), macros = std::move(shader.macroDefinitions)] {
+                (void)registry->computePipeline(shaderName, macros, layout);
+            });
+        }
+    }
+
+    return tasks;
+}
+
 }
\ No newline at end of file
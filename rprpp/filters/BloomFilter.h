@@ -1,49 +1,101 @@
 #pragma once
 
-#include "Filter.h"
+#include "ComputeFilter.h"
+#include "DescriptorSetCache.h"
 #include "rprpp/Image.h"
+#include "rprpp/PipelineRegistry.h"
+#include "rprpp/TransientHeap.h"
 #include "rprpp/UniformObjectBuffer.h"
+#include "rprpp/rprpp.h"
 #include "rprpp/vk/CommandBuffer.h"
 #include "rprpp/vk/DeviceContext.h"
 #include "rprpp/vk/ShaderManager.h"
 
 #include <memory>
 #include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 // we have a naive, not optimized 2d convolution and it has poor performance
 // so instead we use 1d version
 // #define USE_2D_CONVOLUTION
 
+// 1d convolution has two implementations: the naive one reads every tap from global memory,
+// the tiled one stages the row/column tile with its apron and the kernel weights in shared memory.
+// The tiled one is used whenever the kernel weights fit into shared memory.
+
+// convolution can run at a reduced resolution: the thresholded input is box filtered into a downscaled buffer,
+// convolved with a proportionally smaller kernel and bilinearly upsampled onto the input in the final pass.
+// the naive 1d convolution always goes through these resample passes, so the threshold is applied once per pixel
+// instead of once per tap.
+
+// very large kernels are convolved in frequency domain: every line is padded, transformed with radix-2 stockham fft,
+// multiplied by the kernel spectrum and transformed back, so the cost doesn't depend on the radius.
+
+// pyramid mode doesn't use the gaussian kernel at all: the thresholded input is downsampled into a mip chain
+// and then upsampled back with a tent filter accumulating every level, so its cost doesn't depend on the radius.
+
 namespace rprpp::filters {
 
+enum class BloomMode {
+    eConvolution = RPRPP_BLOOM_MODE_CONVOLUTION,
+    ePyramid = RPRPP_BLOOM_MODE_PYRAMID,
+};
+
+// must match push constants of bloom_pyramid.comp
+struct BloomPyramidLevel {
+    int srcOffset = 0;
+    int srcWidth = 0;
+    int srcHeight = 0;
+    int dstOffset = 0;
+    int dstWidth = 0;
+    int dstHeight = 0;
+    int srcIsInput = 0;
+    float weight = 1.0f;
+};
+
+// must match push constants of bloom_fft.comp
+struct BloomFftStage {
+    int size = 0;
+    int p = 0;
+    int srcOffset = 0;
+    int dstOffset = 0;
+    int spectrumOffset = 0;
+    int inverse = 0;
+    int first = 0;
+    int last = 0;
+};
+
 struct BloomParams {
     int kernelSize = 0;
     int kernelRadius = 0.0f;
     float intensity = 0.1f;
     float threshold = 0.0f;
-
-    [[nodiscard]] size_t getKernelData2DBufferSizeInBytes() const noexcept
-    {
-        return kernelSize * kernelSize * sizeof(float);
-    }
-
-    [[nodiscard]] size_t getKernelData1DBufferSizeInBytes() const noexcept
-    {
-        return (kernelRadius + 1) * sizeof(float);
-    }
+    int downscale = 1;
+    // in floats, every frame in flight has its own copy of the kernel data
+    int kernelDataOffset = 0;
 };
 
-class BloomFilter : public Filter {
+class BloomFilter : public ComputeFilter {
 public:
     explicit BloomFilter(Context* context) noexcept;
 
-    vk::Semaphore run(std::optional<vk::Semaphore> waitSemaphore) override;
+    void prepare() override;
+    void record(const vk::raii::CommandBuffer& commandBuffer) override;
+    [[nodiscard]] Image* output() const noexcept override;
+    [[nodiscard]] FilterAccesses accesses() const override;
     void setInput(Image* img) override;
     void setOutput(Image* img) override;
 
     void setRadius(float radius) noexcept;
     void setIntensity(float intensity) noexcept;
     void setThreshold(float threshold) noexcept;
+    void setMode(BloomMode mode) noexcept;
+    void setDownscale(uint32_t downscale);
+    // kernels with a larger radius, in pixels of the convolution resolution, are convolved with fft
+    void setFftCrossoverRadius(uint32_t radius) noexcept;
 
     [[nodiscard]] float getRadius() const noexcept;
 
@@ -51,43 +103,103 @@ public:
 
     [[nodiscard]] float getThreshold() const noexcept;
 
+    [[nodiscard]] BloomMode getMode() const noexcept;
+
+    [[nodiscard]] uint32_t getDownscale() const noexcept;
+
+    [[nodiscard]] uint32_t getFftCrossoverRadius() const noexcept;
+
+    // pipelines of both modes, with and without downscaling and fft convolution
+    [[nodiscard]] static std::vector<PrewarmTask> prewarmTasks(Context* context, ImageFormat format);
+
 private:
+    // mode, fft convolution, resampled and format
+    using PipelineState = std::tuple<BloomMode, bool, bool, ImageFormat>;
+
+    struct PipelineShader {
+        vk::Pipeline BloomFilter::*pipeline;
+        std::string shaderName;
+        std::unordered_map<std::string, std::string> macroDefinitions;
+    };
+
+    // every pipeline of the state
+    static std::vector<PipelineShader> pipelineShaders(const PipelineState& state, bool halfPrecision, uint32_t kernelCacheSize);
+    static vk::PipelineLayout pipelineLayout(PipelineRegistry& registry, vk::DescriptorSetLayout descriptorSetLayout);
     void validateInputsAndOutput();
-    void createShaderModules();
     void createDescriptorSet();
     void createComputePipelines();
-    void recordComputeCommandBuffers();
+    void recordConvolutionCommands(const vk::raii::CommandBuffer& commandBuffer);
+    void recordFftConvolutionCommands(const vk::raii::CommandBuffer& commandBuffer);
+    void recordPyramidCommands(const vk::raii::CommandBuffer& commandBuffer);
+    void updatePyramidLevels();
+    [[nodiscard]] uint32_t convolutionDownscale() const noexcept;
+    // the convolution reads the thresholded input from the resample pass instead of the input image
+    [[nodiscard]] bool resampledConvolution() const noexcept;
+    [[nodiscard]] ImageDescription convolutionDescription() const;
+    [[nodiscard]] size_t fftBufferSize(int kernelRadius) const;
+    [[nodiscard]] PipelineState pipelineState() const;
     void generateGaussianKernel1d();
     void generateGaussianKernel2d();
+    void generateGaussianKernelSpectrum();
+    // kernel data of the current frame
+    [[nodiscard]] float* mapKernelData();
+    void retireBuffers(bool scratch, bool kernelData);
+    void freeRetiredBuffers();
+
+    // buffers replaced while frames in flight might still use them, freed once the timeline passes lastUse
+    struct RetiredBuffers {
+        std::unique_ptr<TransientBuffer> tmpBuffer;
+        std::unique_ptr<TransientBuffer> fftBuffer;
+        std::unique_ptr<Buffer> kernelData;
+        uint64_t lastUse = 0;
+    };
 
     bool m_descriptorsDirty = true;
     bool m_kernelDirty = true;
+    bool m_tiledConvolution = false;
+    bool m_fftConvolution = false;
+    uint32_t m_kernelCacheSize;
     float m_radius = 0.0f;
+    BloomMode m_mode = BloomMode::eConvolution;
+    uint32_t m_downscale = 1;
+    uint32_t m_fftCrossoverRadius;
+    std::vector<BloomPyramidLevel> m_pyramidLevels;
     Image* m_input = nullptr;
     Image* m_output = nullptr;
 
-    vk::helper::ShaderManager m_shaderManager;
-    vk::raii::Semaphore m_finishedSemaphore;
     UniformObjectBuffer<BloomParams> m_ubo;
-    vk::helper::CommandBuffer m_commandBuffer;
-    std::unique_ptr<Buffer> m_threshold;
-    std::unique_ptr<Buffer> m_tmpBuffer;
+    // scratch, aliases the scratch of other filters
+    std::unique_ptr<TransientBuffer> m_tmpBuffer;
     std::unique_ptr<Buffer> m_kernelData;
-    std::optional<vk::raii::DescriptorSetLayout> m_descriptorSetLayout;
-    std::optional<vk::raii::DescriptorPool> m_descriptorPool;
-    std::optional<vk::raii::DescriptorSet> m_descriptorSet;
-    std::optional<vk::raii::PipelineLayout> m_pipelineLayout;
+    // in floats
+    size_t m_kernelDataFrameSize = 0;
+    // kernel data of a frame is generated again when its version is behind
+    uint64_t m_kernelVersion = 1;
+    std::vector<uint64_t> m_kernelFrameVersions;
+    std::vector<RetiredBuffers> m_retiredBuffers;
+    std::unique_ptr<TransientBuffer> m_fftBuffer;
+    DescriptorSetCache m_descriptorSets;
+    vk::DescriptorSet m_descriptorSet;
+    // layouts and pipelines are owned by the context's pipeline registry
+    vk::DescriptorSetLayout m_descriptorSetLayout;
+    vk::PipelineLayout m_pipelineLayout;
+    std::optional<PipelineState> m_pipelineState;
+
+    vk::Pipeline m_pyramidDownsampleComputePipeline;
+    vk::Pipeline m_pyramidUpsampleComputePipeline;
+    vk::Pipeline m_pyramidCompositeComputePipeline;
 
-    std::optional<vk::raii::ShaderModule> m_thresholdShaderModule;
-    std::optional<vk::raii::Pipeline> m_thresholdComputePipeline;
 #if defined(USE_2D_CONVOLUTION)
-    std::optional<vk::raii::ShaderModule> m_convolve2dShaderModule;
-    std::optional<vk::raii::Pipeline> m_convolve2dComputePipeline;
+    vk::Pipeline m_convolve2dComputePipeline;
 #else
-    std::optional<vk::raii::ShaderModule> m_convolve1dVerticalShaderModule;
-    std::optional<vk::raii::Pipeline> m_convolve1dVerticalComputePipeline;
-    std::optional<vk::raii::ShaderModule> m_convolve1dHorizontalShaderModule;
-    std::optional<vk::raii::Pipeline> m_convolve1dHorizontalComputePipeline;
+    vk::Pipeline m_resampleDownsampleComputePipeline;
+    vk::Pipeline m_resampleCompositeComputePipeline;
+    vk::Pipeline m_convolve1dVerticalComputePipeline;
+    vk::Pipeline m_convolve1dHorizontalComputePipeline;
+    vk::Pipeline m_convolve1dTiledVerticalComputePipeline;
+    vk::Pipeline m_convolve1dTiledHorizontalComputePipeline;
+    vk::Pipeline m_fftVerticalComputePipeline;
+    vk::Pipeline m_fftHorizontalComputePipeline;
 #endif
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
-#include "Filter.h"
+#include "ComputeFilter.h"
+#include "DescriptorSetCache.h"
 #include "rprpp/Image.h"
 #include "rprpp/UniformObjectBuffer.h"
 #include "rprpp/vk/CommandBuffer.h"
@@ -21,11 +22,15 @@ struct ComposeColorShadowReflectionParams {
     float shadowIntensity = 1.0f;
 };
 
-class ComposeColorShadowReflectionFilter : public Filter {
+class ComposeColorShadowReflectionFilter : public ComputeFilter {
 public:
     explicit ComposeColorShadowReflectionFilter(Context* context);
 
-    vk::Semaphore run(std::optional<vk::Semaphore> waitSemaphore) override;
+    void prepare() override;
+    void record(const vk::raii::CommandBuffer& commandBuffer) override;
+    [[nodiscard]] Image* output() const noexcept override;
+    [[nodiscard]] FilterAccesses accesses() const override;
+    [[nodiscard]] std::optional<PointwiseStage> pointwiseStage() const override;
     void setOutput(Image* img) override;
     void setInput(Image* img) override;
 
@@ -47,16 +52,19 @@ public:
     void getTileOffset(uint32_t& x, uint32_t& y) const noexcept;
     float getShadowIntensity() const noexcept;
 
+    // pipelines for outputs of outputFormat and both storage and sampled aovs of aovsFormat
+    [[nodiscard]] static std::vector<PrewarmTask> prewarmTasks(Context* context, ImageFormat outputFormat, ImageFormat aovsFormat);
+
 private:
     static vk::SamplerCreateInfo samplerParameters();
 
     bool allAovsAreSampledImages() const noexcept;
     bool allAovsAreStoreImages() const noexcept;
     void validateInputsAndOutput();
-    void createShaderModule();
+    std::unordered_map<std::string, std::string> macroDefinitions() const;
+    static std::unordered_map<std::string, std::string> macroDefinitions(ImageFormat outputFormat, ImageFormat aovsFormat, bool sampledAovs);
     void createDescriptorSet();
     void createComputePipeline();
-    void recordComputeCommandBuffer();
 
     bool m_descriptorsDirty = true;
     Image* m_aovColor = nullptr;
@@ -67,17 +75,15 @@ private:
     Image* m_aovBackground = nullptr;
     Image* m_output = nullptr;
 
-    vk::helper::ShaderManager m_shaderManager;
-    vk::raii::Semaphore m_finishedSemaphore;
     UniformObjectBuffer<ComposeColorShadowReflectionParams> m_ubo;
     vk::raii::Sampler m_sampler;
-    vk::helper::CommandBuffer m_commandBuffer;
-    std::optional<vk::raii::ShaderModule> m_shaderModule;
-    std::optional<vk::raii::DescriptorSetLayout> m_descriptorSetLayout;
-    std::optional<vk::raii::DescriptorPool> m_descriptorPool;
-    std::optional<vk::raii::DescriptorSet> m_descriptorSet;
-    std::optional<vk::raii::PipelineLayout> m_pipelineLayout;
-    std::optional<vk::raii::Pipeline> m_computePipeline;
+    // layouts and pipeline are owned by the context's pipeline registry
+    vk::DescriptorSetLayout m_descriptorSetLayout;
+    DescriptorSetCache m_descriptorSets;
+    vk::DescriptorSet m_descriptorSet;
+    vk::PipelineLayout m_pipelineLayout;
+    vk::Pipeline m_computePipeline;
+    std::unordered_map<std::string, std::string> m_pipelineMacroDefinitions;
 };
 
 } // namespace rprpp
\ No newline at end of file
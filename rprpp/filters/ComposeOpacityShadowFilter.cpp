@@ -1,4 +1,5 @@
 #include "ComposeOpacityShadowFilter.h"
+#include "rprpp/Context.h"
 #include "rprpp/Error.h"
 #include "rprpp/rprpp.h"
 #include "rprpp/vk/DescriptorBuilder.h"
@@ -18,30 +19,33 @@ constexpr vk::SamplerCreateInfo createSamplerInfo()
 }
 
 ComposeOpacityShadowFilter::ComposeOpacityShadowFilter(Context* context)
-    : Filter(context)
-    , m_finishedSemaphore(deviceContext().device.createSemaphore({}))
-    , m_ubo(context)
+    : ComputeFilter(context)
+    , m_ubo(context, framesInFlight())
     , m_sampler(deviceContext().device, createSamplerInfo())
-    , m_commandBuffer(&deviceContext())
+    , m_descriptorSets(context, framesInFlight())
 {
 }
 
-void ComposeOpacityShadowFilter::createShaderModule()
+std::unordered_map<std::string, std::string> ComposeOpacityShadowFilter::macroDefinitions() const
 {
-    const std::unordered_map<std::string, std::string> macroDefinitions = {
-        { "OUTPUT_FORMAT", to_glslformat(m_output->description().format) },
-        { "AOVS_FORMAT", to_glslformat(m_aovOpacity->description().format) },
+    return macroDefinitions(m_output->description().format, m_aovOpacity->description().format, allAovsAreSampledImages());
+}
+
+std::unordered_map<std::string, std::string> ComposeOpacityShadowFilter::macroDefinitions(ImageFormat outputFormat, ImageFormat aovsFormat, bool sampledAovs)
+{
+    return {
+        { "OUTPUT_FORMAT", to_glslformat(outputFormat) },
+        { "AOVS_FORMAT", to_glslformat(aovsFormat) },
         { "WORKGROUP_SIZE", std::to_string(WorkgroupSize) },
-        { "AOVS_ARE_SAMPLED_IMAGES", allAovsAreSampledImages() ? "1" : "0" }
+        { "AOVS_ARE_SAMPLED_IMAGES", sampledAovs ? "1" : "0" }
     };
-    m_shaderModule = m_shaderManager.getComposeOpacityShadowShader(deviceContext().device, macroDefinitions);
 }
 
 void ComposeOpacityShadowFilter::createDescriptorSet()
 {
     vk::helper::DescriptorBuilder builder;
     vk::DescriptorBufferInfo uboDescriptorInfo(m_ubo.buffer(), 0, m_ubo.size()); // binding 0
-    builder.bindUniformBuffer(&uboDescriptorInfo);
+    builder.bindDynamicUniformBuffer(&uboDescriptorInfo);
 
     vk::DescriptorImageInfo outputDescriptorInfo(nullptr, *m_output->view(), m_output->layout()); // binding 1
     builder.bindStorageImage(&outputDescriptorInfo);
@@ -65,34 +69,25 @@ void ComposeOpacityShadowFilter::createDescriptorSet()
         }
     }
 
-    const std::vector<vk::DescriptorPoolSize>& poolSizes = builder.poolSizes();
-    m_descriptorSetLayout = deviceContext().device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, builder.bindings()));
-    m_descriptorPool = deviceContext().device.createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, 1, poolSizes));
-    m_descriptorSet = std::move(vk::raii::DescriptorSets(deviceContext().device, vk::DescriptorSetAllocateInfo(*m_descriptorPool.value(), *m_descriptorSetLayout.value())).front());
-
-    builder.updateDescriptorSet(*m_descriptorSet.value());
-    deviceContext().device.updateDescriptorSets(builder.writes(), nullptr);
+    m_descriptorSetLayout = context()->pipelineRegistry().descriptorSetLayout(builder.bindings());
+    m_descriptorSet = m_descriptorSets.get({ m_output->tag(), m_aovOpacity->tag(), m_aovShadowCatcher->tag() }, m_descriptorSetLayout, builder);
 }
 
-void ComposeOpacityShadowFilter::recordComputeCommandBuffer()
+void ComposeOpacityShadowFilter::record(const vk::raii::CommandBuffer& commandBuffer)
 {
-    m_commandBuffer.get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
-    m_commandBuffer.get().bindPipeline(vk::PipelineBindPoint::eCompute, *m_computePipeline.value());
-    m_commandBuffer.get().bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipelineLayout.value(), 0, *m_descriptorSet.value(), nullptr);
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_computePipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
     int x = std::min((int)m_output->description().width - m_ubo.data().tileOffset[0], m_ubo.data().tileSize[0]);
     int y = std::min((int)m_output->description().height - m_ubo.data().tileOffset[1], m_ubo.data().tileSize[1]);
-    m_commandBuffer.get().dispatch((uint32_t)ceil(x / float(WorkgroupSize)), (uint32_t)ceil(y / float(WorkgroupSize)), 1);
-    m_commandBuffer.get().end();
+    commandBuffer.dispatch((uint32_t)ceil(x / float(WorkgroupSize)), (uint32_t)ceil(y / float(WorkgroupSize)), 1);
 }
 
 void ComposeOpacityShadowFilter::createComputePipeline()
 {
-    vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, *m_descriptorSetLayout.value());
-    m_pipelineLayout = vk::raii::PipelineLayout(deviceContext().device, pipelineLayoutInfo);
-
-    vk::PipelineShaderStageCreateInfo shaderStageInfo({}, vk::ShaderStageFlagBits::eCompute, *m_shaderModule.value(), "main");
-    vk::ComputePipelineCreateInfo pipelineInfo({}, shaderStageInfo, *m_pipelineLayout.value());
-    m_computePipeline = deviceContext().device.createComputePipeline(nullptr, pipelineInfo);
+    PipelineRegistry& registry = context()->pipelineRegistry();
+    m_pipelineLayout = registry.pipelineLayout({ m_descriptorSetLayout });
+    m_pipelineMacroDefinitions = macroDefinitions();
+    m_computePipeline = registry.computePipeline("compose_opacity_shadow", m_pipelineMacroDefinitions, m_pipelineLayout);
 }
 
 bool ComposeOpacityShadowFilter::allAovsAreSampledImages() const noexcept
@@ -132,40 +127,35 @@ void ComposeOpacityShadowFilter::validateInputsAndOutput()
     }
 }
 
-vk::Semaphore ComposeOpacityShadowFilter::run(std::optional<vk::Semaphore> waitSemaphore)
+void ComposeOpacityShadowFilter::prepare()
 {
     validateInputsAndOutput();
 
     if (m_descriptorsDirty) {
-        m_computePipeline.reset();
-        m_pipelineLayout.reset();
-        m_descriptorSet.reset();
-        m_descriptorPool.reset();
-        m_descriptorSetLayout.reset();
-        m_shaderModule.reset();
-
-        createShaderModule();
+        vk::DescriptorSetLayout descriptorSetLayout = m_descriptorSetLayout;
         createDescriptorSet();
-        createComputePipeline();
+        // images of the same formats and kinds are rebound without touching the pipeline
+        if (m_descriptorSetLayout != descriptorSetLayout || macroDefinitions() != m_pipelineMacroDefinitions) {
+            createComputePipeline();
+        }
         m_descriptorsDirty = false;
+        markCommandsDirty();
     }
 
-    if (m_ubo.dirty()) {
-        m_ubo.update();
-        recordComputeCommandBuffer();
+    if (m_ubo.dirty(frameIndex())) {
+        m_ubo.update(frameIndex());
+        markCommandsDirty();
     }
+}
 
-    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
-    vk::SubmitInfo submitInfo;
-    if (waitSemaphore.has_value()) {
-        submitInfo.setWaitDstStageMask(waitStage);
-        submitInfo.setWaitSemaphores(waitSemaphore.value());
-    }
+Image* ComposeOpacityShadowFilter::output() const noexcept
+{
+    return m_output;
+}
 
-    submitInfo.setSignalSemaphores(*m_finishedSemaphore);
-    submitInfo.setCommandBuffers(*m_commandBuffer.get());
-    deviceContext().queue.submit(submitInfo);
-    return *m_finishedSemaphore;
+FilterAccesses ComposeOpacityShadowFilter::accesses() const
+{
+    return { .readImages = { m_aovOpacity, m_aovShadowCatcher }, .writtenImages = { m_output } };
 }
 
 void ComposeOpacityShadowFilter::setInput(Image* img)
@@ -216,4 +206,30 @@ float ComposeOpacityShadowFilter::getShadowIntensity() const noexcept
     return m_ubo.data().shadowIntensity;
 }
 
+std::vector<PrewarmTask> ComposeOpacityShadowFilter::prewarmTasks(Context* context, ImageFormat outputFormat, ImageFormat aovsFormat)
+{
+    PipelineRegistry* registry = &context->pipelineRegistry();
+    std::vector<PrewarmTask> tasks;
+    for (bool sampledAovs : { false, true }) {
+        // the same bindings as createDescriptorSet() gives
+        vk::helper::DescriptorBuilder builder;
+        builder.bindDynamicUniformBuffer(nullptr);
+        builder.bindStorageImage(nullptr);
+        for (int i = 0; i < 2; i++) {
+            if (sampledAovs) {
+                builder.bindCombinedImageSampler(nullptr);
+            } else {
+                builder.bindStorageImage(nullptr);
+            }
+        }
+
+        vk::PipelineLayout pipelineLayout = registry->pipelineLayout({ registry->descriptorSetLayout(builder.bindings()) });
+        tasks.push_back([registry, pipelineLayout, macros = macroDefinitions(outputFormat, aovsFormat, sampledAovs)] {
+            (void)registry->computePipeline("compose_opacity_shadow", macros, pipelineLayout);
+        });
+    }
+
+    return tasks;
+}
+
 }
@@ -0,0 +1,33 @@
+#include "ComputeFilter.h"
+#include "rprpp/Context.h"
+
+namespace rprpp::filters {
+
+ComputeFilter::ComputeFilter(Context* context)
+    : Filter(context)
+{
+    m_frames.reserve(context->framesInFlight());
+    for (uint32_t i = 0; i < context->framesInFlight(); i++) {
+        m_frames.push_back(Frame {
+            .commandBuffer = std::make_unique<vk::helper::CommandBuffer>(&deviceContext()),
+        });
+    }
+}
+
+void ComputeFilter::submit(const SubmitSync& sync)
+{
+    Frame& frame = m_frames[m_frameIndex];
+    prepare();
+
+    if (frame.recordedCommandsVersion != m_commandsVersion) {
+        frame.commandBuffer->get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
+        record(frame.commandBuffer->get());
+        frame.commandBuffer->get().end();
+        frame.recordedCommandsVersion = m_commandsVersion;
+    }
+
+    sync.submit(deviceContext(), deviceContext().queue, *frame.commandBuffer->get(), vk::PipelineStageFlagBits::eAllCommands);
+    m_frameIndex = (m_frameIndex + 1) % framesInFlight();
+}
+
+}
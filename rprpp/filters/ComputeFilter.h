@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Filter.h"
+#include "rprpp/vk/CommandBuffer.h"
+#include "rprpp/vk/ShaderManager.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace rprpp::filters {
+
+// per-pixel part of a filter, adjacent stages are fused by Pipeline into one dispatch
+struct PointwiseStage {
+    vk::helper::FusedShaderStage shader;
+    vk::DescriptorSetLayout descriptorSetLayout;
+    vk::DescriptorSet descriptorSet;
+    // dynamic uniform buffer offset of frame i is i * dynamicOffsetStride
+    uint32_t dynamicOffsetStride = 0;
+    std::vector<vk::SpecializationMapEntry> specializationEntries;
+    std::vector<uint8_t> specializationData;
+    // nullptr if the stage computes its color from own resources and can only start a fused chain
+    Image* input = nullptr;
+    Image* output = nullptr;
+
+    bool operator==(const PointwiseStage&) const = default;
+};
+
+// images and buffers the recorded commands share with other filters, Pipeline builds the barriers between filters from them.
+// scratch and other resources only the filter itself uses are synchronized by the filter
+struct FilterAccesses {
+    std::vector<Image*> readImages;
+    std::vector<Image*> writtenImages;
+    std::vector<vk::Buffer> readBuffers;
+    std::vector<vk::Buffer> writtenBuffers;
+};
+
+// creates one of the pipelines a filter might need, returned by the static prewarmTasks() of the filters.
+// runs on any thread, the layouts are created before the task is returned
+using PrewarmTask = std::function<void()>;
+
+// filter that only records compute work, so it can share a command buffer with other filters.
+// run() submits the recorded commands on its own, Pipeline records several filters back to back.
+// per-frame resources (ubo copies and command buffers) form rings as deep as the context's frames in flight,
+// so a frame never overwrites what the previous frames still use on GPU.
+class ComputeFilter : public Filter {
+public:
+    explicit ComputeFilter(Context* context);
+
+    void submit(const SubmitSync& sync) override;
+
+    // validates inputs and updates resources and ubo, has to be called before record()
+    virtual void prepare() = 0;
+    // records dispatches and internal barriers, without begin/end and submission
+    virtual void record(const vk::raii::CommandBuffer& commandBuffer) = 0;
+    // image written by the recorded commands
+    [[nodiscard]] virtual Image* output() const noexcept = 0;
+    // valid after prepare()
+    [[nodiscard]] virtual FilterAccesses accesses() const = 0;
+    // valid after prepare(), nullopt if the filter can't be fused with its current settings
+    [[nodiscard]] virtual std::optional<PointwiseStage> pointwiseStage() const { return std::nullopt; }
+
+    // changes every time record() would record different commands
+    [[nodiscard]] uint64_t commandsVersion() const noexcept { return m_commandsVersion; }
+
+    [[nodiscard]] uint32_t framesInFlight() const noexcept { return static_cast<uint32_t>(m_frames.size()); }
+
+    [[nodiscard]] uint32_t frameIndex() const noexcept { return m_frameIndex; }
+
+    // selects per-frame resources used by the next prepare() and record(), submit() advances it on its own
+    void setFrameIndex(uint32_t frameIndex) noexcept { m_frameIndex = frameIndex % framesInFlight(); }
+
+protected:
+    void markCommandsDirty() noexcept { m_commandsVersion++; }
+
+private:
+    struct Frame {
+        std::unique_ptr<vk::helper::CommandBuffer> commandBuffer;
+        uint64_t recordedCommandsVersion = 0;
+    };
+
+    std::vector<Frame> m_frames;
+    uint32_t m_frameIndex = 0;
+    uint64_t m_commandsVersion = 1;
+};
+
+}
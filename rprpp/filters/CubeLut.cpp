@@ -0,0 +1,84 @@
+#include "CubeLut.h"
+#include "rprpp/Error.h"
+
+#include <fstream>
+#include <sstream>
+
+constexpr uint32_t MaxCubeLutSize = 256;
+
+namespace rprpp::filters {
+
+CubeLut parseCubeLut(std::istream& stream)
+{
+    CubeLut lut;
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+
+        if (keyword == "TITLE") {
+            continue;
+        }
+
+        if (keyword == "LUT_1D_SIZE") {
+            throw InvalidParameter("lut", "1D LUTs are not supported");
+        }
+
+        if (keyword == "LUT_3D_SIZE") {
+            if (!(tokens >> lut.size) || lut.size < 2 || lut.size > MaxCubeLutSize) {
+                throw InvalidParameter("lut", "LUT_3D_SIZE has to be in range [2, 256]");
+            }
+            lut.data.reserve(size_t(lut.size) * lut.size * lut.size * 3);
+            continue;
+        }
+
+        if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX") {
+            float* domain = keyword == "DOMAIN_MIN" ? lut.domainMin : lut.domainMax;
+            if (!(tokens >> domain[0] >> domain[1] >> domain[2])) {
+                throw InvalidParameter("lut", keyword + " should contain 3 values");
+            }
+            continue;
+        }
+
+        // everything else is a table row
+        std::istringstream row(line);
+        float r, g, b;
+        if (!(row >> r >> g >> b)) {
+            throw InvalidParameter("lut", "unexpected line: " + line);
+        }
+        lut.data.push_back(r);
+        lut.data.push_back(g);
+        lut.data.push_back(b);
+    }
+
+    if (lut.size == 0) {
+        throw InvalidParameter("lut", "LUT_3D_SIZE is missing");
+    }
+
+    if (lut.data.size() != size_t(lut.size) * lut.size * lut.size * 3) {
+        throw InvalidParameter("lut", "number of entries doesn't match LUT_3D_SIZE");
+    }
+
+    for (int i = 0; i < 3; i++) {
+        if (lut.domainMax[i] <= lut.domainMin[i]) {
+            throw InvalidParameter("lut", "DOMAIN_MAX has to be greater than DOMAIN_MIN");
+        }
+    }
+
+    return lut;
+}
+
+CubeLut readCubeLut(const std::filesystem::path& path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        throw InvalidParameter("path", "cannot open " + path.string());
+    }
+
+    return parseCubeLut(file);
+}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <vector>
+
+namespace rprpp::filters {
+
+// 3D LUT in .cube format, red index changes fastest
+struct CubeLut {
+    uint32_t size = 0;
+    float domainMin[3] = { 0.0f, 0.0f, 0.0f };
+    float domainMax[3] = { 1.0f, 1.0f, 1.0f };
+    std::vector<float> data; // rgb triplets
+};
+
+CubeLut parseCubeLut(std::istream& stream);
+CubeLut readCubeLut(const std::filesystem::path& path);
+
+}
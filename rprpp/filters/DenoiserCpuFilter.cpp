@@ -8,15 +8,17 @@ namespace rprpp::filters {
 
 DenoiserCpuFilter::DenoiserCpuFilter(Context* context, oidn::DeviceRef& device)
     : DenoiserFilter(context, device)
+    , m_copyInputsFence(deviceContext().device.createFence({}))
 {
 }
 
-vk::Semaphore DenoiserCpuFilter::run(std::optional<vk::Semaphore> waitSemaphore)
+void DenoiserCpuFilter::submit(const SubmitSync& sync)
 {
     validateInputsAndOutput();
 
     if (m_dirty) {
-        deviceContext().queue.waitIdle();
+        // the copy command buffers are recorded again and the staging buffers are replaced
+        waitSubmittedRuns();
         m_filter.release();
         m_colorBuffer.release();
         m_albedoBuffer.release();
@@ -28,17 +30,14 @@ vk::Semaphore DenoiserCpuFilter::run(std::optional<vk::Semaphore> waitSemaphore)
         m_dirty = false;
     }
 
-    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
-    vk::SubmitInfo submitInfo;
-    submitInfo.setCommandBuffers(*m_copyInputsCommands.get());
-    if (waitSemaphore.has_value()) {
-        submitInfo.setWaitDstStageMask(waitStage);
-        submitInfo.setWaitSemaphores(waitSemaphore.value());
+    SubmitSync copyInputsSync { sync.waits, {}, *m_copyInputsFence };
+    copyInputsSync.submit(deviceContext(), deviceContext().queue, *m_copyInputsCommands.get(), vk::PipelineStageFlagBits::eAllCommands);
+    vk::Result result = deviceContext().device.waitForFences(*m_copyInputsFence, vk::True, UINT64_MAX);
+    deviceContext().device.resetFences(*m_copyInputsFence);
+    if (result != vk::Result::eSuccess) {
+        throw InternalError("copy of the denoiser inputs hasn't finished");
     }
 
-    deviceContext().queue.submit(submitInfo);
-    deviceContext().queue.waitIdle();
-
     m_filter.execute();
     const char* errorMessage;
     if (m_device.getError(errorMessage) != oidn::Error::None) {
@@ -46,12 +45,8 @@ vk::Semaphore DenoiserCpuFilter::run(std::optional<vk::Semaphore> waitSemaphore)
         throw InternalError(std::string("oidn error: ") + errorMessage);
     }
 
-    submitInfo = vk::SubmitInfo();
-    submitInfo.setCommandBuffers(*m_copyOutputCommand.get());
-    submitInfo.setSignalSemaphores(*m_finishedSemaphore);
-    deviceContext().queue.submit(submitInfo);
-
-    return *m_finishedSemaphore;
+    SubmitSync copyOutputSync { {}, sync.signals, sync.fence };
+    copyOutputSync.submit(deviceContext(), deviceContext().queue, *m_copyOutputCommand.get(), vk::PipelineStageFlagBits::eAllCommands);
 }
 
 std::unique_ptr<Buffer> DenoiserCpuFilter::createStagingBufferFor(Image* image)
@@ -64,6 +59,8 @@ std::unique_ptr<Buffer> DenoiserCpuFilter::createStagingBufferFor(Image* image)
 
 void DenoiserCpuFilter::initialize()
 {
+    // the staging buffers stay mapped, so oidn keeps using the same memory and the filter is committed
+    // only here, when an image and so the size or format might have changed
     m_stagingColorBuffer = std::move(createStagingBufferFor(m_input));
 
     m_copyOutputCommand.get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
@@ -71,6 +68,9 @@ void DenoiserCpuFilter::initialize()
     m_copyOutputCommand.get().end();
 
     m_copyInputsCommands.get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
+    // the output copy of the previous run reads the color staging buffer, waiting for the inputs waits for it too
+    vk::MemoryBarrier stagingBarrier(vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferWrite);
+    m_copyInputsCommands.get().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, stagingBarrier, nullptr, nullptr);
     copyImageToBuffer(m_copyInputsCommands, m_input, m_stagingColorBuffer.get());
     if (m_albedo && m_normal) {
         m_stagingAlbedoBuffer = std::move(createStagingBufferFor(m_albedo));
@@ -17,11 +17,14 @@ namespace rprpp::filters {
 class DenoiserCpuFilter : public DenoiserFilter {
 public:
     explicit DenoiserCpuFilter(Context* context, oidn::DeviceRef& device);
-    vk::Semaphore run(std::optional<vk::Semaphore> waitSemaphore) override;
+    void submit(const SubmitSync& sync) override;
 
 private:
     void initialize();
     static std::unique_ptr<Buffer> createStagingBufferFor(Image* image);
+
+    // signaled once the inputs are in the staging buffers, oidn reads them on the host
+    vk::raii::Fence m_copyInputsFence;
 };
 
 }
\ No newline at end of file
@@ -9,7 +9,6 @@ namespace rprpp::filters {
 DenoiserFilter::DenoiserFilter(Context* context, oidn::DeviceRef& device)
     : Filter(context)
     , m_device(device)
-    , m_finishedSemaphore(deviceContext().device.createSemaphore({}))
     , m_copyInputsCommands(&deviceContext())
     , m_copyOutputCommand(&deviceContext())
 {
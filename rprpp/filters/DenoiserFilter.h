@@ -43,7 +43,6 @@ protected:
     Image* m_albedo = nullptr;
     Image* m_normal = nullptr;
     Image* m_output = nullptr;
-    vk::raii::Semaphore m_finishedSemaphore;
     vk::helper::CommandBuffer m_copyInputsCommands;
     vk::helper::CommandBuffer m_copyOutputCommand;
 };
@@ -11,12 +11,12 @@ DenoiserGpuFilter::DenoiserGpuFilter(Context* context, oidn::DeviceRef& device)
 {
 }
 
-vk::Semaphore DenoiserGpuFilter::run(std::optional<vk::Semaphore> waitSemaphore)
+void DenoiserGpuFilter::submit(const SubmitSync& sync)
 {
     validateInputsAndOutput();
 
     if (m_dirty) {
-        deviceContext().queue.waitIdle();
+        deviceContext().waitIdle(deviceContext().queue);
         m_filter.release();
         m_colorBuffer.release();
         m_albedoBuffer.release();
@@ -28,16 +28,9 @@ vk::Semaphore DenoiserGpuFilter::run(std::optional<vk::Semaphore> waitSemaphore)
         m_dirty = false;
     }
 
-    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
-    vk::SubmitInfo submitInfo;
-    submitInfo.setCommandBuffers(*m_copyInputsCommands.get());
-    if (waitSemaphore.has_value()) {
-        submitInfo.setWaitDstStageMask(waitStage);
-        submitInfo.setWaitSemaphores(waitSemaphore.value());
-    }
-
-    deviceContext().queue.submit(submitInfo);
-    deviceContext().queue.waitIdle();
+    SubmitSync copyInputsSync { sync.waits, {} };
+    copyInputsSync.submit(deviceContext(), deviceContext().queue, *m_copyInputsCommands.get(), vk::PipelineStageFlagBits::eAllCommands);
+    deviceContext().waitIdle(deviceContext().queue);
 
     m_filter.execute();
     const char* errorMessage;
@@ -46,12 +39,8 @@ vk::Semaphore DenoiserGpuFilter::run(std::optional<vk::Semaphore> waitSemaphore)
         throw InternalError(std::string("oidn error: ") + errorMessage);
     }
 
-    submitInfo = vk::SubmitInfo();
-    submitInfo.setCommandBuffers(*m_copyOutputCommand.get());
-    submitInfo.setSignalSemaphores(*m_finishedSemaphore);
-    deviceContext().queue.submit(submitInfo);
-
-    return *m_finishedSemaphore;
+    SubmitSync copyOutputSync { {}, sync.signals, sync.fence };
+    copyOutputSync.submit(deviceContext(), deviceContext().queue, *m_copyOutputCommand.get(), vk::PipelineStageFlagBits::eAllCommands);
 }
 
 std::unique_ptr<Buffer> DenoiserGpuFilter::createStagingBufferFor(Image* image)
@@ -17,7 +17,7 @@ namespace rprpp::filters {
 class DenoiserGpuFilter : public DenoiserFilter {
 public:
     explicit DenoiserGpuFilter(Context* context, oidn::DeviceRef& device);
-    vk::Semaphore run(std::optional<vk::Semaphore> waitSemaphore) override;
+    void submit(const SubmitSync& sync) override;
 
 private:
     void initialize();
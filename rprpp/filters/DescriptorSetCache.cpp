@@ -0,0 +1,102 @@
+#include "DescriptorSetCache.h"
+#include "rprpp/Context.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace rprpp::filters {
+
+DescriptorSetCache::DescriptorSetCache(Context* context, uint32_t framesInFlight, size_t capacity)
+    : m_context(context)
+    , m_capacity(capacity)
+    , m_poolCapacity(capacity * (framesInFlight + 1))
+{
+}
+
+vk::DescriptorSet DescriptorSetCache::get(const std::vector<boost::uuids::uuid>& key, vk::DescriptorSetLayout layout, vk::helper::DescriptorBuilder& builder)
+{
+    if (layout != m_layout) {
+        clear();
+        m_layout = layout;
+    }
+
+    markFrontUsed();
+    freeRetired();
+
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->key == key) {
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            return *m_entries.front().descriptorSet;
+        }
+    }
+
+    if (m_entries.size() >= m_capacity) {
+        m_retiredEntries.splice(m_retiredEntries.end(), m_entries, std::prev(m_entries.end()));
+    }
+
+    if (m_entries.size() + m_retiredEntries.size() >= m_poolCapacity) {
+        // the retired sets are used by the frames still in flight, the sets are written again into a new pool
+        retirePool();
+    }
+
+    const vk::raii::Device& device = m_context->deviceContext().device;
+    if (!m_descriptorPool.has_value()) {
+        // every set of the pool has the same bindings
+        std::vector<vk::DescriptorPoolSize> poolSizes = builder.poolSizes();
+        for (vk::DescriptorPoolSize& poolSize : poolSizes) {
+            poolSize.descriptorCount *= static_cast<uint32_t>(m_poolCapacity);
+        }
+        m_descriptorPool = device.createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, static_cast<uint32_t>(m_poolCapacity), poolSizes));
+    }
+
+    vk::raii::DescriptorSet descriptorSet = std::move(vk::raii::DescriptorSets(device, vk::DescriptorSetAllocateInfo(*m_descriptorPool.value(), layout)).front());
+    builder.updateDescriptorSet(*descriptorSet);
+    device.updateDescriptorSets(builder.writes(), nullptr);
+    m_entries.push_front(Entry { key, std::move(descriptorSet), m_context->timelineValue() });
+    return *m_entries.front().descriptorSet;
+}
+
+void DescriptorSetCache::clear()
+{
+    markFrontUsed();
+    retirePool();
+    m_layout = nullptr;
+    freeRetired();
+}
+
+void DescriptorSetCache::retirePool()
+{
+    if (m_descriptorPool.has_value()) {
+        uint64_t lastUse = 0;
+        for (const Entry& entry : m_entries) {
+            lastUse = std::max(lastUse, entry.lastUse);
+        }
+        for (const Entry& entry : m_retiredEntries) {
+            lastUse = std::max(lastUse, entry.lastUse);
+        }
+
+        m_retiredEntries.splice(m_retiredEntries.end(), m_entries);
+        m_retiredPools.push_back(RetiredPool { std::move(m_descriptorPool.value()), std::move(m_retiredEntries), lastUse });
+        m_descriptorPool.reset();
+        m_retiredEntries.clear();
+    }
+
+    m_entries.clear();
+}
+
+void DescriptorSetCache::markFrontUsed()
+{
+    // the bound set is used by every frame submitted until it is replaced
+    if (!m_entries.empty()) {
+        m_entries.front().lastUse = m_context->timelineValue();
+    }
+}
+
+void DescriptorSetCache::freeRetired()
+{
+    uint64_t completedValue = m_context->completedTimelineValue();
+    std::erase_if(m_retiredEntries, [&](const Entry& entry) { return entry.lastUse <= completedValue; });
+    std::erase_if(m_retiredPools, [&](const RetiredPool& pool) { return pool.lastUse <= completedValue; });
+}
+
+}
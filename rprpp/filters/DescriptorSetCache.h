@@ -0,0 +1,66 @@
+#pragma once
+
+#include "rprpp/vk/DescriptorBuilder.h"
+#include "rprpp/vk/vk.h"
+
+#include <boost/uuid/uuid.hpp>
+
+#include <list>
+#include <optional>
+#include <vector>
+
+namespace rprpp {
+class Context;
+}
+
+namespace rprpp::filters {
+
+// descriptor sets of a filter keyed by the tags of the bound images, so binding images that were bound before
+// (ping-pong or a rotation of output images) only selects an already written set.
+// every other resource of the sets is the same, clear() has to be called when one of them changes.
+// frames in flight might still use dropped sets, they are freed once the context timeline passes their last use
+class DescriptorSetCache {
+public:
+    static constexpr size_t DefaultCapacity = 8;
+
+    DescriptorSetCache(Context* context, uint32_t framesInFlight, size_t capacity = DefaultCapacity);
+
+    // builder writes a new set only if there is no set for key, the least recently used set is dropped when the cache is full.
+    // another layout drops all the sets
+    [[nodiscard]] vk::DescriptorSet get(const std::vector<boost::uuids::uuid>& key, vk::DescriptorSetLayout layout, vk::helper::DescriptorBuilder& builder);
+    void clear();
+
+private:
+    struct Entry {
+        std::vector<boost::uuids::uuid> key;
+        vk::raii::DescriptorSet descriptorSet;
+        // timeline value signaled once no submitted frame uses the set anymore
+        uint64_t lastUse = 0;
+    };
+
+    struct RetiredPool {
+        vk::raii::DescriptorPool descriptorPool;
+        // freed before the pool
+        std::list<Entry> entries;
+        uint64_t lastUse = 0;
+    };
+
+    void markFrontUsed();
+    // the pool and all of its sets are freed once the frames in flight are done with them
+    void retirePool();
+    void freeRetired();
+
+    Context* m_context;
+    // live sets of one pool, the pool has room for the sets dropped during the frames in flight too
+    size_t m_capacity;
+    size_t m_poolCapacity;
+    vk::DescriptorSetLayout m_layout;
+    std::optional<vk::raii::DescriptorPool> m_descriptorPool;
+    // the most recently used first, sets are freed before the pool
+    std::list<Entry> m_entries;
+    // dropped sets of m_descriptorPool, the oldest first
+    std::list<Entry> m_retiredEntries;
+    std::list<RetiredPool> m_retiredPools;
+};
+
+}
@@ -1,10 +1,50 @@
 #include "Filter.h"
+#include "rprpp/Context.h"
 
 namespace rprpp::filters {
 
 Filter::Filter(Context* context)
     : ContextObject(context)
 {
+    for (uint32_t i = 0; i < context->framesInFlight(); i++) {
+        m_finishedSemaphores.push_back(deviceContext().device.createSemaphore({}));
+    }
 }
 
-} // namespace rprpp::filters
\ No newline at end of file
+vk::Semaphore Filter::run(std::optional<vk::Semaphore> waitSemaphore)
+{
+    SubmitSync sync;
+    if (waitSemaphore.has_value()) {
+        sync.waits.push_back({ waitSemaphore.value() });
+    }
+
+    vk::Semaphore finishedSemaphore = *m_finishedSemaphores[m_finishedSemaphoreIndex];
+    sync.signals.push_back({ finishedSemaphore });
+    // the context timeline tells when resources used by this run can be freed
+    uint64_t value = context()->nextTimelineValue();
+    sync.signals.push_back({ context()->timelineSemaphore(), value });
+    submit(sync);
+    setSubmittedTimelineValue(value);
+
+    m_finishedSemaphoreIndex = (m_finishedSemaphoreIndex + 1) % static_cast<uint32_t>(m_finishedSemaphores.size());
+    return finishedSemaphore;
+}
+
+uint64_t Filter::run(const std::vector<TimelinePoint>& waits, const std::vector<TimelinePoint>& signals)
+{
+    uint64_t value = context()->nextTimelineValue();
+    SubmitSync sync { waits, signals };
+    sync.signals.push_back({ context()->timelineSemaphore(), value });
+    submit(sync);
+    setSubmittedTimelineValue(value);
+    return value;
+}
+
+void Filter::waitSubmittedRuns()
+{
+    if (m_submittedTimelineValue != 0) {
+        context()->waitTimelineValue(m_submittedTimelineValue, UINT64_MAX);
+    }
+}
+
+} // namespace rprpp::filters
@@ -2,6 +2,10 @@
 #include "rprpp/vk/vk.h"
 
 #include "rprpp/ContextObject.h"
+#include "rprpp/SubmitSync.h"
+
+#include <optional>
+#include <vector>
 
 namespace rprpp {
 class Image;
@@ -12,9 +16,30 @@ namespace rprpp::filters {
 class Filter : public ContextObject {
 public:
     explicit Filter(Context* context);
-    virtual vk::Semaphore run(std::optional<vk::Semaphore> waitSemaphore) = 0;
+
+    // returns a binary semaphore of the filter's ring, it has to be waited before the ring comes around, the context timeline is signaled too
+    vk::Semaphore run(std::optional<vk::Semaphore> waitSemaphore);
+    // signals the context timeline semaphore and the binary semaphores of signals, returns the signaled timeline value
+    uint64_t run(const std::vector<TimelinePoint>& waits, const std::vector<TimelinePoint>& signals = {});
+    // waits and signals exactly the semaphores of sync
+    virtual void submit(const SubmitSync& sync) = 0;
+
     virtual void setInput(Image* image) = 0;
     virtual void setOutput(Image* image) = 0;
+
+    // context timeline value signaled once the last submitted run has finished, 0 if nothing was submitted
+    [[nodiscard]] uint64_t submittedTimelineValue() const noexcept { return m_submittedTimelineValue; }
+    // set by run() and by the pipeline running the filter, after submission
+    void setSubmittedTimelineValue(uint64_t value) noexcept { m_submittedTimelineValue = value; }
+
+protected:
+    // waits for the runs submitted so far, resources they use can be freed or rewritten after it
+    void waitSubmittedRuns();
+
+private:
+    std::vector<vk::raii::Semaphore> m_finishedSemaphores;
+    uint32_t m_finishedSemaphoreIndex = 0;
+    uint64_t m_submittedTimelineValue = 0;
 };
 
-}
\ No newline at end of file
+}
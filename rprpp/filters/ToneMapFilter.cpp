@@ -1,34 +1,150 @@
 #include "ToneMapFilter.h"
+#include "rprpp/Context.h"
 #include "rprpp/Error.h"
 #include "rprpp/vk/DescriptorBuilder.h"
+#include "rprpp/vk/vk_helper.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
 
 constexpr int WorkgroupSize = 32;
+constexpr uint32_t BakedLutSize = 65;
+constexpr float LutLogMin = -12.0f;
+constexpr float LutLogMax = 8.0f;
+constexpr int ExposureWorkgroupSize = 16;
+constexpr int HistogramSize = 256;
+constexpr float ExposureMinLog = -12.0f;
+constexpr float ExposureLogRange = 20.0f;
 
 namespace rprpp::filters {
 
+static std::array<vk::SpecializationMapEntry, 3> featureSpecializationEntries()
+{
+    return {
+        vk::SpecializationMapEntry(0, offsetof(ToneMapFeatures, vignetting), sizeof(vk::Bool32)),
+        vk::SpecializationMapEntry(1, offsetof(ToneMapFeatures, crushBlacks), sizeof(vk::Bool32)),
+        vk::SpecializationMapEntry(2, offsetof(ToneMapFeatures, gamma), sizeof(vk::Bool32)),
+    };
+}
+
+static vk::SamplerCreateInfo createLutSamplerInfo()
+{
+    vk::SamplerCreateInfo samplerInfo;
+    samplerInfo.magFilter = vk::Filter::eLinear;
+    samplerInfo.minFilter = vk::Filter::eLinear;
+    samplerInfo.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+    samplerInfo.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+
+    return samplerInfo;
+}
+
+// values out of half range are clamped, denormals are flushed to zero
+static uint16_t toHalf(float value)
+{
+    if (std::isnan(value)) {
+        return 0;
+    }
+
+    uint32_t bits = std::bit_cast<uint32_t>(std::clamp(value, -65504.0f, 65504.0f));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = int((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+    if (exponent <= 0) {
+        return static_cast<uint16_t>(sign);
+    }
+
+    uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    // round to nearest
+    if (mantissa & 0x1000) {
+        half++;
+    }
+    return static_cast<uint16_t>(half);
+}
+
+// must match the analytic part of tonemap.comp after exposure
+static void toneMapCurve(float color[3], float burnHighlights, float saturation, float crushBlacks, float invGamma)
+{
+    const float luminanceWeight[3] = { 0.176204f, 0.812985f, 0.0108109f };
+    auto luminance = [&]() {
+        return color[0] * luminanceWeight[0] + color[1] * luminanceWeight[1] + color[2] * luminanceWeight[2];
+    };
+
+    float rgbl = luminance();
+    for (int i = 0; i < 3; i++) {
+        color[i] *= (rgbl * burnHighlights + 1.0f) / (rgbl + 1.0f);
+    }
+
+    float wl = luminance();
+    for (int i = 0; i < 3; i++) {
+        color[i] = wl + saturation * (color[i] - wl);
+    }
+
+    if (crushBlacks > 1.0f) {
+        float intens = luminance();
+        if (intens < 1.0f) {
+            float sqrtIntens = sqrtf(std::max(intens, 0.0f));
+            for (int i = 0; i < 3; i++) {
+                float crushed = powf(std::max(color[i], 0.0f), crushBlacks);
+                color[i] = crushed + sqrtIntens * (color[i] - crushed);
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        color[i] = powf(std::max(color[i], 0.0f), invGamma);
+    }
+}
+
 ToneMapFilter::ToneMapFilter(Context* context)
-    : Filter(context)
-    , m_finishedSemaphore(deviceContext().device.createSemaphore({}))
-    , m_ubo(context)
-    , m_commandBuffer(&deviceContext())
+    : ComputeFilter(context)
+    , m_ubo(context, framesInFlight())
+    , m_descriptorSets(context, framesInFlight())
+    , m_lutSampler(deviceContext().device, createLutSamplerInfo())
+    , m_exposureBuffer(std::make_unique<Buffer>(context, sizeof(float), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent))
+    , m_histogramBuffer(std::make_unique<Buffer>(context, framesInFlight() * HistogramSize * sizeof(uint32_t), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal))
+{
+    m_mappedExposure = static_cast<const float*>(m_exposureBuffer->map(sizeof(float)));
+}
+
+std::unordered_map<std::string, std::string> ToneMapFilter::macroDefinitions() const
 {
+    return macroDefinitions(m_output->description().format, m_input->description().format, m_mode, m_params.autoExposure);
 }
 
-void ToneMapFilter::createShaderModule()
+std::unordered_map<std::string, std::string> ToneMapFilter::macroDefinitions(ImageFormat outputFormat, ImageFormat inputFormat, ToneMapMode mode, bool autoExposure)
 {
-    const std::unordered_map<std::string, std::string> macroDefinitions = {
-        { "OUTPUT_FORMAT", to_glslformat(m_output->description().format) },
-        { "INPUT_FORMAT", to_glslformat(m_input->description().format) },
+    std::unordered_map<std::string, std::string> macroDefinitions = {
+        { "OUTPUT_FORMAT", to_glslformat(outputFormat) },
+        { "INPUT_FORMAT", to_glslformat(inputFormat) },
         { "WORKGROUP_SIZE", std::to_string(WorkgroupSize) },
     };
-    m_shaderModule = m_shaderManager.getToneMapShader(deviceContext().device, macroDefinitions);
+    if (mode == ToneMapMode::eLut) {
+        macroDefinitions["LUT"] = "";
+    }
+    if (autoExposure) {
+        macroDefinitions["AUTO_EXPOSURE"] = "";
+    }
+
+    return macroDefinitions;
+}
+
+std::unordered_map<std::string, std::string> ToneMapFilter::exposureMacroDefinitions(std::unordered_map<std::string, std::string> macroDefinitions, const std::string& pass)
+{
+    macroDefinitions["WORKGROUP_SIZE"] = std::to_string(ExposureWorkgroupSize);
+    macroDefinitions["HISTOGRAM_SIZE"] = std::to_string(HistogramSize);
+    macroDefinitions[pass] = "";
+    return macroDefinitions;
 }
 
 void ToneMapFilter::createDescriptorSet()
 {
     vk::helper::DescriptorBuilder builder;
     vk::DescriptorBufferInfo uboDescriptorInfo(m_ubo.buffer(), 0, m_ubo.size()); // binding 0
-    builder.bindUniformBuffer(&uboDescriptorInfo);
+    builder.bindDynamicUniformBuffer(&uboDescriptorInfo);
 
     vk::DescriptorImageInfo outputDescriptorInfo(nullptr, *m_output->view(), m_output->layout()); // binding 1
     builder.bindStorageImage(&outputDescriptorInfo);
@@ -36,35 +152,323 @@ void ToneMapFilter::createDescriptorSet()
     vk::DescriptorImageInfo inputDescriptorInfo(nullptr, *m_input->view(), m_input->layout()); // binding 2
     builder.bindStorageImage(&inputDescriptorInfo);
 
-    const std::vector<vk::DescriptorPoolSize>& poolSizes = builder.poolSizes();
-    m_descriptorSetLayout = deviceContext().device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, builder.bindings()));
-    m_descriptorPool = deviceContext().device.createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, 1, poolSizes));
-    m_descriptorSet = std::move(vk::raii::DescriptorSets(deviceContext().device, vk::DescriptorSetAllocateInfo(*m_descriptorPool.value(), *m_descriptorSetLayout.value())).front());
+    vk::DescriptorBufferInfo exposureDescriptorInfo(m_exposureBuffer->get(), 0, m_exposureBuffer->size()); // binding 3
+    builder.bindStorageBuffer(&exposureDescriptorInfo);
+
+    vk::DescriptorBufferInfo histogramDescriptorInfo(m_histogramBuffer->get(), 0, m_histogramBuffer->size()); // binding 4
+    builder.bindStorageBuffer(&histogramDescriptorInfo);
+
+    std::optional<vk::DescriptorImageInfo> lutDescriptorInfo;
+    if (m_mode == ToneMapMode::eLut) {
+        lutDescriptorInfo = vk::DescriptorImageInfo(*m_lutSampler, *m_lutView.value(), vk::ImageLayout::eShaderReadOnlyOptimal); // binding 5
+        builder.bindCombinedImageSampler(&lutDescriptorInfo.value());
+    }
 
-    builder.updateDescriptorSet(*m_descriptorSet.value());
-    deviceContext().device.updateDescriptorSets(builder.writes(), nullptr);
+    // the LUT and the exposure buffers don't change between sets, the cache is cleared when the LUT is recreated
+    m_descriptorSetLayout = context()->pipelineRegistry().descriptorSetLayout(builder.bindings());
+    m_descriptorSet = m_descriptorSets.get({ m_output->tag(), m_input->tag() }, m_descriptorSetLayout, builder);
 }
 
-void ToneMapFilter::recordComputeCommandBuffer()
+void ToneMapFilter::record(const vk::raii::CommandBuffer& commandBuffer)
 {
     uint32_t x = m_output->description().width;
     uint32_t y = m_output->description().height;
 
-    m_commandBuffer.get().begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
-    m_commandBuffer.get().bindPipeline(vk::PipelineBindPoint::eCompute, *m_computePipeline.value());
-    m_commandBuffer.get().bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipelineLayout.value(), 0, *m_descriptorSet.value(), nullptr);
-    m_commandBuffer.get().dispatch((uint32_t)ceil(x / float(WorkgroupSize)), (uint32_t)ceil(y / float(WorkgroupSize)), 1);
-    m_commandBuffer.get().end();
+    if (m_params.autoExposure) {
+        recordAutoExposureCommands(commandBuffer);
+    }
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_computePipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+    commandBuffer.dispatch((uint32_t)ceil(x / float(WorkgroupSize)), (uint32_t)ceil(y / float(WorkgroupSize)), 1);
+}
+
+void ToneMapFilter::recordAutoExposureCommands(const vk::raii::CommandBuffer& commandBuffer)
+{
+    uint32_t x = m_input->description().width;
+    uint32_t y = m_input->description().height;
+
+    std::vector<vk::BufferMemoryBarrier> clearedBarriers;
+    if (m_recordExposureReset) {
+        // the previous run might still read the exposure, the next adapt pass starts from the target value
+        vk::BufferMemoryBarrier resetBarrier(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+            vk::AccessFlagBits::eTransferWrite,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            m_exposureBuffer->get(),
+            0,
+            m_exposureBuffer->size());
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, resetBarrier, nullptr);
+        commandBuffer.fillBuffer(m_exposureBuffer->get(), 0, m_exposureBuffer->size(), 0);
+
+        resetBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        resetBarrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+        clearedBarriers.push_back(resetBarrier);
+    }
+
+    // every frame in flight has its own histogram, the one of this frame was last used by the run
+    // framesInFlight runs ago, which has finished like the ubo of this frame, so the runs in flight don't wait for each other
+    vk::DeviceSize histogramSize = HistogramSize * sizeof(uint32_t);
+    vk::DeviceSize histogramOffset = frameIndex() * histogramSize;
+    commandBuffer.fillBuffer(m_histogramBuffer->get(), histogramOffset, histogramSize, 0);
+
+    vk::BufferMemoryBarrier histogramBarrier(vk::AccessFlagBits::eTransferWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        m_histogramBuffer->get(),
+        histogramOffset,
+        histogramSize);
+    clearedBarriers.push_back(histogramBarrier);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, clearedBarriers, nullptr);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_histogramComputePipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, 0, m_descriptorSet, m_ubo.offset(frameIndex()));
+    commandBuffer.dispatch((uint32_t)ceil(x / float(ExposureWorkgroupSize)), (uint32_t)ceil(y / float(ExposureWorkgroupSize)), 1);
+
+    histogramBarrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite);
+    histogramBarrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, histogramBarrier, nullptr);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_adaptComputePipeline);
+    commandBuffer.dispatch(1, 1, 1);
+
+    vk::BufferMemoryBarrier exposureBarrier(vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        m_exposureBuffer->get(),
+        0,
+        m_exposureBuffer->size());
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, exposureBarrier, nullptr);
 }
 
 void ToneMapFilter::createComputePipeline()
 {
-    vk::PipelineLayoutCreateInfo pipelineLayoutInfo({}, *m_descriptorSetLayout.value());
-    m_pipelineLayout = vk::raii::PipelineLayout(deviceContext().device, pipelineLayoutInfo);
+    PipelineRegistry& registry = context()->pipelineRegistry();
+    m_pipelineLayout = registry.pipelineLayout({ m_descriptorSetLayout });
+
+    m_pipelineFeatures = features();
+    const std::array<vk::SpecializationMapEntry, 3> specializationEntries = featureSpecializationEntries();
+    vk::SpecializationInfo specializationInfo(static_cast<uint32_t>(specializationEntries.size()), specializationEntries.data(), sizeof(ToneMapFeatures), &m_pipelineFeatures);
+
+    m_pipelineMacroDefinitions = macroDefinitions();
+    m_computePipeline = registry.computePipeline("tonemap", m_pipelineMacroDefinitions, m_pipelineLayout, &specializationInfo);
+
+    if (m_params.autoExposure) {
+        m_histogramComputePipeline = registry.computePipeline("tonemap_exposure", exposureMacroDefinitions(m_pipelineMacroDefinitions, "HISTOGRAM"), m_pipelineLayout);
+        m_adaptComputePipeline = registry.computePipeline("tonemap_exposure", exposureMacroDefinitions(m_pipelineMacroDefinitions, "ADAPT"), m_pipelineLayout);
+    }
+}
+
+ToneMapFeatures ToneMapFilter::features() const noexcept
+{
+    ToneMapFeatures features;
+    features.vignetting = m_params.vignetting != 0.0f;
+    // both are baked into the LUT
+    features.crushBlacks = m_mode == ToneMapMode::eAnalytic && m_params.crushBlacks > 0.0f;
+    features.gamma = m_mode == ToneMapMode::eAnalytic && m_params.invGamma != 1.0f;
+    return features;
+}
+
+void ToneMapFilter::updateUniforms()
+{
+    ToneMapUniforms& uniforms = m_ubo.data();
+
+    float cm2DivWhitepoint[3];
+    for (int i = 0; i < 3; i++) {
+        cm2DivWhitepoint[i] = m_params.whitepoint[i] > 0.0f ? 1.0f / m_params.whitepoint[i] : 1.0f;
+    }
+
+    // auto exposure is applied on GPU
+    float scale = m_params.autoExposure ? 1.0f : m_params.cm2Factor;
+    if (!m_params.autoExposure && m_params.filmIso > 0.0f) {
+        scale *= 18.0f / (106.0f * 15.4f) * m_params.filmIso;
+        scale /= m_params.cameraShutter * m_params.fNumber * m_params.fNumber;
+    }
+
+    // divided by CIE luminance of linear RGB
+    scale /= cm2DivWhitepoint[0] * 0.176204f + cm2DivWhitepoint[1] * 0.812985f + cm2DivWhitepoint[2] * 0.0108109f;
+    for (int i = 0; i < 3; i++) {
+        uniforms.scale[i] = cm2DivWhitepoint[i] * scale;
+    }
+
+    float width = static_cast<float>(m_output->description().width);
+    float height = static_cast<float>(m_output->description().height);
+    uniforms.vignettingExponent = m_params.vignetting * 0.5f;
+    uniforms.invResolution[0] = 1.0f / width;
+    uniforms.invResolution[1] = 1.0f / height;
+    uniforms.invAspectRatio = height / width;
+    uniforms.focalLengthSq = m_params.focalLength * m_params.focalLength;
+    uniforms.apertureSq = m_params.aperture * m_params.aperture;
+    uniforms.burnHighlights = std::max(m_params.burnHighlights, 0.0001f); // magic to avoid problems with inverse
+    uniforms.saturation = m_params.saturation;
+    uniforms.crushBlacks = m_params.crushBlacks + m_params.crushBlacks + 1.0f;
+    uniforms.invGamma = m_params.invGamma;
+
+    uniforms.lutSize = static_cast<float>(std::max(m_lutSize, 1u));
+    if (m_cubeLut.has_value()) {
+        uniforms.lutLogEncoded = 0;
+        uniforms.lutShaperBias = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            uniforms.lutDomainScale[i] = 1.0f / (m_cubeLut->domainMax[i] - m_cubeLut->domainMin[i]);
+            uniforms.lutDomainOffset[i] = -m_cubeLut->domainMin[i] * uniforms.lutDomainScale[i];
+        }
+    } else {
+        uniforms.lutLogEncoded = 1;
+        uniforms.lutShaperBias = exp2f(LutLogMin);
+        for (int i = 0; i < 3; i++) {
+            uniforms.lutDomainScale[i] = 1.0f / (LutLogMax - LutLogMin);
+            uniforms.lutDomainOffset[i] = -LutLogMin * uniforms.lutDomainScale[i];
+        }
+    }
+
+    uniforms.exposureMinLog = ExposureMinLog;
+    uniforms.exposureLogRange = ExposureLogRange;
+    uniforms.exposurePercentile = std::clamp(m_params.exposurePercentile, 0.0f, 1.0f);
+    uniforms.exposureAdaptation = std::clamp(m_params.exposureAdaptation, 0.0f, 1.0f);
+    uniforms.exposureKey = std::max(m_params.exposureKey, 0.0f);
+    uniforms.histogramOffset = static_cast<int>(frameIndex()) * HistogramSize;
+}
+
+void ToneMapFilter::updateLut()
+{
+    if (m_cubeLut.has_value()) {
+        if (m_lutDirty) {
+            uploadLut(m_cubeLut->size, m_cubeLut->data);
+            m_bakedCurve.reset();
+        }
+    } else {
+        std::array<float, 4> curve = { m_params.burnHighlights, m_params.saturation, m_params.crushBlacks, m_params.invGamma };
+        if (m_lutDirty || m_bakedCurve != curve) {
+            std::vector<float> rgb;
+            bakeLut(rgb);
+            uploadLut(BakedLutSize, rgb);
+            m_bakedCurve = curve;
+        }
+    }
+    m_lutDirty = false;
+}
+
+void ToneMapFilter::bakeLut(std::vector<float>& rgb) const
+{
+    float burnHighlights = std::max(m_params.burnHighlights, 0.0001f);
+    float crushBlacks = m_params.crushBlacks + m_params.crushBlacks + 1.0f;
+    float shaperBias = exp2f(LutLogMin);
+    float step = (LutLogMax - LutLogMin) / float(BakedLutSize - 1);
+
+    // inverse of the log shaper, the first entry maps exactly to black
+    std::vector<float> grid(BakedLutSize);
+    for (uint32_t i = 0; i < BakedLutSize; i++) {
+        grid[i] = std::max(exp2f(LutLogMin + i * step) - shaperBias, 0.0f);
+    }
+
+    rgb.resize(size_t(BakedLutSize) * BakedLutSize * BakedLutSize * 3);
+    size_t index = 0;
+    for (uint32_t b = 0; b < BakedLutSize; b++) {
+        for (uint32_t g = 0; g < BakedLutSize; g++) {
+            for (uint32_t r = 0; r < BakedLutSize; r++) {
+                float color[3] = { grid[r], grid[g], grid[b] };
+                toneMapCurve(color, burnHighlights, m_params.saturation, crushBlacks, m_params.invGamma);
+                rgb[index++] = color[0];
+                rgb[index++] = color[1];
+                rgb[index++] = color[2];
+            }
+        }
+    }
+}
+
+void ToneMapFilter::uploadLut(uint32_t size, const std::vector<float>& rgb)
+{
+    uint64_t completedValue = context()->completedTimelineValue();
+    std::erase_if(m_retiredLuts, [&](const RetiredLut& lut) { return lut.lastUse <= completedValue; });
+
+    if (m_lutSize != size) {
+        // the previous LUT might still be in use by its upload or the runs in flight
+        if (m_lutImage.has_value()) {
+            uint64_t lastUse = std::max(submittedTimelineValue(), m_lutUploadValue);
+            m_retiredLuts.push_back({ std::move(m_lutView.value()), std::move(m_lutImage.value()), std::move(m_lutMemory.value()), lastUse });
+        }
+        m_descriptorSets.clear();
+        m_lutView.reset();
+        m_lutImage.reset();
+        m_lutMemory.reset();
+
+        vk::ImageCreateInfo imageInfo({},
+            vk::ImageType::e3D,
+            vk::Format::eR16G16B16A16Sfloat,
+            { size, size, size },
+            1,
+            1,
+            vk::SampleCountFlagBits::e1,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+            vk::SharingMode::eExclusive,
+            nullptr,
+            vk::ImageLayout::eUndefined);
+        m_lutImage = vk::raii::Image(deviceContext().device, imageInfo);
+
+        vk::MemoryRequirements memRequirements = m_lutImage->getMemoryRequirements();
+        m_lutMemory = context()->memoryAllocator().allocate(memRequirements, vk::MemoryPropertyFlagBits::eDeviceLocal, false);
+        m_lutImage->bindMemory(m_lutMemory->memory(), m_lutMemory->offset());
+
+        vk::ImageViewCreateInfo viewInfo({},
+            *m_lutImage.value(),
+            vk::ImageViewType::e3D,
+            vk::Format::eR16G16B16A16Sfloat,
+            {},
+            { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 });
+        m_lutView = vk::raii::ImageView(deviceContext().device, viewInfo);
+
+        m_lutSize = size;
+        m_descriptorsDirty = true;
+        m_ubo.markDirty();
+    }
+
+    // offsets of buffer to image copies have to be a multiple of the texel size and 4
+    size_t texelsCount = size_t(size) * size * size;
+    StagingRing::Allocation staging = context()->stagingRing().allocate(texelsCount * 4 * sizeof(uint16_t), 8);
+    uint16_t* mappedTexels = static_cast<uint16_t*>(staging.data);
+    for (size_t i = 0; i < texelsCount; i++) {
+        mappedTexels[4 * i + 0] = toHalf(rgb[3 * i + 0]);
+        mappedTexels[4 * i + 1] = toHalf(rgb[3 * i + 1]);
+        mappedTexels[4 * i + 2] = toHalf(rgb[3 * i + 2]);
+        mappedTexels[4 * i + 3] = toHalf(1.0f);
+    }
 
-    vk::PipelineShaderStageCreateInfo shaderStageInfo({}, vk::ShaderStageFlagBits::eCompute, *m_shaderModule.value(), "main");
-    vk::ComputePipelineCreateInfo pipelineInfo({}, shaderStageInfo, *m_pipelineLayout.value());
-    m_computePipeline = deviceContext().device.createComputePipeline(nullptr, pipelineInfo);
+    // the filter is submitted to the same queue after the upload, so the last barrier makes the LUT visible to it
+    // without waiting on the host
+    vk::Image lutImage = *m_lutImage.value();
+    m_lutUploadValue = context()->submitStagingCopy([&](const vk::raii::CommandBuffer& commandBuffer) {
+        vk::ImageSubresourceRange subresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+        {
+            // previous content is discarded, it only has to wait for the reads of the previous run
+            vk::ImageMemoryBarrier barrier({},
+                vk::AccessFlagBits::eTransferWrite,
+                vk::ImageLayout::eUndefined,
+                vk::ImageLayout::eTransferDstOptimal,
+                VK_QUEUE_FAMILY_IGNORED,
+                VK_QUEUE_FAMILY_IGNORED,
+                lutImage,
+                subresourceRange);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barrier);
+        }
+        {
+            vk::ImageSubresourceLayers imageSubresource(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+            vk::BufferImageCopy region(staging.offset, 0, 0, imageSubresource, { 0, 0, 0 }, { size, size, size });
+            commandBuffer.copyBufferToImage(staging.buffer, lutImage, vk::ImageLayout::eTransferDstOptimal, region);
+        }
+        {
+            vk::ImageMemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite,
+                vk::AccessFlagBits::eShaderRead,
+                vk::ImageLayout::eTransferDstOptimal,
+                vk::ImageLayout::eShaderReadOnlyOptimal,
+                VK_QUEUE_FAMILY_IGNORED,
+                VK_QUEUE_FAMILY_IGNORED,
+                lutImage,
+                subresourceRange);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
+        }
+    }).value;
 }
 
 void ToneMapFilter::validateInputsAndOutput()
@@ -88,40 +492,73 @@ void ToneMapFilter::validateInputsAndOutput()
     }
 }
 
-vk::Semaphore ToneMapFilter::run(std::optional<vk::Semaphore> waitSemaphore)
+void ToneMapFilter::prepare()
 {
     validateInputsAndOutput();
 
+    if (m_mode == ToneMapMode::eLut) {
+        updateLut();
+    }
+
+    // the reset is recorded into the commands of the next run only, the runs in flight keep their exposure
+    if (m_exposureDirty || m_recordExposureReset) {
+        m_recordExposureReset = m_exposureDirty && m_params.autoExposure;
+        m_exposureDirty = false;
+        markCommandsDirty();
+    }
+
     if (m_descriptorsDirty) {
-        m_computePipeline.reset();
-        m_pipelineLayout.reset();
-        m_descriptorSet.reset();
-        m_descriptorPool.reset();
-        m_descriptorSetLayout.reset();
-        m_shaderModule.reset();
-
-        createShaderModule();
+        vk::DescriptorSetLayout descriptorSetLayout = m_descriptorSetLayout;
         createDescriptorSet();
-        createComputePipeline();
-        recordComputeCommandBuffer();
+        // images of the same formats are rebound without touching the pipelines
+        if (m_descriptorSetLayout != descriptorSetLayout || macroDefinitions() != m_pipelineMacroDefinitions || features() != m_pipelineFeatures) {
+            createComputePipeline();
+        }
+        markCommandsDirty();
         m_descriptorsDirty = false;
+    } else if (features() != m_pipelineFeatures) {
+        // only toggling a feature needs another pipeline, value changes go through the ubo
+        createComputePipeline();
+        markCommandsDirty();
     }
 
-    if (m_ubo.dirty()) {
-        m_ubo.update();
+    if (m_ubo.dirty(frameIndex())) {
+        updateUniforms();
+        m_ubo.update(frameIndex());
     }
+}
+
+Image* ToneMapFilter::output() const noexcept
+{
+    return m_output;
+}
+
+FilterAccesses ToneMapFilter::accesses() const
+{
+    // the exposure and the histogram are only touched by the filter
+    return { .readImages = { m_input }, .writtenImages = { m_output } };
+}
 
-    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
-    vk::SubmitInfo submitInfo;
-    if (waitSemaphore.has_value()) {
-        submitInfo.setWaitDstStageMask(waitStage);
-        submitInfo.setWaitSemaphores(waitSemaphore.value());
+std::optional<PointwiseStage> ToneMapFilter::pointwiseStage() const
+{
+    // the histogram is built from the whole input before any pixel is tonemapped
+    if (m_params.autoExposure) {
+        return std::nullopt;
     }
 
-    submitInfo.setSignalSemaphores(*m_finishedSemaphore);
-    submitInfo.setCommandBuffers(*m_commandBuffer.get());
-    deviceContext().queue.submit(submitInfo);
-    return *m_finishedSemaphore;
+    const std::array<vk::SpecializationMapEntry, 3> specializationEntries = featureSpecializationEntries();
+    const auto* features = reinterpret_cast<const uint8_t*>(&m_pipelineFeatures);
+
+    PointwiseStage stage;
+    stage.shader = { "tonemap", macroDefinitions() };
+    stage.descriptorSetLayout = m_descriptorSetLayout;
+    stage.descriptorSet = m_descriptorSet;
+    stage.dynamicOffsetStride = m_ubo.stride();
+    stage.specializationEntries.assign(specializationEntries.begin(), specializationEntries.end());
+    stage.specializationData.assign(features, features + sizeof(ToneMapFeatures));
+    stage.input = m_input;
+    stage.output = m_output;
+    return stage;
 }
 
 void ToneMapFilter::setInput(Image* image)
@@ -134,142 +571,259 @@ void ToneMapFilter::setOutput(Image* image)
 {
     m_output = image;
     m_descriptorsDirty = true;
+    // resolution is folded into the ubo
+    m_ubo.markDirty();
 }
 
 void ToneMapFilter::setGamma(float gamma) noexcept
 {
-    m_ubo.data().invGamma = 1.0f / (gamma > 0.00001f ? gamma : 1.0f);
+    m_params.invGamma = 1.0f / (gamma > 0.00001f ? gamma : 1.0f);
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setWhitepoint(float x, float y, float z) noexcept
 {
-    m_ubo.data().whitepoint[0] = x;
-    m_ubo.data().whitepoint[1] = y;
-    m_ubo.data().whitepoint[2] = z;
+    m_params.whitepoint[0] = x;
+    m_params.whitepoint[1] = y;
+    m_params.whitepoint[2] = z;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setVignetting(float vignetting) noexcept
 {
-    m_ubo.data().vignetting = vignetting;
+    m_params.vignetting = vignetting;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setCrushBlacks(float crushBlacks) noexcept
 {
-    m_ubo.data().crushBlacks = crushBlacks;
+    m_params.crushBlacks = crushBlacks;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setBurnHighlights(float burnHighlights) noexcept
 {
-    m_ubo.data().burnHighlights = burnHighlights;
+    m_params.burnHighlights = burnHighlights;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setSaturation(float saturation) noexcept
 {
-    m_ubo.data().saturation = saturation;
+    m_params.saturation = saturation;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setCm2Factor(float cm2Factor) noexcept
 {
-    m_ubo.data().cm2Factor = cm2Factor;
+    m_params.cm2Factor = cm2Factor;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setFilmIso(float filmIso) noexcept
 {
-    m_ubo.data().filmIso = filmIso;
+    m_params.filmIso = filmIso;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setCameraShutter(float cameraShutter) noexcept
 {
-    m_ubo.data().cameraShutter = cameraShutter;
+    m_params.cameraShutter = cameraShutter;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setFNumber(float fNumber) noexcept
 {
-    m_ubo.data().fNumber = fNumber;
+    m_params.fNumber = fNumber;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setFocalLength(float focalLength) noexcept
 {
-    m_ubo.data().focalLength = focalLength;
+    m_params.focalLength = focalLength;
     m_ubo.markDirty();
 }
 
 void ToneMapFilter::setAperture(float aperture) noexcept
 {
-    m_ubo.data().aperture = aperture;
+    m_params.aperture = aperture;
+    m_ubo.markDirty();
+}
+
+void ToneMapFilter::setMode(ToneMapMode mode) noexcept
+{
+    m_mode = mode;
+    m_descriptorsDirty = true;
+}
+
+void ToneMapFilter::setAutoExposure(bool autoExposure) noexcept
+{
+    if (m_params.autoExposure != autoExposure) {
+        m_params.autoExposure = autoExposure;
+        m_descriptorsDirty = true;
+        m_exposureDirty = true;
+        m_ubo.markDirty();
+    }
+}
+
+void ToneMapFilter::setAutoExposurePercentile(float percentile) noexcept
+{
+    m_params.exposurePercentile = percentile;
+    m_ubo.markDirty();
+}
+
+void ToneMapFilter::setAutoExposureAdaptation(float adaptation) noexcept
+{
+    m_params.exposureAdaptation = adaptation;
+    m_ubo.markDirty();
+}
+
+void ToneMapFilter::setAutoExposureKey(float key) noexcept
+{
+    m_params.exposureKey = key;
+    m_ubo.markDirty();
+}
+
+void ToneMapFilter::setCubeLut(const std::filesystem::path& path)
+{
+    if (path.empty()) {
+        m_cubeLut.reset();
+    } else {
+        m_cubeLut = readCubeLut(path);
+    }
+    m_lutDirty = true;
     m_ubo.markDirty();
 }
 
 float ToneMapFilter::getGamma() const noexcept
 {
-    return 1.0f / (m_ubo.data().invGamma > 0.00001f ? m_ubo.data().invGamma : 1.0f);
+    return 1.0f / (m_params.invGamma > 0.00001f ? m_params.invGamma : 1.0f);
 }
 
 void ToneMapFilter::getWhitepoint(float& x, float& y, float& z) const noexcept
 {
-    x = m_ubo.data().whitepoint[0];
-    y = m_ubo.data().whitepoint[1];
-    z = m_ubo.data().whitepoint[2];
+    x = m_params.whitepoint[0];
+    y = m_params.whitepoint[1];
+    z = m_params.whitepoint[2];
 }
 
 float ToneMapFilter::getVignetting() const noexcept
 {
-    return m_ubo.data().vignetting;
+    return m_params.vignetting;
 }
 
 float ToneMapFilter::getCrushBlacks() const noexcept
 {
-    return m_ubo.data().crushBlacks;
+    return m_params.crushBlacks;
 }
 
 float ToneMapFilter::getBurnHighlights() const noexcept
 {
-    return m_ubo.data().burnHighlights;
+    return m_params.burnHighlights;
 }
 
 float ToneMapFilter::getSaturation() const noexcept
 {
-    return m_ubo.data().saturation;
+    return m_params.saturation;
 }
 
 float ToneMapFilter::getCm2Factor() const noexcept
 {
-    return m_ubo.data().cm2Factor;
+    return m_params.cm2Factor;
 }
 
 float ToneMapFilter::getFilmIso() const noexcept
 {
-    return m_ubo.data().filmIso;
+    return m_params.filmIso;
 }
 
 float ToneMapFilter::getCameraShutter() const noexcept
 {
-    return m_ubo.data().cameraShutter;
+    return m_params.cameraShutter;
 }
 
 float ToneMapFilter::getFNumber() const noexcept
 {
-    return m_ubo.data().fNumber;
+    return m_params.fNumber;
 }
 
 float ToneMapFilter::getFocalLength() const noexcept
 {
-    return m_ubo.data().focalLength;
+    return m_params.focalLength;
 }
 
 float ToneMapFilter::getAperture() const noexcept
 {
-    return m_ubo.data().aperture;
+    return m_params.aperture;
+}
+
+ToneMapMode ToneMapFilter::getMode() const noexcept
+{
+    return m_mode;
+}
+
+bool ToneMapFilter::getAutoExposure() const noexcept
+{
+    return m_params.autoExposure;
+}
+
+float ToneMapFilter::getAutoExposurePercentile() const noexcept
+{
+    return m_params.exposurePercentile;
+}
+
+float ToneMapFilter::getAutoExposureAdaptation() const noexcept
+{
+    return m_params.exposureAdaptation;
+}
+
+float ToneMapFilter::getAutoExposureKey() const noexcept
+{
+    return m_params.exposureKey;
+}
+
+float ToneMapFilter::getExposure() const
+{
+    return *m_mappedExposure;
+}
+
+std::vector<PrewarmTask> ToneMapFilter::prewarmTasks(Context* context, ImageFormat outputFormat, ImageFormat inputFormat)
+{
+    PipelineRegistry* registry = &context->pipelineRegistry();
+    std::vector<PrewarmTask> tasks;
+    for (ToneMapMode mode : { ToneMapMode::eAnalytic, ToneMapMode::eLut }) {
+        // the same bindings as createDescriptorSet() gives
+        vk::helper::DescriptorBuilder builder;
+        builder.bindDynamicUniformBuffer(nullptr);
+        builder.bindStorageImage(nullptr);
+        builder.bindStorageImage(nullptr);
+        builder.bindStorageBuffer(nullptr);
+        builder.bindStorageBuffer(nullptr);
+        if (mode == ToneMapMode::eLut) {
+            builder.bindCombinedImageSampler(nullptr);
+        }
+        vk::PipelineLayout pipelineLayout = registry->pipelineLayout({ registry->descriptorSetLayout(builder.bindings()) });
+
+        for (bool autoExposure : { false, true }) {
+            std::unordered_map<std::string, std::string> macros = macroDefinitions(outputFormat, inputFormat, mode, autoExposure);
+            tasks.push_back([registry, pipelineLayout, macros] {
+                // nothing is switched on by the default parameters
+                ToneMapFeatures features;
+                const std::array<vk::SpecializationMapEntry, 3> specializationEntries = featureSpecializationEntries();
+                vk::SpecializationInfo specializationInfo(static_cast<uint32_t>(specializationEntries.size()), specializationEntries.data(), sizeof(ToneMapFeatures), &features);
+                (void)registry->computePipeline("tonemap", macros, pipelineLayout, &specializationInfo);
+            });
+
+            if (autoExposure) {
+                for (const char* pass : { "HISTOGRAM", "ADAPT" }) {
+                    tasks.push_back([registry, pipelineLayout, exposureMacros = exposureMacroDefinitions(macros, pass)] {
+                        (void)registry->computePipeline("tonemap_exposure", exposureMacros, pipelineLayout);
+                    });
+                }
+            }
+        }
+    }
+
+    return tasks;
 }
 
 }
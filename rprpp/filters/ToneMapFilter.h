@@ -1,18 +1,35 @@
 #pragma once
 
-#include "Filter.h"
+#include "CubeLut.h"
+#include "ComputeFilter.h"
+#include "DescriptorSetCache.h"
+#include "rprpp/Buffer.h"
 #include "rprpp/Image.h"
 #include "rprpp/UniformObjectBuffer.h"
 #include "rprpp/vk/CommandBuffer.h"
 #include "rprpp/vk/DeviceContext.h"
 #include "rprpp/vk/ShaderManager.h"
 
+#include <array>
+#include <filesystem>
 #include <memory>
 #include <optional>
 #include <vector>
 
 namespace rprpp::filters {
 
+// lut mode bakes everything after exposure and vignetting into a 3D LUT, so the per-pixel pass is a single trilinear fetch.
+// baked LUT is indexed by log2(color + 2^LutLogMin) to spend its resolution evenly on stops,
+// user LUT from a .cube file replaces the baked one and is indexed linearly within its domain.
+
+// auto exposure replaces filmIso, cameraShutter and cm2Factor: a log luminance histogram of the input is built on GPU,
+// exposure maps the configured percentile to the key value and adapts towards it every run without any readback.
+
+enum class ToneMapMode {
+    eAnalytic = 0,
+    eLut = 1,
+};
+
 struct ToneMapParams {
     float whitepoint[3] = { 1.0f, 1.0f, 1.0f };
     float vignetting = 0.0f;
@@ -26,13 +43,56 @@ struct ToneMapParams {
     float focalLength = 1.0f;
     float aperture = 0.024f;
     float invGamma = 1.0f;
+    bool autoExposure = false;
+    float exposurePercentile = 0.5f;
+    float exposureAdaptation = 0.05f;
+    float exposureKey = 0.18f;
+};
+
+// per-frame constants folded on the host, must match UBO of tonemap.comp (std140)
+struct ToneMapUniforms {
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+    float vignettingExponent = 0.0f;
+    float invResolution[2] = { 1.0f, 1.0f };
+    float invAspectRatio = 1.0f;
+    float focalLengthSq = 1.0f;
+    float apertureSq = 1.0f;
+    float burnHighlights = 1.0f;
+    float saturation = 1.0f;
+    float crushBlacks = 1.0f;
+    float invGamma = 1.0f;
+    float lutSize = 1.0f;
+    int lutLogEncoded = 0;
+    float lutShaperBias = 0.0f;
+    float lutDomainScale[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+    float lutDomainOffset[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float exposureMinLog = 0.0f;
+    float exposureLogRange = 1.0f;
+    float exposurePercentile = 0.5f;
+    float exposureAdaptation = 1.0f;
+    float exposureKey = 0.18f;
+    // histogram of the frame in flight the ubo belongs to
+    int histogramOffset = 0;
 };
 
-class ToneMapFilter : public Filter {
+// disabled features are compiled out through specialization constants of tonemap.comp
+struct ToneMapFeatures {
+    vk::Bool32 vignetting = VK_FALSE;
+    vk::Bool32 crushBlacks = VK_FALSE;
+    vk::Bool32 gamma = VK_FALSE;
+
+    bool operator==(const ToneMapFeatures&) const = default;
+};
+
+class ToneMapFilter : public ComputeFilter {
 public:
     explicit ToneMapFilter(Context* context);
 
-    vk::Semaphore run(std::optional<vk::Semaphore> waitSemaphore) override;
+    void prepare() override;
+    void record(const vk::raii::CommandBuffer& commandBuffer) override;
+    [[nodiscard]] Image* output() const noexcept override;
+    [[nodiscard]] FilterAccesses accesses() const override;
+    [[nodiscard]] std::optional<PointwiseStage> pointwiseStage() const override;
 
     void setInput(Image* img) override;
     void setOutput(Image* img) override;
@@ -49,6 +109,15 @@ public:
     void setFNumber(float fNumber) noexcept;
     void setFocalLength(float focalLength) noexcept;
     void setAperture(float aperture) noexcept;
+    void setMode(ToneMapMode mode) noexcept;
+    void setAutoExposure(bool autoExposure) noexcept;
+    // fraction of pixels darker than the one exposed to the key value
+    void setAutoExposurePercentile(float percentile) noexcept;
+    // part of the difference in stops covered every run, 1 means no adaptation
+    void setAutoExposureAdaptation(float adaptation) noexcept;
+    void setAutoExposureKey(float key) noexcept;
+    // empty path switches back to the baked LUT
+    void setCubeLut(const std::filesystem::path& path);
 
     float getGamma() const noexcept;
     void getWhitepoint(float& x, float& y, float& z) const noexcept;
@@ -62,27 +131,73 @@ public:
     float getFNumber() const noexcept;
     float getFocalLength() const noexcept;
     float getAperture() const noexcept;
+    ToneMapMode getMode() const noexcept;
+    bool getAutoExposure() const noexcept;
+    float getAutoExposurePercentile() const noexcept;
+    float getAutoExposureAdaptation() const noexcept;
+    float getAutoExposureKey() const noexcept;
+    // last exposure written by GPU, doesn't wait for the runs in flight, 0 until auto exposure has run
+    float getExposure() const;
+
+    // pipelines for both modes with and without auto exposure, with the features of the default parameters
+    [[nodiscard]] static std::vector<PrewarmTask> prewarmTasks(Context* context, ImageFormat outputFormat, ImageFormat inputFormat);
 
 private:
+    // LUT replaced by one of another size, freed once the runs that sampled it have finished
+    struct RetiredLut {
+        vk::raii::ImageView view;
+        vk::raii::Image image;
+        MemoryAllocation memory;
+        uint64_t lastUse = 0;
+    };
+
     void validateInputsAndOutput();
-    void createShaderModule();
+    std::unordered_map<std::string, std::string> macroDefinitions() const;
+    static std::unordered_map<std::string, std::string> macroDefinitions(ImageFormat outputFormat, ImageFormat inputFormat, ToneMapMode mode, bool autoExposure);
+    // pass is HISTOGRAM or ADAPT
+    static std::unordered_map<std::string, std::string> exposureMacroDefinitions(std::unordered_map<std::string, std::string> macroDefinitions, const std::string& pass);
     void createDescriptorSet();
     void createComputePipeline();
-    void recordComputeCommandBuffer();
+    void recordAutoExposureCommands(const vk::raii::CommandBuffer& commandBuffer);
+    void updateUniforms();
+    void updateLut();
+    void bakeLut(std::vector<float>& rgb) const;
+    void uploadLut(uint32_t size, const std::vector<float>& rgb);
+    [[nodiscard]] ToneMapFeatures features() const noexcept;
 
     bool m_descriptorsDirty = true;
+    ToneMapParams m_params;
+    ToneMapFeatures m_pipelineFeatures;
+    ToneMapMode m_mode = ToneMapMode::eAnalytic;
+    std::optional<CubeLut> m_cubeLut;
+    // burnHighlights, saturation, crushBlacks and invGamma the current LUT is baked with
+    std::optional<std::array<float, 4>> m_bakedCurve;
+    bool m_lutDirty = true;
+    bool m_exposureDirty = true;
+    bool m_recordExposureReset = false;
     Image* m_input = nullptr;
     Image* m_output = nullptr;
-    vk::helper::ShaderManager m_shaderManager;
-    vk::raii::Semaphore m_finishedSemaphore;
-    UniformObjectBuffer<ToneMapParams> m_ubo;
-    vk::helper::CommandBuffer m_commandBuffer;
-    std::optional<vk::raii::ShaderModule> m_shaderModule;
-    std::optional<vk::raii::DescriptorSetLayout> m_descriptorSetLayout;
-    std::optional<vk::raii::DescriptorPool> m_descriptorPool;
-    std::optional<vk::raii::DescriptorSet> m_descriptorSet;
-    std::optional<vk::raii::PipelineLayout> m_pipelineLayout;
-    std::optional<vk::raii::Pipeline> m_computePipeline;
+    UniformObjectBuffer<ToneMapUniforms> m_ubo;
+    // layouts and pipelines are owned by the context's pipeline registry
+    vk::DescriptorSetLayout m_descriptorSetLayout;
+    DescriptorSetCache m_descriptorSets;
+    vk::DescriptorSet m_descriptorSet;
+    vk::PipelineLayout m_pipelineLayout;
+    vk::Pipeline m_computePipeline;
+    std::unordered_map<std::string, std::string> m_pipelineMacroDefinitions;
+    vk::raii::Sampler m_lutSampler;
+    uint32_t m_lutSize = 0;
+    std::optional<vk::raii::Image> m_lutImage;
+    std::optional<MemoryAllocation> m_lutMemory;
+    std::optional<vk::raii::ImageView> m_lutView;
+    // main timeline value signaled by the last upload
+    uint64_t m_lutUploadValue = 0;
+    std::vector<RetiredLut> m_retiredLuts;
+    std::unique_ptr<Buffer> m_exposureBuffer;
+    const float* m_mappedExposure = nullptr;
+    std::unique_ptr<Buffer> m_histogramBuffer;
+    vk::Pipeline m_histogramComputePipeline;
+    vk::Pipeline m_adaptComputePipeline;
 };
 
 } // namespace rprpp
\ No newline at end of file
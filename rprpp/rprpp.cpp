@@ -3,11 +3,14 @@
 #include "Context.h"
 #include "Error.h"
 #include "vk/DeviceContext.h"
+#include "vk/ShaderCache.h"
 
 #include <cassert>
+#include <filesystem>
 #include <functional>
 #include <mutex>
 #include <optional>
+#include <vector>
 #include <type_traits>
 
 #include <boost/log/trivial.hpp>
@@ -125,11 +128,55 @@ void getDeviceInfo(unsigned int deviceId, RprPpDeviceInfo info, void* data, size
         }
         break;
     }
+    case RPRPP_DEVICE_INFO_SUPPORT_HALF_PRECISION: {
+        const size_t len = sizeof(unsigned int);
+        static_assert(len == 4);
+
+        if (sizeRet != nullptr) {
+            *sizeRet = len;
+        }
+
+        if (data != nullptr && len <= size) {
+            unsigned int supportHalfPrecision = vk::helper::supportHalfPrecision(physicalDevice)
+                ? RPRPP_TRUE
+                : RPRPP_FALSE;
+            std::memcpy(data, &supportHalfPrecision, len);
+        }
+        break;
+    }
     default:
         throw rprpp::InvalidParameter("deviceInfo", "Not supported device info type");
     }
 }
 
+static std::vector<rprpp::TimelinePoint> toTimelinePoints(const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount)
+{
+    if (waitCount > 0 && (waitSemaphores == nullptr || waitValues == nullptr)) {
+        throw rprpp::InvalidParameter("waitSemaphores and waitValues", "cannot be null when waitCount isn't 0");
+    }
+
+    std::vector<rprpp::TimelinePoint> waits;
+    for (unsigned int i = 0; i < waitCount; i++) {
+        waits.push_back({ static_cast<vk::Semaphore>(static_cast<VkSemaphore>(waitSemaphores[i])), waitValues[i] });
+    }
+
+    return waits;
+}
+
+static std::vector<rprpp::TimelinePoint> toBinarySignals(const RprPpVkSemaphore* signalSemaphores, unsigned int signalCount)
+{
+    if (signalCount > 0 && signalSemaphores == nullptr) {
+        throw rprpp::InvalidParameter("signalSemaphores", "cannot be null when signalCount isn't 0");
+    }
+
+    std::vector<rprpp::TimelinePoint> signals;
+    for (unsigned int i = 0; i < signalCount; i++) {
+        signals.push_back({ static_cast<vk::Semaphore>(static_cast<VkSemaphore>(signalSemaphores[i])) });
+    }
+
+    return signals;
+}
+
 template <class Function,
     class... Params>
 [[nodiscard("Please, don't ignore result")]] inline auto safeCall(Function function, Params&&... params) noexcept -> std::expected<std::invoke_result_t<Function, Params&&...>, RprPpError>
@@ -174,6 +221,26 @@ RprPpError rprppSetLogVerbosity(const char* verbosityLevel)
     return RPRPP_SUCCESS;
 }
 
+RprPpError rprppSetShaderCacheDirectory(const char* directory)
+{
+    auto result = safeCall([&] {
+        vk::helper::ShaderCache::instance().setDirectory(directory != nullptr ? std::filesystem::path(directory) : std::filesystem::path());
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppSetShaderCacheCapacity(uint64_t capacity)
+{
+    auto result = safeCall([&] {
+        vk::helper::ShaderCache::instance().setCapacity(capacity);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
 RprPpError rprppGetDeviceCount(unsigned int* deviceCount)
 {
     auto result = safeCall(vk::helper::getDeviceCount);
@@ -308,6 +375,34 @@ RprPpError rprppContextDestroyFilter(RprPpContext context, RprPpFilter filter)
     return RPRPP_SUCCESS;
 }
 
+RprPpError rprppContextCreatePipeline(RprPpContext context, RprPpPipeline* outPipeline)
+{
+    assert(context);
+    assert(outPipeline);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        *outPipeline = ctx->createPipeline();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextDestroyPipeline(RprPpContext context, RprPpPipeline pipeline)
+{
+    assert(context);
+    assert(pipeline);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->destroyPipeline(static_cast<rprpp::Pipeline*>(pipeline));
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
 RprPpError rprppContextCreateBuffer(RprPpContext context, size_t size, RprPpBuffer* outBuffer)
 {
     assert(context);
@@ -414,178 +509,718 @@ RprPpError rprppContextCopyImageToBuffer(RprPpContext context, RprPpImage image,
     assert(buffer);
 
     auto result = safeCall([&] {
-        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
-        ctx->copyImageToBuffer(static_cast<rprpp::Image*>(image), static_cast<rprpp::Buffer*>(buffer));
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->copyImageToBuffer(static_cast<rprpp::Image*>(image), static_cast<rprpp::Buffer*>(buffer));
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextCopyImage(RprPpContext context, RprPpImage src, RprPpImage dst)
+{
+    assert(context);
+    assert(src);
+    assert(dst);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->copyImage(static_cast<rprpp::Image*>(src), static_cast<rprpp::Image*>(dst));
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextCopyBufferToImageAsync(RprPpContext context, RprPpBuffer buffer, RprPpImage image, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, RprPpVkSemaphore* finishedSemaphore, uint64_t* finishedValue)
+{
+    assert(context);
+    assert(buffer);
+    assert(image);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        rprpp::TimelinePoint finished = ctx->copyBufferToImageAsync(static_cast<rprpp::Buffer*>(buffer), static_cast<rprpp::Image*>(image), toTimelinePoints(waitSemaphores, waitValues, waitCount));
+
+        if (finishedSemaphore != nullptr) {
+            *finishedSemaphore = (VkSemaphore)finished.semaphore;
+        }
+
+        if (finishedValue != nullptr) {
+            *finishedValue = finished.value;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextCopyImageToBufferAsync(RprPpContext context, RprPpImage image, RprPpBuffer buffer, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, RprPpVkSemaphore* finishedSemaphore, uint64_t* finishedValue)
+{
+    assert(context);
+    assert(image);
+    assert(buffer);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        rprpp::TimelinePoint finished = ctx->copyImageToBufferAsync(static_cast<rprpp::Image*>(image), static_cast<rprpp::Buffer*>(buffer), toTimelinePoints(waitSemaphores, waitValues, waitCount));
+
+        if (finishedSemaphore != nullptr) {
+            *finishedSemaphore = (VkSemaphore)finished.semaphore;
+        }
+
+        if (finishedValue != nullptr) {
+            *finishedValue = finished.value;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextUploadImages(RprPpContext context, const RprPpImageUpload* uploads, unsigned int uploadCount, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, RprPpVkSemaphore* finishedSemaphore, uint64_t* finishedValue)
+{
+    assert(context);
+    assert(uploads);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+
+        std::vector<rprpp::ImageUpload> imageUploads;
+        for (unsigned int i = 0; i < uploadCount; i++) {
+            imageUploads.push_back({
+                .image = static_cast<rprpp::Image*>(uploads[i].image),
+                .data = uploads[i].data,
+                .buffer = static_cast<rprpp::Buffer*>(uploads[i].buffer),
+                .offset = uploads[i].offset,
+            });
+        }
+
+        rprpp::TimelinePoint finished = ctx->uploadImages(imageUploads, toTimelinePoints(waitSemaphores, waitValues, waitCount));
+
+        if (finishedSemaphore != nullptr) {
+            *finishedSemaphore = (VkSemaphore)finished.semaphore;
+        }
+
+        if (finishedValue != nullptr) {
+            *finishedValue = finished.value;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextCopyImageAsync(RprPpContext context, RprPpImage src, RprPpImage dst, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, RprPpVkSemaphore* finishedSemaphore, uint64_t* finishedValue)
+{
+    assert(context);
+    assert(src);
+    assert(dst);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        rprpp::TimelinePoint finished = ctx->copyImageAsync(static_cast<rprpp::Image*>(src), static_cast<rprpp::Image*>(dst), toTimelinePoints(waitSemaphores, waitValues, waitCount));
+
+        if (finishedSemaphore != nullptr) {
+            *finishedSemaphore = (VkSemaphore)finished.semaphore;
+        }
+
+        if (finishedValue != nullptr) {
+            *finishedValue = finished.value;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetVkPhysicalDevice(RprPpContext context, RprPpVkPhysicalDevice* physicalDevice)
+{
+    assert(context);
+    assert(physicalDevice);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        *physicalDevice = ctx->getVkPhysicalDevice();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetVkDevice(RprPpContext context, RprPpVkDevice* device)
+{
+    assert(context);
+    assert(device);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        *device = ctx->getVkDevice();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetVkQueue(RprPpContext context, RprPpVkQueue* queue)
+{
+    assert(context);
+    assert(queue);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        *queue = ctx->getVkQueue();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetVkTransferQueue(RprPpContext context, RprPpVkQueue* queue)
+{
+    assert(context);
+    assert(queue);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        *queue = ctx->getVkTransferQueue();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetVkAsyncComputeQueue(RprPpContext context, RprPpVkQueue* queue)
+{
+    assert(context);
+    assert(queue);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        *queue = ctx->getVkAsyncComputeQueue();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextWaitQueueIdle(RprPpContext context)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->waitQueueIdle();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextSetFramesInFlight(RprPpContext context, unsigned int framesInFlight)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->setFramesInFlight(framesInFlight);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetFramesInFlight(RprPpContext context, unsigned int* framesInFlight)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+
+        if (framesInFlight != nullptr) {
+            *framesInFlight = ctx->framesInFlight();
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextSetImagePoolCapacity(RprPpContext context, size_t capacity)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->setImagePoolCapacity(capacity);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetImagePoolCapacity(RprPpContext context, size_t* capacity)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+
+        if (capacity != nullptr) {
+            *capacity = ctx->imagePoolCapacity();
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetMemoryStatistics(RprPpContext context, RprPpMemoryStatistics* statistics)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+
+        if (statistics != nullptr) {
+            const rprpp::MemoryStatistics& stats = ctx->memoryStatistics();
+            statistics->blockCount = stats.blockCount;
+            statistics->blockBytes = stats.blockBytes;
+            statistics->allocationCount = stats.allocationCount;
+            statistics->allocationBytes = stats.allocationBytes;
+            statistics->dedicatedAllocationCount = stats.dedicatedAllocationCount;
+            statistics->dedicatedAllocationBytes = stats.dedicatedAllocationBytes;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextSavePipelineCache(RprPpContext context, const char* path)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        if (path == nullptr) {
+            throw rprpp::InvalidParameter("path", "cannot be null");
+        }
+
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->pipelineRegistry().savePipelineCache(path);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextLoadPipelineCache(RprPpContext context, const char* path)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        if (path == nullptr) {
+            throw rprpp::InvalidParameter("path", "cannot be null");
+        }
+
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->pipelineRegistry().loadPipelineCache(path);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextPrewarm(RprPpContext context, const RprPpImageFormat* formats, unsigned int formatCount, RprPpFilterTypeFlags filterTypes)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        if (formats == nullptr && formatCount > 0) {
+            throw rprpp::InvalidParameter("formats", "cannot be null");
+        }
+
+        std::vector<rprpp::ImageFormat> imageFormats;
+        imageFormats.reserve(formatCount);
+        for (unsigned int i = 0; i < formatCount; i++) {
+            imageFormats.push_back(static_cast<rprpp::ImageFormat>(formats[i]));
+        }
+
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->prewarm(imageFormats, filterTypes);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetPrewarmFinished(RprPpContext context, RprPpBool* finished)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+
+        if (finished != nullptr) {
+            *finished = ctx->prewarmFinished() ? 1 : 0;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextWaitPrewarm(RprPpContext context)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        ctx->waitPrewarm();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetTimelineSemaphore(RprPpContext context, RprPpVkSemaphore* timelineSemaphore)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+
+        if (timelineSemaphore != nullptr) {
+            *timelineSemaphore = (VkSemaphore)ctx->timelineSemaphore();
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextGetCompletedTimelineValue(RprPpContext context, uint64_t* value)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+
+        if (value != nullptr) {
+            *value = ctx->completedTimelineValue();
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppContextWaitTimelineValue(RprPpContext context, uint64_t value, uint64_t timeout, RprPpBool* completed)
+{
+    assert(context);
+
+    auto result = safeCall([&] {
+        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
+        bool signaled = ctx->waitTimelineValue(value, timeout);
+
+        if (completed != nullptr) {
+            *completed = signaled ? 1 : 0;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+// Filter
+RprPpError rprppFilterRun(RprPpFilter filter, RprPpVkSemaphore waitSemaphore, RprPpVkSemaphore* finishedSemaphore)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::Filter* f = static_cast<rprpp::filters::Filter*>(filter);
+
+        std::optional<vk::Semaphore> waitSemaphoreOptional;
+        if (waitSemaphore != nullptr) {
+            waitSemaphoreOptional = static_cast<vk::Semaphore>(static_cast<VkSemaphore>(waitSemaphore));
+        }
+
+        *finishedSemaphore = (VkSemaphore)f->run(waitSemaphoreOptional);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppFilterRunTimeline(RprPpFilter filter, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, const RprPpVkSemaphore* signalSemaphores, unsigned int signalCount, uint64_t* signaledValue)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::Filter* f = static_cast<rprpp::filters::Filter*>(filter);
+        uint64_t value = f->run(toTimelinePoints(waitSemaphores, waitValues, waitCount), toBinarySignals(signalSemaphores, signalCount));
+
+        if (signaledValue != nullptr) {
+            *signaledValue = value;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppPipelineAddFilter(RprPpPipeline pipeline, RprPpFilter filter)
+{
+    assert(pipeline);
+
+    auto result = safeCall([&] {
+        rprpp::Pipeline* p = static_cast<rprpp::Pipeline*>(pipeline);
+        p->addFilter(static_cast<rprpp::filters::Filter*>(filter));
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppPipelineClear(RprPpPipeline pipeline)
+{
+    assert(pipeline);
+
+    auto result = safeCall([&] {
+        rprpp::Pipeline* p = static_cast<rprpp::Pipeline*>(pipeline);
+        p->clear();
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppPipelineSetFusion(RprPpPipeline pipeline, RprPpBool fusion)
+{
+    assert(pipeline);
+
+    auto result = safeCall([&] {
+        rprpp::Pipeline* p = static_cast<rprpp::Pipeline*>(pipeline);
+        p->setFusion(fusion != 0);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppPipelineGetFusion(RprPpPipeline pipeline, RprPpBool* fusion)
+{
+    assert(pipeline);
+
+    auto result = safeCall([&] {
+        rprpp::Pipeline* p = static_cast<rprpp::Pipeline*>(pipeline);
+
+        if (fusion != nullptr) {
+            *fusion = p->getFusion() ? 1 : 0;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppPipelineRun(RprPpPipeline pipeline, RprPpVkSemaphore waitSemaphore, RprPpVkSemaphore* finishedSemaphore)
+{
+    assert(pipeline);
+
+    auto result = safeCall([&] {
+        rprpp::Pipeline* p = static_cast<rprpp::Pipeline*>(pipeline);
+
+        std::optional<vk::Semaphore> waitSemaphoreOptional;
+        if (waitSemaphore != nullptr) {
+            waitSemaphoreOptional = static_cast<vk::Semaphore>(static_cast<VkSemaphore>(waitSemaphore));
+        }
+
+        *finishedSemaphore = (VkSemaphore)p->run(waitSemaphoreOptional);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppPipelineRunTimeline(RprPpPipeline pipeline, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, const RprPpVkSemaphore* signalSemaphores, unsigned int signalCount, uint64_t* signaledValue)
+{
+    assert(pipeline);
+
+    auto result = safeCall([&] {
+        rprpp::Pipeline* p = static_cast<rprpp::Pipeline*>(pipeline);
+        uint64_t value = p->run(toTimelinePoints(waitSemaphores, waitValues, waitCount), toBinarySignals(signalSemaphores, signalCount));
+
+        if (signaledValue != nullptr) {
+            *signaledValue = value;
+        }
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppContextCopyImage(RprPpContext context, RprPpImage src, RprPpImage dst)
+RprPpError rprppFilterSetInput(RprPpFilter filter, RprPpImage image)
 {
-    assert(context);
-    assert(src);
-    assert(dst);
+    assert(filter);
 
     auto result = safeCall([&] {
-        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
-        ctx->copyImage(static_cast<rprpp::Image*>(src), static_cast<rprpp::Image*>(dst));
+        rprpp::filters::Filter* f = static_cast<rprpp::filters::Filter*>(filter);
+        f->setInput(static_cast<rprpp::Image*>(image));
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppContextGetVkPhysicalDevice(RprPpContext context, RprPpVkPhysicalDevice* physicalDevice)
+RprPpError rprppFilterSetOutput(RprPpFilter filter, RprPpImage image)
 {
-    assert(context);
-    assert(physicalDevice);
+    assert(filter);
 
     auto result = safeCall([&] {
-        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
-        *physicalDevice = ctx->getVkPhysicalDevice();
+        rprpp::filters::Filter* f = static_cast<rprpp::filters::Filter*>(filter);
+        f->setOutput(static_cast<rprpp::Image*>(image));
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppContextGetVkDevice(RprPpContext context, RprPpVkDevice* device)
+RprPpError rprppBloomFilterSetRadius(RprPpFilter filter, float radius)
 {
-    assert(context);
-    assert(device);
+    assert(filter);
 
     auto result = safeCall([&] {
-        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
-        *device = ctx->getVkDevice();
+        rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
+        f->setRadius(radius);
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppContextGetVkQueue(RprPpContext context, RprPpVkQueue* queue)
+RprPpError rprppBloomFilterSetIntensity(RprPpFilter filter, float intensity)
 {
-    assert(context);
-    assert(queue);
+    assert(filter);
 
     auto result = safeCall([&] {
-        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
-        *queue = ctx->getVkQueue();
+        rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
+        f->setIntensity(intensity);
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppContextWaitQueueIdle(RprPpContext context)
+RprPpError rprppBloomFilterSetThreshold(RprPpFilter filter, float threshold)
 {
-    assert(context);
+    assert(filter);
 
     auto result = safeCall([&] {
-        rprpp::Context* ctx = static_cast<rprpp::Context*>(context);
-        ctx->waitQueueIdle();
+        rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
+        f->setThreshold(threshold);
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-// Filter
-RprPpError rprppFilterRun(RprPpFilter filter, RprPpVkSemaphore waitSemaphore, RprPpVkSemaphore* finishedSemaphore)
+RprPpError rprppBloomFilterSetMode(RprPpFilter filter, RprPpBloomMode mode)
 {
     assert(filter);
 
     auto result = safeCall([&] {
-        rprpp::filters::Filter* f = static_cast<rprpp::filters::Filter*>(filter);
-
-        std::optional<vk::Semaphore> waitSemaphoreOptional;
-        if (waitSemaphore != nullptr) {
-            waitSemaphoreOptional = static_cast<vk::Semaphore>(static_cast<VkSemaphore>(waitSemaphore));
-        }
-
-        *finishedSemaphore = (VkSemaphore)f->run(waitSemaphoreOptional);
+        rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
+        f->setMode(static_cast<rprpp::filters::BloomMode>(mode));
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppFilterSetInput(RprPpFilter filter, RprPpImage image)
+RprPpError rprppBloomFilterSetDownscale(RprPpFilter filter, unsigned int downscale)
 {
     assert(filter);
 
     auto result = safeCall([&] {
-        rprpp::filters::Filter* f = static_cast<rprpp::filters::Filter*>(filter);
-        f->setInput(static_cast<rprpp::Image*>(image));
+        rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
+        f->setDownscale(downscale);
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppFilterSetOutput(RprPpFilter filter, RprPpImage image)
+RprPpError rprppBloomFilterSetFftCrossoverRadius(RprPpFilter filter, unsigned int radius)
 {
     assert(filter);
 
     auto result = safeCall([&] {
-        rprpp::filters::Filter* f = static_cast<rprpp::filters::Filter*>(filter);
-        f->setOutput(static_cast<rprpp::Image*>(image));
+        rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
+        f->setFftCrossoverRadius(radius);
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppBloomFilterSetRadius(RprPpFilter filter, float radius)
+RprPpError rprppBloomFilterGetRadius(RprPpFilter filter, float* radius)
 {
     assert(filter);
 
     auto result = safeCall([&] {
         rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
-        f->setRadius(radius);
+
+        if (radius != nullptr) {
+            *radius = f->getRadius();
+        }
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppBloomFilterSetIntensity(RprPpFilter filter, float intensity)
+RprPpError rprppBloomFilterGetIntensity(RprPpFilter filter, float* intensity)
 {
     assert(filter);
 
     auto result = safeCall([&] {
         rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
-        f->setIntensity(intensity);
+
+        if (intensity != nullptr) {
+            *intensity = f->getIntensity();
+        }
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppBloomFilterSetThreshold(RprPpFilter filter, float threshold)
+RprPpError rprppBloomFilterGetThreshold(RprPpFilter filter, float* threshold)
 {
     assert(filter);
 
     auto result = safeCall([&] {
         rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
-        f->setThreshold(threshold);
+
+        if (threshold != nullptr) {
+            *threshold = f->getThreshold();
+        }
     });
     check(result);
 
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppBloomFilterGetRadius(RprPpFilter filter, float* radius)
+RprPpError rprppBloomFilterGetMode(RprPpFilter filter, RprPpBloomMode* mode)
 {
     assert(filter);
 
     auto result = safeCall([&] {
         rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
 
-        if (radius != nullptr) {
-            *radius = f->getRadius();
+        if (mode != nullptr) {
+            *mode = static_cast<RprPpBloomMode>(f->getMode());
         }
     });
     check(result);
@@ -593,15 +1228,15 @@ RprPpError rprppBloomFilterGetRadius(RprPpFilter filter, float* radius)
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppBloomFilterGetIntensity(RprPpFilter filter, float* intensity)
+RprPpError rprppBloomFilterGetDownscale(RprPpFilter filter, unsigned int* downscale)
 {
     assert(filter);
 
     auto result = safeCall([&] {
         rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
 
-        if (intensity != nullptr) {
-            *intensity = f->getIntensity();
+        if (downscale != nullptr) {
+            *downscale = f->getDownscale();
         }
     });
     check(result);
@@ -609,15 +1244,15 @@ RprPpError rprppBloomFilterGetIntensity(RprPpFilter filter, float* intensity)
     return RPRPP_SUCCESS;
 }
 
-RprPpError rprppBloomFilterGetThreshold(RprPpFilter filter, float* threshold)
+RprPpError rprppBloomFilterGetFftCrossoverRadius(RprPpFilter filter, unsigned int* radius)
 {
     assert(filter);
 
     auto result = safeCall([&] {
         rprpp::filters::BloomFilter* f = static_cast<rprpp::filters::BloomFilter*>(filter);
 
-        if (threshold != nullptr) {
-            *threshold = f->getThreshold();
+        if (radius != nullptr) {
+            *radius = f->getFftCrossoverRadius();
         }
     });
     check(result);
@@ -1257,6 +1892,184 @@ RprPpError rprppToneMapFilterGetGamma(RprPpFilter filter, float* gamma)
     return RPRPP_SUCCESS;
 }
 
+// modes are passed through static_cast in both directions
+static_assert(static_cast<int>(rprpp::filters::ToneMapMode::eAnalytic) == RPRPP_TONEMAP_MODE_ANALYTIC);
+static_assert(static_cast<int>(rprpp::filters::ToneMapMode::eLut) == RPRPP_TONEMAP_MODE_LUT);
+
+RprPpError rprppToneMapFilterSetMode(RprPpFilter filter, RprPpToneMapMode mode)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+        f->setMode(static_cast<rprpp::filters::ToneMapMode>(mode));
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterGetMode(RprPpFilter filter, RprPpToneMapMode* mode)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+
+        if (mode != nullptr) {
+            *mode = static_cast<RprPpToneMapMode>(f->getMode());
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterSetCubeLut(RprPpFilter filter, const char* path)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+        f->setCubeLut(path != nullptr ? std::filesystem::path(path) : std::filesystem::path());
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterSetAutoExposure(RprPpFilter filter, RprPpBool autoExposure)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+        f->setAutoExposure(autoExposure != 0);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterSetAutoExposurePercentile(RprPpFilter filter, float percentile)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+        f->setAutoExposurePercentile(percentile);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterSetAutoExposureAdaptation(RprPpFilter filter, float adaptation)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+        f->setAutoExposureAdaptation(adaptation);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterSetAutoExposureKey(RprPpFilter filter, float key)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+        f->setAutoExposureKey(key);
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterGetAutoExposure(RprPpFilter filter, RprPpBool* autoExposure)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+
+        if (autoExposure != nullptr) {
+            *autoExposure = f->getAutoExposure() ? 1 : 0;
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterGetAutoExposurePercentile(RprPpFilter filter, float* percentile)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+
+        if (percentile != nullptr) {
+            *percentile = f->getAutoExposurePercentile();
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterGetAutoExposureAdaptation(RprPpFilter filter, float* adaptation)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+
+        if (adaptation != nullptr) {
+            *adaptation = f->getAutoExposureAdaptation();
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterGetAutoExposureKey(RprPpFilter filter, float* key)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+
+        if (key != nullptr) {
+            *key = f->getAutoExposureKey();
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
+RprPpError rprppToneMapFilterGetExposure(RprPpFilter filter, float* exposure)
+{
+    assert(filter);
+
+    auto result = safeCall([&] {
+        rprpp::filters::ToneMapFilter* f = static_cast<rprpp::filters::ToneMapFilter*>(filter);
+
+        if (exposure != nullptr) {
+            *exposure = f->getExposure();
+        }
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
 RprPpError rprppDenoiserFilterSetAovAlbedo(RprPpFilter filter, RprPpImage image)
 {
     assert(filter);
@@ -1398,6 +2211,21 @@ RprPpError rprppVkResetFences(RprPpVkDevice rprppDevice, unsigned int fenceCount
     return RPRPP_SUCCESS;
 }
 
+RprPpError rprppVkWaitSemaphores(RprPpVkDevice rprppDevice, unsigned int semaphoreCount, const RprPpVkSemaphore* rprppSemaphores, const uint64_t* pValues, unsigned long long timeout)
+{
+    assert(rprppDevice);
+
+    auto result = safeCall([&] {
+        vk::Device device = static_cast<VkDevice>(rprppDevice);
+        const vk::Semaphore* pSemaphores = reinterpret_cast<const vk::Semaphore*>(rprppSemaphores);
+        vk::SemaphoreWaitInfo waitInfo({}, semaphoreCount, pSemaphores, pValues);
+        vk::resultCheck(device.waitSemaphores(&waitInfo, timeout), "rprppVkWaitSemaphores");
+    });
+    check(result);
+
+    return RPRPP_SUCCESS;
+}
+
 RprPpError rprppVkQueueSubmit(RprPpVkQueue rprppQueue, RprPpVkSubmitInfo rprppSubmitInfo, RprPpVkFence rprppFence)
 {
     assert(rprppQueue);
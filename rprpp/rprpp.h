@@ -11,6 +11,9 @@
 #define RPRPP_API __attribute__((visibility("default")))
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define RPRPP_TRUE 1u
 #define RPRPP_FALSE 0u
 
@@ -29,6 +32,7 @@ typedef enum RprPpDeviceInfo {
     RPRPP_DEVICE_INFO_UUID = 2,
     RPRPP_DEVICE_INFO_SUPPORT_HARDWARE_RAY_TRACING = 3,
     RPRPP_DEVICE_INFO_SUPPORT_GPU_DENOISER = 4,
+    RPRPP_DEVICE_INFO_SUPPORT_HALF_PRECISION = 5,
 } RprPpDeviceInfo;
 
 typedef enum RprPpImageFormat {
@@ -37,9 +41,29 @@ typedef enum RprPpImageFormat {
     RPRPP_IMAGE_FROMAT_B8G8R8A8_UNORM = 2,
 } RprPpImageFormat;
 
+typedef enum RprPpBloomMode {
+    RPRPP_BLOOM_MODE_CONVOLUTION = 0,
+    RPRPP_BLOOM_MODE_PYRAMID = 1,
+} RprPpBloomMode;
+
+typedef enum RprPpToneMapMode {
+    RPRPP_TONEMAP_MODE_ANALYTIC = 0,
+    RPRPP_TONEMAP_MODE_LUT = 1,
+} RprPpToneMapMode;
+
+typedef enum RprPpFilterType {
+    RPRPP_FILTER_TYPE_BLOOM = 0x1,
+    RPRPP_FILTER_TYPE_COMPOSE_COLOR_SHADOW_REFLECTION = 0x2,
+    RPRPP_FILTER_TYPE_COMPOSE_OPACITY_SHADOW = 0x4,
+    RPRPP_FILTER_TYPE_TONEMAP = 0x8,
+} RprPpFilterType;
+
 typedef unsigned int RprPpBool;
+// combination of RprPpFilterType bits
+typedef unsigned int RprPpFilterTypeFlags;
 typedef void* RprPpContext;
 typedef void* RprPpFilter;
+typedef void* RprPpPipeline;
 typedef void* RprPpBuffer;
 typedef void* RprPpImage;
 typedef void* RprPpDx11Handle;
@@ -56,6 +80,25 @@ typedef struct RprPpImageDescription {
     RprPpImageFormat format;
 } RprPpImageDescription;
 
+// pixels of image come either from host memory at data (buffer has to be null) or from buffer at offset
+typedef struct RprPpImageUpload {
+    RprPpImage image;
+    const void* data;
+    RprPpBuffer buffer;
+    size_t offset;
+} RprPpImageUpload;
+
+typedef struct RprPpMemoryStatistics {
+    // device memory objects buffers and images are sub-allocated from
+    uint64_t blockCount;
+    uint64_t blockBytes;
+    uint64_t allocationCount;
+    uint64_t allocationBytes;
+    // device memory objects owned by a single buffer or image: imported, exportable or too large for a block
+    uint64_t dedicatedAllocationCount;
+    uint64_t dedicatedAllocationBytes;
+} RprPpMemoryStatistics;
+
 typedef struct RprPpVkSubmitInfo {
     unsigned int waitSemaphoreCount;
     RprPpVkSemaphore* pWaitSemaphores;
@@ -69,6 +112,12 @@ extern "C" {
 
 RPRPP_API RprPpError rprppSetLogVerbosity(const char* verbosityLevel);
 
+// compiled shaders are kept on disk between processes, by default in RPRPP_SHADER_CACHE_DIR or in the temp directory.
+// null or empty directory disables the disk cache
+RPRPP_API RprPpError rprppSetShaderCacheDirectory(const char* directory);
+// least recently used shaders are removed while the disk cache takes more than capacity bytes
+RPRPP_API RprPpError rprppSetShaderCacheCapacity(uint64_t capacity);
+
 RPRPP_API RprPpError rprppGetDeviceCount(unsigned int* deviceCount);
 RPRPP_API RprPpError rprppGetDeviceInfo(unsigned int deviceId, RprPpDeviceInfo deviceInfo, void* data, size_t size, size_t* sizeRet);
 RPRPP_API RprPpError rprppCreateContext(unsigned int deviceId, RprPpContext* outContext);
@@ -79,6 +128,8 @@ RPRPP_API RprPpError rprppContextCreateComposeOpacityShadowFilter(RprPpContext c
 RPRPP_API RprPpError rprppContextCreateDenoiserFilter(RprPpContext context, RprPpFilter* outFilter);
 RPRPP_API RprPpError rprppContextCreateToneMapFilter(RprPpContext context, RprPpFilter* outFilter);
 RPRPP_API RprPpError rprppContextDestroyFilter(RprPpContext context, RprPpFilter filter);
+RPRPP_API RprPpError rprppContextCreatePipeline(RprPpContext context, RprPpPipeline* outPipeline);
+RPRPP_API RprPpError rprppContextDestroyPipeline(RprPpContext context, RprPpPipeline pipeline);
 RPRPP_API RprPpError rprppContextCreateBuffer(RprPpContext context, size_t size, RprPpBuffer* outBuffer);
 RPRPP_API RprPpError rprppContextDestroyBuffer(RprPpContext context, RprPpBuffer buffer);
 RPRPP_API RprPpError rprppContextCreateImage(RprPpContext context, RprPpImageDescription description, RprPpImage* outImage);
@@ -88,22 +139,82 @@ RPRPP_API RprPpError rprppContextDestroyImage(RprPpContext context, RprPpImage i
 RPRPP_API RprPpError rprppContextCopyBufferToImage(RprPpContext context, RprPpBuffer buffer, RprPpImage image);
 RPRPP_API RprPpError rprppContextCopyImageToBuffer(RprPpContext context, RprPpImage image, RprPpBuffer buffer);
 RPRPP_API RprPpError rprppContextCopyImage(RprPpContext context, RprPpImage src, RprPpImage dst);
+// async copies wait only for the given semaphores (binary semaphores ignore their values) and return a timeline semaphore
+// with the value it's signaled with once the copy is finished. They run on the transfer queue when the images allow it
+RPRPP_API RprPpError rprppContextCopyBufferToImageAsync(RprPpContext context, RprPpBuffer buffer, RprPpImage image, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, RprPpVkSemaphore* finishedSemaphore, uint64_t* finishedValue);
+RPRPP_API RprPpError rprppContextCopyImageToBufferAsync(RprPpContext context, RprPpImage image, RprPpBuffer buffer, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, RprPpVkSemaphore* finishedSemaphore, uint64_t* finishedValue);
+// host data is copied into a staging ring right away, every image is uploaded by one submission
+RPRPP_API RprPpError rprppContextUploadImages(RprPpContext context, const RprPpImageUpload* uploads, unsigned int uploadCount, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, RprPpVkSemaphore* finishedSemaphore, uint64_t* finishedValue);
+RPRPP_API RprPpError rprppContextCopyImageAsync(RprPpContext context, RprPpImage src, RprPpImage dst, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, RprPpVkSemaphore* finishedSemaphore, uint64_t* finishedValue);
 RPRPP_API RprPpError rprppContextGetVkPhysicalDevice(RprPpContext context, RprPpVkPhysicalDevice* physicalDevice);
 RPRPP_API RprPpError rprppContextGetVkDevice(RprPpContext context, RprPpVkDevice* device);
 RPRPP_API RprPpError rprppContextGetVkQueue(RprPpContext context, RprPpVkQueue* queue);
+// dedicated transfer queue if the device has one, otherwise another queue of the main family or the main queue itself.
+// images and buffers created by the context use concurrent sharing, so no ownership transfers are needed
+RPRPP_API RprPpError rprppContextGetVkTransferQueue(RprPpContext context, RprPpVkQueue* queue);
+// second compute queue, the main queue itself if the device has only one.
+// the queues can be the same VkQueue, the context submits to them from the thread calling it and the caller must not submit concurrently
+RPRPP_API RprPpError rprppContextGetVkAsyncComputeQueue(RprPpContext context, RprPpVkQueue* queue);
 RPRPP_API RprPpError rprppContextWaitQueueIdle(RprPpContext context);
+// filters and pipelines created afterwards keep this many copies of per-frame resources,
+// so up to framesInFlight runs can be pending on GPU at once. 1 by default
+RPRPP_API RprPpError rprppContextSetFramesInFlight(RprPpContext context, unsigned int framesInFlight);
+RPRPP_API RprPpError rprppContextGetFramesInFlight(RprPpContext context, unsigned int* framesInFlight);
+// timeline semaphore signaled by rprppFilterRunTimeline and rprppPipelineRunTimeline,
+// every run signals a value greater than all the previous ones
+RPRPP_API RprPpError rprppContextGetTimelineSemaphore(RprPpContext context, RprPpVkSemaphore* timelineSemaphore);
+RPRPP_API RprPpError rprppContextGetCompletedTimelineValue(RprPpContext context, uint64_t* value);
+// timeout is in nanoseconds, completed is set to RPRPP_FALSE if it expired
+RPRPP_API RprPpError rprppContextWaitTimelineValue(RprPpContext context, uint64_t value, uint64_t timeout, RprPpBool* completed);
+// images destroyed by rprppContextDestroyImage are kept for reuse by rprppContextCreateImage with the same description,
+// the least recently destroyed ones are freed while the pool holds more than capacity bytes
+RPRPP_API RprPpError rprppContextSetImagePoolCapacity(RprPpContext context, size_t capacity);
+RPRPP_API RprPpError rprppContextGetImagePoolCapacity(RprPpContext context, size_t* capacity);
+RPRPP_API RprPpError rprppContextGetMemoryStatistics(RprPpContext context, RprPpMemoryStatistics* statistics);
+// filters of a context share pipelines, they are created through a pipeline cache that can be saved and loaded by the next process.
+// loading merges the saved cache into the current one, a missing file or a cache saved by another device or driver is ignored
+RPRPP_API RprPpError rprppContextSavePipelineCache(RprPpContext context, const char* path);
+RPRPP_API RprPpError rprppContextLoadPipelineCache(RprPpContext context, const char* path);
+// compiles shaders and creates pipelines of the filter types for images of the formats on background threads and returns at once,
+// so the first run of a filter doesn't wait for them. filters created before or after it use the same pipelines
+RPRPP_API RprPpError rprppContextPrewarm(RprPpContext context, const RprPpImageFormat* formats, unsigned int formatCount, RprPpFilterTypeFlags filterTypes);
+RPRPP_API RprPpError rprppContextGetPrewarmFinished(RprPpContext context, RprPpBool* finished);
+// waits for every prewarm started before and returns the first error of them
+RPRPP_API RprPpError rprppContextWaitPrewarm(RprPpContext context);
 
 // Filter
 RPRPP_API RprPpError rprppFilterRun(RprPpFilter filter, RprPpVkSemaphore waitSemaphore, RprPpVkSemaphore* finishedSemaphore);
+// waits semaphores can be timeline (waited for the given value) or binary (value is ignored),
+// signal semaphores are binary and signaled by the same submission as the timeline value
+RPRPP_API RprPpError rprppFilterRunTimeline(RprPpFilter filter, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, const RprPpVkSemaphore* signalSemaphores, unsigned int signalCount, uint64_t* signaledValue);
 RPRPP_API RprPpError rprppFilterSetInput(RprPpFilter filter, RprPpImage image);
 RPRPP_API RprPpError rprppFilterSetOutput(RprPpFilter filter, RprPpImage image);
+// Pipeline
+// consecutive compute filters are recorded into one command buffer and submitted at once,
+// added filters aren't owned by the pipeline and must outlive it
+RPRPP_API RprPpError rprppPipelineAddFilter(RprPpPipeline pipeline, RprPpFilter filter);
+RPRPP_API RprPpError rprppPipelineClear(RprPpPipeline pipeline);
+// fuses adjacent pointwise filters (compose and tonemap) into one dispatch, their intermediate images aren't written
+RPRPP_API RprPpError rprppPipelineSetFusion(RprPpPipeline pipeline, RprPpBool fusion);
+RPRPP_API RprPpError rprppPipelineGetFusion(RprPpPipeline pipeline, RprPpBool* fusion);
+RPRPP_API RprPpError rprppPipelineRun(RprPpPipeline pipeline, RprPpVkSemaphore waitSemaphore, RprPpVkSemaphore* finishedSemaphore);
+// same semaphores as rprppFilterRunTimeline
+RPRPP_API RprPpError rprppPipelineRunTimeline(RprPpPipeline pipeline, const RprPpVkSemaphore* waitSemaphores, const uint64_t* waitValues, unsigned int waitCount, const RprPpVkSemaphore* signalSemaphores, unsigned int signalCount, uint64_t* signaledValue);
 // Bloom Filter
 RPRPP_API RprPpError rprppBloomFilterGetRadius(RprPpFilter filter, float* radius);
 RPRPP_API RprPpError rprppBloomFilterGetIntensity(RprPpFilter filter, float* intensity);
 RPRPP_API RprPpError rprppBloomFilterGetThreshold(RprPpFilter filter, float* threshold);
+RPRPP_API RprPpError rprppBloomFilterGetMode(RprPpFilter filter, RprPpBloomMode* mode);
+RPRPP_API RprPpError rprppBloomFilterGetDownscale(RprPpFilter filter, unsigned int* downscale);
+RPRPP_API RprPpError rprppBloomFilterGetFftCrossoverRadius(RprPpFilter filter, unsigned int* radius);
 RPRPP_API RprPpError rprppBloomFilterSetRadius(RprPpFilter filter, float radius);
 RPRPP_API RprPpError rprppBloomFilterSetIntensity(RprPpFilter filter, float intensity);
 RPRPP_API RprPpError rprppBloomFilterSetThreshold(RprPpFilter filter, float threshold);
+RPRPP_API RprPpError rprppBloomFilterSetMode(RprPpFilter filter, RprPpBloomMode mode);
+// downscale is 1, 2, 4 or 8, it's ignored in pyramid mode
+RPRPP_API RprPpError rprppBloomFilterSetDownscale(RprPpFilter filter, unsigned int downscale);
+// kernels with a larger radius in pixels are convolved with fft, apps/bloombench measures the best value for a device
+RPRPP_API RprPpError rprppBloomFilterSetFftCrossoverRadius(RprPpFilter filter, unsigned int radius);
 // ComposeColorShadowReflection Filter
 RPRPP_API RprPpError rprppComposeColorShadowReflectionFilterSetAovOpacity(RprPpFilter filter, RprPpImage image);
 RPRPP_API RprPpError rprppComposeColorShadowReflectionFilterSetAovShadowCatcher(RprPpFilter filter, RprPpImage image);
@@ -149,6 +260,21 @@ RPRPP_API RprPpError rprppToneMapFilterGetFNumber(RprPpFilter filter, float* fNu
 RPRPP_API RprPpError rprppToneMapFilterGetFocalLength(RprPpFilter filter, float* focalLength);
 RPRPP_API RprPpError rprppToneMapFilterGetAperture(RprPpFilter filter, float* aperture);
 RPRPP_API RprPpError rprppToneMapFilterGetGamma(RprPpFilter filter, float* gamma);
+RPRPP_API RprPpError rprppToneMapFilterSetMode(RprPpFilter filter, RprPpToneMapMode mode);
+RPRPP_API RprPpError rprppToneMapFilterGetMode(RprPpFilter filter, RprPpToneMapMode* mode);
+// replaces the baked LUT with a .cube file, null path switches back to the baked one
+RPRPP_API RprPpError rprppToneMapFilterSetCubeLut(RprPpFilter filter, const char* path);
+// auto exposure replaces film iso, camera shutter and cm2 factor
+RPRPP_API RprPpError rprppToneMapFilterSetAutoExposure(RprPpFilter filter, RprPpBool autoExposure);
+RPRPP_API RprPpError rprppToneMapFilterSetAutoExposurePercentile(RprPpFilter filter, float percentile);
+RPRPP_API RprPpError rprppToneMapFilterSetAutoExposureAdaptation(RprPpFilter filter, float adaptation);
+RPRPP_API RprPpError rprppToneMapFilterSetAutoExposureKey(RprPpFilter filter, float key);
+RPRPP_API RprPpError rprppToneMapFilterGetAutoExposure(RprPpFilter filter, RprPpBool* autoExposure);
+RPRPP_API RprPpError rprppToneMapFilterGetAutoExposurePercentile(RprPpFilter filter, float* percentile);
+RPRPP_API RprPpError rprppToneMapFilterGetAutoExposureAdaptation(RprPpFilter filter, float* adaptation);
+RPRPP_API RprPpError rprppToneMapFilterGetAutoExposureKey(RprPpFilter filter, float* key);
+// doesn't wait for the filter, returns exposure of the last finished run
+RPRPP_API RprPpError rprppToneMapFilterGetExposure(RprPpFilter filter, float* exposure);
 // Denoiser Filter
 RPRPP_API RprPpError rprppDenoiserFilterSetAovAlbedo(RprPpFilter filter, RprPpImage image);
 RPRPP_API RprPpError rprppDenoiserFilterSetAovNormal(RprPpFilter filter, RprPpImage image);
@@ -165,6 +291,8 @@ RPRPP_API RprPpError rprppVkCreateFence(RprPpVkDevice device, RprPpBool signaled
 RPRPP_API RprPpError rprppVkDestroyFence(RprPpVkDevice device, RprPpVkFence fence);
 RPRPP_API RprPpError rprppVkWaitForFences(RprPpVkDevice device, unsigned int fenceCount, RprPpVkFence* pFences, RprPpBool waitAll, unsigned long long timeout);
 RPRPP_API RprPpError rprppVkResetFences(RprPpVkDevice device, unsigned int fenceCount, RprPpVkFence* pFences);
+// waits until all the timeline semaphores reach their values
+RPRPP_API RprPpError rprppVkWaitSemaphores(RprPpVkDevice device, unsigned int semaphoreCount, const RprPpVkSemaphore* pSemaphores, const uint64_t* pValues, unsigned long long timeout);
 RPRPP_API RprPpError rprppVkQueueSubmit(RprPpVkQueue queue, RprPpVkSubmitInfo submit, RprPpVkFence fence);
 
 #ifdef __cplusplus
@@ -0,0 +1,14 @@
+// storage of the intermediates shared by all bloom shaders, the macro is provided by shaderc lib
+// #define HALF_PRECISION
+
+#ifdef HALF_PRECISION
+#extension GL_EXT_shader_explicit_arithmetic_types_float16 : require
+#extension GL_EXT_shader_16bit_storage : require
+// intermediates are stored as half, accumulation is kept in float
+// values above the half range would turn into inf
+#define INTERMEDIATE_VEC4 f16vec4
+#define TO_INTERMEDIATE(v) f16vec4(min((v), vec4(65504.0f)))
+#else
+#define INTERMEDIATE_VEC4 vec4
+#define TO_INTERMEDIATE(v) (v)
+#endif
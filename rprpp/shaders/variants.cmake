@@ -0,0 +1,53 @@
+# Shader variants known at build time, see cmake/PrecompiledShaders.cmake.
+# The workgroup sizes and tile sizes are the constants of the filters, they have to be changed together.
+# Fused shaders are compiled at runtime. A filter asking for a variant of a precompiled shader
+# that isn't listed here logs a warning, prewarming the filters lists every variant they use.
+
+set(formats rgba8 rgba32f)
+# KERNEL_CACHE_SIZE is limited by the shared memory of the device, BloomFilter rounds it down to a power of two,
+# MaxKernelCacheSize fits into most devices and 2048 into the 16 KiB every device has
+set(kernel_cache_sizes 4096 2048)
+
+foreach(format ${formats})
+    foreach(half "" "HALF_PRECISION=")
+        # BloomFilter, input and output have the same description
+        set(bloom OUTPUT_FORMAT=${format} INPUT_FORMAT=${format} ${half})
+        foreach(pass DOWNSAMPLE UPSAMPLE COMPOSITE)
+            add_shader_variant(bloom_pyramid ${bloom} WORKGROUP_SIZE=16 ${pass}=)
+        endforeach()
+        foreach(pass DOWNSAMPLE COMPOSITE)
+            add_shader_variant(bloom_resample ${bloom} WORKGROUP_SIZE=16 ${pass}=)
+        endforeach()
+        # the naive convolution always reads the resampled input
+        foreach(horizontal "" "HORIZONTAL=")
+            add_shader_variant(bloom_convolve1d ${bloom} WORKGROUP_SIZE=1024 DOWNSCALED= ${horizontal})
+        endforeach()
+        foreach(downscaled "" "DOWNSCALED=")
+            foreach(horizontal "" "HORIZONTAL=")
+                add_shader_variant(bloom_fft ${bloom} WORKGROUP_SIZE=256 ${downscaled} ${horizontal})
+            endforeach()
+            foreach(kernel_cache_size ${kernel_cache_sizes})
+                add_shader_variant(bloom_convolve1d_tiled ${bloom} KERNEL_CACHE_SIZE=${kernel_cache_size} TILE_SIZE=32 TILE_LINES=8 ${downscaled})
+                add_shader_variant(bloom_convolve1d_tiled ${bloom} KERNEL_CACHE_SIZE=${kernel_cache_size} TILE_SIZE=256 TILE_LINES=1 HORIZONTAL= ${downscaled})
+            endforeach()
+        endforeach()
+    endforeach()
+
+    foreach(input_format ${formats})
+        # ComposeColorShadowReflectionFilter and ComposeOpacityShadowFilter
+        foreach(sampled 0 1)
+            add_shader_variant(compose_color_shadow_reflection OUTPUT_FORMAT=${format} AOVS_FORMAT=${input_format} WORKGROUP_SIZE=32 AOVS_ARE_SAMPLED_IMAGES=${sampled})
+            add_shader_variant(compose_opacity_shadow OUTPUT_FORMAT=${format} AOVS_FORMAT=${input_format} WORKGROUP_SIZE=32 AOVS_ARE_SAMPLED_IMAGES=${sampled})
+        endforeach()
+
+        # ToneMapFilter
+        set(tonemap OUTPUT_FORMAT=${format} INPUT_FORMAT=${input_format})
+        foreach(lut "" "LUT=")
+            add_shader_variant(tonemap ${tonemap} WORKGROUP_SIZE=32 ${lut})
+            add_shader_variant(tonemap ${tonemap} WORKGROUP_SIZE=32 ${lut} AUTO_EXPOSURE=)
+            foreach(pass HISTOGRAM ADAPT)
+                add_shader_variant(tonemap_exposure ${tonemap} WORKGROUP_SIZE=16 HISTOGRAM_SIZE=256 ${lut} AUTO_EXPOSURE= ${pass}=)
+            endforeach()
+        endforeach()
+    endforeach()
+endforeach()
@@ -3,14 +3,20 @@
 namespace vk::helper {
 
 CommandBuffer::CommandBuffer(DeviceContext* deviceContext)
+    : CommandBuffer(deviceContext, deviceContext->queueFamilyIndex)
+{
+}
+
+CommandBuffer::CommandBuffer(DeviceContext* deviceContext, uint32_t queueFamilyIndex)
     : m_deviceContext(deviceContext)
-    , m_commandBuffer(deviceContext->takeCommandBuffer())
+    , m_queueFamilyIndex(queueFamilyIndex)
+    , m_commandBuffer(deviceContext->takeCommandBuffer(queueFamilyIndex))
 {
 }
 
 CommandBuffer::~CommandBuffer()
 {
-    m_deviceContext->returnCommandBuffer(std::move(m_commandBuffer));
+    m_deviceContext->returnCommandBuffer(std::move(m_commandBuffer), m_queueFamilyIndex);
 }
 
 }
\ No newline at end of file
@@ -7,6 +7,7 @@ namespace vk::helper {
 class CommandBuffer {
 public:
     explicit CommandBuffer(DeviceContext* deviceContext);
+    CommandBuffer(DeviceContext* deviceContext, uint32_t queueFamilyIndex);
     ~CommandBuffer();
 
     [[nodiscard]] vk::raii::CommandBuffer& get() noexcept { return m_commandBuffer; }
@@ -15,6 +16,7 @@ public:
 
 private:
     DeviceContext* m_deviceContext;
+    uint32_t m_queueFamilyIndex;
     vk::raii::CommandBuffer m_commandBuffer;
 };
 
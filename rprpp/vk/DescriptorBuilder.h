@@ -10,6 +10,7 @@ public:
     void bindStorageImage(const vk::DescriptorImageInfo* imageInfo);
     void bindCombinedImageSampler(vk::DescriptorImageInfo* imageInfo);
     void bindUniformBuffer(vk::DescriptorBufferInfo* bufferInfo);
+    void bindDynamicUniformBuffer(vk::DescriptorBufferInfo* bufferInfo);
     void bindStorageBuffer(vk::DescriptorBufferInfo* bufferInfo);
 
     [[nodiscard]] const std::vector<vk::DescriptorPoolSize>& poolSizes() const { return m_poolSizesCached; }
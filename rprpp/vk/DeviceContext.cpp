@@ -2,6 +2,8 @@
 #include "rprpp/Error.h"
 #include "vk_helper.h"
 
+#include <algorithm>
+
 namespace vk::helper {
 
 DeviceContext DeviceContext::create(uint32_t deviceId)
@@ -27,11 +29,8 @@ DeviceContext DeviceContext::create(uint32_t deviceId)
 
     std::optional<uint32_t> computeQueueFamilyIndex;
     bool computeOnGraphics = false;
-    std::vector<vk::DeviceQueueCreateInfo> queueInfos;
-    float queuePriority = 1.0f;
     auto queueFamilies = physicalDevice.getQueueFamilyProperties();
     for (uint32_t i = 0; i < queueFamilies.size(); ++i) {
-        queueInfos.push_back(vk::DeviceQueueCreateInfo({}, i, 1, &queuePriority));
         bool supportsCompute = queueFamilies[i].queueCount > 0 && queueFamilies[i].queueFlags & vk::QueueFlagBits::eCompute;
         if (supportsCompute && !computeQueueFamilyIndex.has_value()) {
             computeQueueFamilyIndex = i;
@@ -47,10 +46,72 @@ DeviceContext DeviceContext::create(uint32_t deviceId)
         throw rprpp::InternalError("Could not find a queue family that supports compute and transfer operations");
     }
 
+    // a family with transfer only support is usually backed by a dma engine
+    uint32_t transferQueueFamilyIndex = computeQueueFamilyIndex.value();
+    for (uint32_t i = 0; i < queueFamilies.size(); ++i) {
+        vk::QueueFlags flags = queueFamilies[i].queueFlags;
+        bool transferOnly = (flags & vk::QueueFlagBits::eTransfer) && !(flags & (vk::QueueFlagBits::eCompute | vk::QueueFlagBits::eGraphics));
+        if (queueFamilies[i].queueCount > 0 && transferOnly) {
+            transferQueueFamilyIndex = i;
+            break;
+        }
+    }
+
+    // prefer the second queue of the main family, then any other compute family
+    uint32_t asyncComputeQueueFamilyIndex = computeQueueFamilyIndex.value();
+    if (queueFamilies[computeQueueFamilyIndex.value()].queueCount < 2) {
+        for (uint32_t i = 0; i < queueFamilies.size(); ++i) {
+            bool supportsCompute = queueFamilies[i].queueCount > 0 && queueFamilies[i].queueFlags & vk::QueueFlagBits::eCompute;
+            if (supportsCompute && i != computeQueueFamilyIndex.value()) {
+                asyncComputeQueueFamilyIndex = i;
+                break;
+            }
+        }
+    }
+
+    std::vector<uint32_t> queueCounts(queueFamilies.size(), 0);
+    auto reserveQueue = [&](uint32_t family) -> std::optional<uint32_t> {
+        if (queueCounts[family] >= queueFamilies[family].queueCount) {
+            return std::nullopt;
+        }
+        return queueCounts[family]++;
+    };
+    // the main family has at least one queue
+    uint32_t computeQueueIndex = reserveQueue(computeQueueFamilyIndex.value()).value();
+    // the other roles use the main queue itself when their family has no queue left
+    std::optional<uint32_t> asyncComputeQueueIndex = reserveQueue(asyncComputeQueueFamilyIndex);
+    if (!asyncComputeQueueIndex.has_value()) {
+        asyncComputeQueueFamilyIndex = computeQueueFamilyIndex.value();
+        asyncComputeQueueIndex = computeQueueIndex;
+    }
+    std::optional<uint32_t> transferQueueIndex = reserveQueue(transferQueueFamilyIndex);
+    if (!transferQueueIndex.has_value()) {
+        transferQueueFamilyIndex = computeQueueFamilyIndex.value();
+        transferQueueIndex = computeQueueIndex;
+    }
+
+    std::vector<uint32_t> queueFamilyIndices;
+    std::vector<vk::DeviceQueueCreateInfo> queueInfos;
+    std::vector<float> queuePriorities(*std::max_element(queueCounts.begin(), queueCounts.end()), 1.0f);
+    for (uint32_t i = 0; i < queueFamilies.size(); ++i) {
+        if (queueCounts[i] > 0) {
+            queueFamilyIndices.push_back(i);
+            queueInfos.push_back(vk::DeviceQueueCreateInfo({}, i, queueCounts[i], queuePriorities.data()));
+        }
+    }
+
     vk::raii::Device device = createDevice(physicalDevice,
         instance.enabledLayers(),
         queueInfos);
-    vk::raii::Queue queue = device.getQueue(computeQueueFamilyIndex.value(), 0);
+    vk::raii::Queue queue = device.getQueue(computeQueueFamilyIndex.value(), computeQueueIndex);
+    vk::raii::Queue transferQueue = device.getQueue(transferQueueFamilyIndex, transferQueueIndex.value());
+    vk::raii::Queue asyncComputeQueue = device.getQueue(asyncComputeQueueFamilyIndex, asyncComputeQueueIndex.value());
+    bool halfPrecision = supportHalfPrecision(physicalDevice);
+
+    std::unordered_map<VkQueue, std::unique_ptr<std::mutex>> queueMutexes;
+    for (const vk::raii::Queue* q : { &queue, &transferQueue, &asyncComputeQueue }) {
+        queueMutexes.try_emplace(static_cast<VkQueue>(**q), std::make_unique<std::mutex>());
+    }
 
     return {
         std::move(context),
@@ -59,31 +120,77 @@ DeviceContext DeviceContext::create(uint32_t deviceId)
         std::move(physicalDevice),
         std::move(device),
         std::move(queue),
-        computeQueueFamilyIndex.value()
+        computeQueueFamilyIndex.value(),
+        std::move(transferQueue),
+        transferQueueFamilyIndex,
+        std::move(asyncComputeQueue),
+        asyncComputeQueueFamilyIndex,
+        std::move(queueFamilyIndices),
+        halfPrecision,
+        {},
+        {},
+        std::move(queueMutexes)
     };
 }
 
 vk::raii::CommandBuffer DeviceContext::takeCommandBuffer()
+{
+    return takeCommandBuffer(queueFamilyIndex);
+}
+
+vk::raii::CommandBuffer DeviceContext::takeCommandBuffer(uint32_t familyIndex)
 {
     constexpr uint32_t numberOfPreallocatedBuffers = 12;
-    if (commandBuffers.empty()) {
-        vk::CommandPoolCreateInfo cmdPoolInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamilyIndex);
+    std::vector<vk::raii::CommandBuffer>& familyBuffers = commandBuffers[familyIndex];
+    if (familyBuffers.empty()) {
+        vk::CommandPoolCreateInfo cmdPoolInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, familyIndex);
         vk::raii::CommandPool pool(device, cmdPoolInfo);
 
         vk::CommandBufferAllocateInfo allocInfo(*pool, vk::CommandBufferLevel::ePrimary, numberOfPreallocatedBuffers);
         vk::raii::CommandBuffers buffers(device, allocInfo);
-        commandBuffers.insert(commandBuffers.end(), std::move_iterator(buffers.begin()), std::move_iterator(buffers.end()));
+        familyBuffers.insert(familyBuffers.end(), std::move_iterator(buffers.begin()), std::move_iterator(buffers.end()));
         commandPools.push_back(std::move(pool));
     }
 
-    vk::raii::CommandBuffer buf = std::move(commandBuffers.back());
-    commandBuffers.pop_back();
+    vk::raii::CommandBuffer buf = std::move(familyBuffers.back());
+    familyBuffers.pop_back();
     return buf;
 }
 
 void DeviceContext::returnCommandBuffer(vk::raii::CommandBuffer&& buffer)
 {
-    commandBuffers.push_back(std::move(buffer));
+    returnCommandBuffer(std::move(buffer), queueFamilyIndex);
+}
+
+void DeviceContext::returnCommandBuffer(vk::raii::CommandBuffer&& buffer, uint32_t familyIndex)
+{
+    commandBuffers[familyIndex].push_back(std::move(buffer));
+}
+
+vk::SharingMode DeviceContext::sharingMode() const noexcept
+{
+    return queueFamilyIndices.size() > 1 ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive;
+}
+
+std::mutex& DeviceContext::queueMutex(const vk::raii::Queue& queue) const
+{
+    auto it = queueMutexes.find(static_cast<VkQueue>(*queue));
+    if (it == queueMutexes.end()) {
+        throw rprpp::InternalError("queue doesn't belong to the device context");
+    }
+    return *it->second;
+}
+
+void DeviceContext::submit(const vk::raii::Queue& queue, const vk::SubmitInfo& submitInfo, vk::Fence fence) const
+{
+    std::lock_guard<std::mutex> lock(queueMutex(queue));
+    queue.submit(submitInfo, fence);
+}
+
+void DeviceContext::waitIdle(const vk::raii::Queue& queue) const
+{
+    std::lock_guard<std::mutex> lock(queueMutex(queue));
+    queue.waitIdle();
 }
 
 }
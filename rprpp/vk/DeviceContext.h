@@ -3,14 +3,28 @@
 #include "rprpp/rprpp.h"
 #include "vk_helper.h"
 
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace vk::helper {
 
 struct DeviceContext {
     static DeviceContext create(uint32_t deviceId);
+    // command buffers are pooled per queue family, the ones without family are for the main queue
     vk::raii::CommandBuffer takeCommandBuffer();
+    vk::raii::CommandBuffer takeCommandBuffer(uint32_t queueFamilyIndex);
     void returnCommandBuffer(vk::raii::CommandBuffer&& buffer);
+    void returnCommandBuffer(vk::raii::CommandBuffer&& buffer, uint32_t queueFamilyIndex);
+    // sharing mode for resources accessed from the queues of more than one family, i.e. the ones copied on the transfer queue.
+    // resources used by the main queue only are exclusive
+    [[nodiscard]] vk::SharingMode sharingMode() const noexcept;
+    // submissions and waitIdle lock the mutex of the queue, roles sharing a VkQueue share its mutex
+    [[nodiscard]] std::mutex& queueMutex(const vk::raii::Queue& queue) const;
+    void submit(const vk::raii::Queue& queue, const vk::SubmitInfo& submitInfo, vk::Fence fence = nullptr) const;
+    void waitIdle(const vk::raii::Queue& queue) const;
 
     vk::raii::Context context;
     vk::helper::Instance instance;
@@ -19,8 +33,21 @@ struct DeviceContext {
     vk::raii::Device device;
     vk::raii::Queue queue;
     uint32_t queueFamilyIndex;
+    // dedicated transfer queue if the device has one, otherwise another queue of the main family.
+    // the main queue itself once the families run out of queues
+    vk::raii::Queue transferQueue;
+    uint32_t transferQueueFamilyIndex;
+    // second compute queue, the main queue itself if the device has only one
+    vk::raii::Queue asyncComputeQueue;
+    uint32_t asyncComputeQueueFamilyIndex;
+    // unique families of the queues above
+    std::vector<uint32_t> queueFamilyIndices;
+    // shaderFloat16 and storageBuffer16BitAccess are enabled
+    bool supportHalfPrecision;
     std::vector<vk::raii::CommandPool> commandPools;
-    std::vector<vk::raii::CommandBuffer> commandBuffers;
+    std::unordered_map<uint32_t, std::vector<vk::raii::CommandBuffer>> commandBuffers;
+    // one per distinct VkQueue
+    std::unordered_map<VkQueue, std::unique_ptr<std::mutex>> queueMutexes;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace vk::helper {
+
+// shader variant compiled by glslc at build time, see rprpp/shaders/variants.cmake
+struct PrecompiledShader {
+    const char* shaderName;
+    // NAME=VALUE separated by ';', the same macros a filter passes to ShaderManager
+    const char* macroDefinitions;
+    const uint32_t* spirv;
+    size_t wordCount;
+};
+
+// empty when the library is built without glslc
+std::span<const PrecompiledShader> precompiledShaders();
+
+}
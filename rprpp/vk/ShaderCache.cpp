@@ -0,0 +1,284 @@
+#include "ShaderCache.h"
+#include "vk.h"
+
+#include <boost/log/trivial.hpp>
+#include <shaderc/shaderc.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+namespace vk::helper {
+
+namespace {
+
+    constexpr uint32_t EntryMagic = 0x43535052; // RPSC
+    // has to be changed together with the entry layout
+    constexpr uint32_t EntryVersion = 1;
+    constexpr uint32_t SpirvMagic = 0x07230203;
+    constexpr uint64_t DefaultCapacity = 64 * 1024 * 1024;
+    constexpr const char* EntryExtension = ".spvcache";
+
+    struct EntryHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint64_t wordCount;
+        uint64_t checksum;
+    };
+
+    // FNV-1a, unlike std::hash it's the same in every process
+    uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // the size is hashed too, so different splits of the same characters give different hashes
+    uint64_t hashString(const char* data, size_t size, uint64_t hash)
+    {
+        uint64_t size64 = size;
+        hash = hashBytes(&size64, sizeof(size64), hash);
+        return hashBytes(data, size, hash);
+    }
+
+    std::filesystem::path defaultDirectory()
+    {
+#ifdef _WIN32
+        char* value = nullptr;
+        size_t length = 0;
+        if (_dupenv_s(&value, &length, "RPRPP_SHADER_CACHE_DIR") == 0 && value != nullptr) {
+            std::filesystem::path directory(value);
+            free(value);
+            return directory;
+        }
+#else
+        if (const char* value = std::getenv("RPRPP_SHADER_CACHE_DIR")) {
+            return std::filesystem::path(value);
+        }
+#endif
+
+        std::error_code error;
+        std::filesystem::path temp = std::filesystem::temp_directory_path(error);
+        if (error) {
+            BOOST_LOG_TRIVIAL(warning) << "ShaderCache: no temp directory, disk cache is disabled";
+            return {};
+        }
+
+        return temp / "rprpp_shader_cache";
+    }
+
+}
+
+ShaderCache& ShaderCache::instance()
+{
+    static ShaderCache cache;
+    return cache;
+}
+
+ShaderCache::ShaderCache()
+    : m_directory(defaultDirectory())
+    , m_capacity(DefaultCapacity)
+{
+}
+
+void ShaderCache::setDirectory(const std::filesystem::path& directory)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directory = directory;
+    m_size.reset();
+}
+
+std::filesystem::path ShaderCache::directory()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_directory;
+}
+
+void ShaderCache::setCapacity(uint64_t capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    if (!m_directory.empty() && (!m_size || *m_size > m_capacity)) {
+        trim();
+    }
+}
+
+uint64_t ShaderCache::key(const std::string& shaderName,
+    const char* source,
+    size_t sourceSize,
+    const std::map<std::string, std::string>& macroDefinitions,
+    int optimizationLevel)
+{
+    uint64_t hash = hashBytes(&EntryVersion, sizeof(EntryVersion));
+    hash = hashString(shaderName.data(), shaderName.size(), hash);
+    hash = hashString(source, sourceSize, hash);
+    for (auto& it : macroDefinitions) {
+        hash = hashString(it.first.data(), it.first.size(), hash);
+        hash = hashString(it.second.data(), it.second.size(), hash);
+    }
+    hash = hashBytes(&optimizationLevel, sizeof(optimizationLevel), hash);
+
+    // shaderc comes with the vulkan sdk, its headers version changes with every sdk release.
+    // the spir-v version doesn't change with fixes of shaderc and glslang, the hash of the linked library does
+    unsigned int spirvVersion = 0;
+    unsigned int spirvRevision = 0;
+    shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+    uint64_t compilerVersion[] = { spirvVersion, spirvRevision, VK_HEADER_VERSION_COMPLETE };
+    hash = hashBytes(compilerVersion, sizeof(compilerVersion), hash);
+    constexpr const char* compilerHash = RPRPP_SHADER_COMPILER_HASH;
+    return hashString(compilerHash, std::char_traits<char>::length(compilerHash), hash);
+}
+
+std::filesystem::path ShaderCache::entryPath(uint64_t key) const
+{
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return m_directory / (std::string(name) + EntryExtension);
+}
+
+std::optional<std::vector<uint32_t>> ShaderCache::load(uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_directory.empty()) {
+        return std::nullopt;
+    }
+
+    std::filesystem::path path = entryPath(key);
+    std::error_code error;
+    uint64_t fileSize = std::filesystem::file_size(path, error);
+    if (error) {
+        return std::nullopt;
+    }
+
+    std::vector<uint32_t> spirv;
+    bool valid = false;
+    {
+        std::ifstream file(path, std::ios::binary);
+        EntryHeader header;
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            && header.magic == EntryMagic
+            && header.version == EntryVersion
+            && header.key == key
+            && header.wordCount > 0
+            && fileSize == sizeof(header) + header.wordCount * sizeof(uint32_t)) {
+            spirv.resize(header.wordCount);
+            valid = file.read(reinterpret_cast<char*>(spirv.data()), spirv.size() * sizeof(uint32_t))
+                && spirv.front() == SpirvMagic
+                && hashBytes(spirv.data(), spirv.size() * sizeof(uint32_t)) == header.checksum;
+        }
+    }
+
+    if (!valid) {
+        BOOST_LOG_TRIVIAL(warning) << "ShaderCache: removing broken entry " << path.string();
+        if (std::filesystem::remove(path, error) && m_size) {
+            *m_size -= std::min(*m_size, fileSize);
+        }
+        return std::nullopt;
+    }
+
+    // modification time is the recency used by trim()
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    return spirv;
+}
+
+void ShaderCache::store(uint64_t key, const std::vector<uint32_t>& spirv)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_directory.empty()) {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error) {
+        BOOST_LOG_TRIVIAL(warning) << "ShaderCache: can't create " << m_directory.string() << ": " << error.message();
+        return;
+    }
+
+    // other processes may store the same entry, each one writes its own file and renames it over the entry,
+    // so a reader never sees a partially written entry
+    std::filesystem::path path = entryPath(key);
+    uint64_t replacedSize = std::filesystem::file_size(path, error);
+    if (error) {
+        replacedSize = 0;
+    }
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+        EntryHeader header { EntryMagic, EntryVersion, key, spirv.size(), hashBytes(spirv.data(), spirv.size() * sizeof(uint32_t)) };
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+        file.close();
+        if (!file) {
+            BOOST_LOG_TRIVIAL(warning) << "ShaderCache: can't write " << temporaryPath.string();
+            std::filesystem::remove(temporaryPath, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        BOOST_LOG_TRIVIAL(warning) << "ShaderCache: can't rename " << temporaryPath.string() << ": " << error.message();
+        std::filesystem::remove(temporaryPath, error);
+        return;
+    }
+
+    if (m_size) {
+        *m_size += sizeof(EntryHeader) + spirv.size() * sizeof(uint32_t);
+        *m_size -= std::min(*m_size, replacedSize);
+    }
+    if (!m_size || *m_size > m_capacity) {
+        trim();
+    }
+}
+
+void ShaderCache::trim()
+{
+    struct Entry {
+        std::filesystem::path path;
+        uint64_t size;
+        std::filesystem::file_time_type lastUse;
+    };
+
+    std::error_code error;
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+    for (std::filesystem::directory_iterator it(m_directory, error), end; !error && it != end; it.increment(error)) {
+        if (it->path().extension() != EntryExtension) {
+            continue;
+        }
+
+        std::error_code entryError;
+        Entry entry { it->path(), it->file_size(entryError), it->last_write_time(entryError) };
+        if (!entryError) {
+            totalSize += entry.size;
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    m_size = totalSize;
+    if (totalSize <= m_capacity) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+    for (const Entry& entry : entries) {
+        if (totalSize <= m_capacity) {
+            break;
+        }
+        if (std::filesystem::remove(entry.path, error)) {
+            totalSize -= entry.size;
+        }
+    }
+    m_size = totalSize;
+}
+
+}
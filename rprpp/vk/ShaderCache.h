@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace vk::helper {
+
+// SPIR-V compiled by shaderc, kept on disk between processes.
+// the directory is RPRPP_SHADER_CACHE_DIR if it's set, otherwise rprpp_shader_cache in the temp directory.
+// entries are written atomically and checked on load, a broken entry is removed and the shader is compiled again.
+// disk errors are logged and never fail shader creation
+class ShaderCache {
+public:
+    static ShaderCache& instance();
+
+    // empty directory disables the cache
+    void setDirectory(const std::filesystem::path& directory);
+    [[nodiscard]] std::filesystem::path directory();
+    // least recently used entries are removed while the cache takes more than capacity bytes
+    void setCapacity(uint64_t capacity);
+
+    // depends on the source, macros, optimization level and versions of the compiler and of the cache format
+    [[nodiscard]] static uint64_t key(const std::string& shaderName,
+        const char* source,
+        size_t sourceSize,
+        const std::map<std::string, std::string>& macroDefinitions,
+        int optimizationLevel);
+
+    [[nodiscard]] std::optional<std::vector<uint32_t>> load(uint64_t key);
+    void store(uint64_t key, const std::vector<uint32_t>& spirv);
+
+private:
+    ShaderCache();
+    [[nodiscard]] std::filesystem::path entryPath(uint64_t key) const;
+    // scans the directory, so it runs only once the entries are known to take more than capacity
+    void trim();
+
+    std::mutex m_mutex;
+    std::filesystem::path m_directory;
+    uint64_t m_capacity;
+    // bytes taken by the entries, counted by the first store() and kept up to date by this process,
+    // entries stored by other processes are counted again by trim()
+    std::optional<uint64_t> m_size;
+};
+
+}
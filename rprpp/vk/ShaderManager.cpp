@@ -1,32 +1,115 @@
 #include "ShaderManager.h"
+#include "PrecompiledShaders.h"
+#include "ShaderCache.h"
 #include "rprpp/Error.h"
+#include <algorithm>
+#include <future>
+#include <map>
 #include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_set>
 #include <rprpp_config.h>
 #include <shaderc/shaderc.hpp>
 #include <boost/log/trivial.hpp>
 
 namespace vk::helper {
 
-vk::raii::ShaderModule ShaderManager::get(const vk::raii::Device& device,
-    const std::string& shaderName,
-    const char* source_text,
-    size_t source_text_size,
-    const std::unordered_map<std::string, std::string>& macroDefinitions)
-{
-    static std::mutex mutex;
-    static std::unordered_map<std::string, std::vector<uint32_t>> compiledShaders;
-
-    std::string key = shaderName;
-    shaderc::CompileOptions options;
-    options.SetOptimizationLevel(shaderc_optimization_level_performance);
-    for (auto& it : macroDefinitions) {
-        key += it.first + "_" + it.second + "_";
-        options.AddMacroDefinition(it.first, it.second);
+namespace {
+
+    std::string sortedVariantKey(const std::string& shaderName, const std::map<std::string, std::string>& macroDefinitions)
+    {
+        std::string key = shaderName;
+        for (auto& it : macroDefinitions) {
+            key += it.first + "_" + it.second + "_";
+        }
+        return key;
+    }
+
+    // keyed the same way as the shaders compiled at runtime
+    const std::unordered_map<std::string, std::span<const uint32_t>>& precompiledVariants()
+    {
+        static const std::unordered_map<std::string, std::span<const uint32_t>> variants = [] {
+            std::unordered_map<std::string, std::span<const uint32_t>> result;
+            for (const PrecompiledShader& shader : precompiledShaders()) {
+                std::map<std::string, std::string> macroDefinitions;
+                std::string_view macros = shader.macroDefinitions;
+                while (!macros.empty()) {
+                    size_t end = std::min(macros.find(';'), macros.size());
+                    std::string_view macro = macros.substr(0, end);
+                    size_t separator = macro.find('=');
+                    macroDefinitions.emplace(macro.substr(0, separator), macro.substr(separator + 1));
+                    macros.remove_prefix(std::min(end + 1, macros.size()));
+                }
+                result.emplace(sortedVariantKey(shader.shaderName, macroDefinitions), std::span(shader.spirv, shader.wordCount));
+            }
+            return result;
+        }();
+        return variants;
+    }
+
+    // a shader with precompiled variants is expected to be asked only for those, another variant means
+    // shaders/variants.cmake is out of sync with the macros of the filter
+    bool hasPrecompiledVariants(const std::string& shaderName)
+    {
+        static const std::unordered_set<std::string> shaderNames = [] {
+            std::unordered_set<std::string> result;
+            for (const PrecompiledShader& shader : precompiledShaders()) {
+                result.emplace(shader.shaderName);
+            }
+            return result;
+        }();
+        return shaderNames.contains(shaderName);
+    }
+
+    // shaders include the shared snippets as #include <name>, glslc finds them in the shaders directory
+    std::string resolveIncludes(std::string_view source)
+    {
+        static const std::unordered_map<std::string_view, std::string_view> includes = {
+            { "bloom_precision.glsl", RPRPP_bloom_precision_SHADER },
+        };
+
+        constexpr std::string_view directive = "#include <";
+        std::string result;
+        size_t lineStart = 0;
+        while (lineStart < source.size()) {
+            size_t lineEnd = std::min(source.find('\n', lineStart), source.size());
+            std::string_view line = source.substr(lineStart, lineEnd - lineStart);
+            if (line.starts_with(directive) && line.ends_with('>')) {
+                std::string_view name = line.substr(directive.size(), line.size() - directive.size() - 1);
+                auto include = includes.find(name);
+                if (include == includes.end()) {
+                    throw rprpp::InternalError("unknown shader include " + std::string(name));
+                }
+                result += include->second;
+            } else {
+                result += line;
+            }
+            result += '\n';
+            lineStart = lineEnd + 1;
+        }
+        return result;
     }
 
-    std::lock_guard<std::mutex> lock(mutex);
-    auto it = compiledShaders.find(key);
-    if (it == compiledShaders.end()) {
+    // shaders compiled by previous processes are on disk
+    std::vector<uint32_t> compile(const std::string& shaderName,
+        const char* source_text,
+        size_t source_text_size,
+        const std::map<std::string, std::string>& macroDefinitions,
+        shaderc_optimization_level optimizationLevel)
+    {
+        uint64_t cacheKey = ShaderCache::key(shaderName, source_text, source_text_size, macroDefinitions, optimizationLevel);
+        if (std::optional<std::vector<uint32_t>> cachedSpirv = ShaderCache::instance().load(cacheKey)) {
+            return std::move(cachedSpirv.value());
+        }
+
+        shaderc::CompileOptions options;
+        options.SetOptimizationLevel(optimizationLevel);
+        for (auto& it : macroDefinitions) {
+            options.AddMacroDefinition(it.first, it.second);
+        }
+
         shaderc::Compiler compiler;
         shaderc::SpvCompilationResult spv = compiler.CompileGlslToSpv(
             source_text,
@@ -40,72 +123,173 @@ vk::raii::ShaderModule ShaderManager::get(const vk::raii::Device& device,
             throw rprpp::ShaderCompilationError("Shader compilation failed with: " + spv.GetErrorMessage());
         }
 
-        compiledShaders[key] = std::move(std::vector(spv.cbegin(), spv.cend()));
-        it = compiledShaders.find(key);
+        std::vector<uint32_t> spirv(spv.cbegin(), spv.cend());
+        ShaderCache::instance().store(cacheKey, spirv);
+        return spirv;
+    }
+
+}
+
+vk::raii::ShaderModule ShaderManager::get(const vk::raii::Device& device,
+    const std::string& shaderName,
+    const char* source_text,
+    size_t source_text_size,
+    const std::unordered_map<std::string, std::string>& macroDefinitions)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_future<std::vector<uint32_t>>> compiledShaders;
+    constexpr shaderc_optimization_level optimizationLevel = shaderc_optimization_level_performance;
+
+    // sorted, so the same macros always give the same key
+    std::map<std::string, std::string> sortedMacroDefinitions(macroDefinitions.begin(), macroDefinitions.end());
+    std::string key = sortedVariantKey(shaderName, sortedMacroDefinitions);
+
+    // variants known at build time are embedded into the library, the compiler is only a fallback for the others
+    auto precompiled = precompiledVariants().find(key);
+    if (precompiled != precompiledVariants().end()) {
+        vk::ShaderModuleCreateInfo shaderModuleInfo({}, precompiled->second.size_bytes(), precompiled->second.data());
+        return vk::raii::ShaderModule(device, shaderModuleInfo);
+    }
+
+    // a variant is compiled once, concurrent requests for it wait for the first one while other variants compile in parallel
+    std::shared_future<std::vector<uint32_t>> spirv;
+    std::optional<std::promise<std::vector<uint32_t>>> compilation;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = compiledShaders.find(key);
+        if (it == compiledShaders.end()) {
+            compilation.emplace();
+            it = compiledShaders.emplace(key, compilation->get_future().share()).first;
+        }
+        spirv = it->second;
+    }
+
+    if (compilation.has_value()) {
+        if (hasPrecompiledVariants(shaderName)) {
+            BOOST_LOG_TRIVIAL(warning) << "ShaderManager: " << key << " isn't precompiled, shaders/variants.cmake is out of sync with the filter";
+        }
+        try {
+            compilation->set_value(compile(shaderName, source_text, source_text_size, sortedMacroDefinitions, optimizationLevel));
+        } catch (...) {
+            // the next request compiles the variant again
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                compiledShaders.erase(key);
+            }
+            compilation->set_exception(std::current_exception());
+        }
     }
 
-    vk::ShaderModuleCreateInfo shaderModuleInfo({}, it->second);
+    vk::ShaderModuleCreateInfo shaderModuleInfo({}, spirv.get());
     return vk::raii::ShaderModule(device, shaderModuleInfo);
 }
 
-vk::raii::ShaderModule ShaderManager::getBloomConvolve1dShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions)
+std::string ShaderManager::variantKey(const std::string& shaderName, const std::unordered_map<std::string, std::string>& macroDefinitions)
 {
-    return get(device,
-        "bloom_convolve1d",
-        RPRPP_bloom_convolve1d_SHADER,
-        // size - null terminator
-        sizeof(RPRPP_bloom_convolve1d_SHADER) - 1,
-        macroDefinitions);
+    return sortedVariantKey(shaderName, std::map<std::string, std::string>(macroDefinitions.begin(), macroDefinitions.end()));
 }
 
-vk::raii::ShaderModule ShaderManager::getBloomConvolve2dShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions)
+std::string ShaderManager::fusedVariantKey(const std::vector<FusedShaderStage>& stages, uint32_t workgroupSize)
 {
-    return get(device,
-        "bloom_convolve2d",
-        RPRPP_bloom_convolve2d_SHADER,
-        // size - null terminator
-        sizeof(RPRPP_bloom_convolve2d_SHADER) - 1,
-        macroDefinitions);
+    std::string key = "fused_" + std::to_string(workgroupSize);
+    for (const FusedShaderStage& stage : stages) {
+        key += "|" + variantKey(stage.shaderName, stage.macroDefinitions) + "@" + std::to_string(stage.constantIdBase);
+    }
+    return key;
 }
 
-vk::raii::ShaderModule ShaderManager::getBloomThresholdShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions)
+std::pair<const char*, size_t> ShaderManager::shaderSource(const std::string& shaderName)
 {
-    return get(device,
-        "blooom_threshold",
-        RPRPP_bloom_threshold_SHADER,
-        // size - null terminator
-        sizeof(RPRPP_bloom_threshold_SHADER) - 1,
-        macroDefinitions);
+    // includes are resolved once, so the source hashed by the shader cache is the full one
+    static const std::unordered_map<std::string, std::string> sources = {
+        { "bloom_convolve1d", resolveIncludes(RPRPP_bloom_convolve1d_SHADER) },
+        { "bloom_convolve1d_tiled", resolveIncludes(RPRPP_bloom_convolve1d_tiled_SHADER) },
+        { "bloom_convolve2d", resolveIncludes(RPRPP_bloom_convolve2d_SHADER) },
+        { "bloom_fft", resolveIncludes(RPRPP_bloom_fft_SHADER) },
+        { "bloom_pyramid", resolveIncludes(RPRPP_bloom_pyramid_SHADER) },
+        { "bloom_resample", resolveIncludes(RPRPP_bloom_resample_SHADER) },
+        { "compose_color_shadow_reflection", resolveIncludes(RPRPP_compose_color_shadow_reflection_SHADER) },
+        { "compose_opacity_shadow", resolveIncludes(RPRPP_compose_opacity_shadow_SHADER) },
+        { "tonemap", resolveIncludes(RPRPP_tonemap_SHADER) },
+        { "tonemap_exposure", resolveIncludes(RPRPP_tonemap_exposure_SHADER) },
+    };
+
+    auto it = sources.find(shaderName);
+    if (it == sources.end()) {
+        throw rprpp::InternalError("unknown shader " + shaderName);
+    }
+    return { it->second.c_str(), it->second.size() };
 }
 
-vk::raii::ShaderModule ShaderManager::getComposeColorShadowReflectionShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions)
+vk::raii::ShaderModule ShaderManager::getShader(const vk::raii::Device& device, const std::string& shaderName, const std::unordered_map<std::string, std::string>& macroDefinitions)
 {
-    return get(device,
-        "compose_color_shadow_reflection",
-        RPRPP_compose_color_shadow_reflection_SHADER,
-        // size - null terminator
-        sizeof(RPRPP_compose_color_shadow_reflection_SHADER) - 1,
-        macroDefinitions);
+    auto [source, size] = shaderSource(shaderName);
+    return get(device, shaderName, source, size, macroDefinitions);
 }
 
-vk::raii::ShaderModule ShaderManager::getComposeOpacityShadowShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions)
+std::string ShaderManager::fusableShaderSource(const std::string& shaderName)
 {
-    return get(device,
-        "compose_opacity_shadow",
-        RPRPP_compose_opacity_shadow_SHADER,
-        // size - null terminator
-        sizeof(RPRPP_compose_opacity_shadow_SHADER) - 1,
-        macroDefinitions);
+    std::string source;
+    if (shaderName == "compose_color_shadow_reflection") {
+        source = RPRPP_compose_color_shadow_reflection_SHADER;
+    } else if (shaderName == "tonemap") {
+        source = RPRPP_tonemap_SHADER;
+    } else {
+        throw rprpp::InternalError("shader " + shaderName + " can't be fused");
+    }
+
+    // every stage starts with #version, the fused shader has its own
+    if (source.starts_with("#version")) {
+        source.erase(0, source.find('\n') + 1);
+    }
+
+    return source;
 }
 
-vk::raii::ShaderModule ShaderManager::getToneMapShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions)
+vk::raii::ShaderModule ShaderManager::getFusedShader(const vk::raii::Device& device, const std::vector<FusedShaderStage>& stages, uint32_t workgroupSize)
 {
-    return get(device,
-        "tonemap",
-        RPRPP_tonemap_SHADER,
-        // size - null terminator
-        sizeof(RPRPP_tonemap_SHADER) - 1,
-        macroDefinitions);
+    if (stages.empty()) {
+        throw rprpp::InternalError("fused shader needs at least one stage");
+    }
+
+    // macros of each stage are defined right in the source, so they have to be a part of the name used as cache key
+    std::string shaderName = "fused";
+    std::string source = "#version 450\n#define FUSED\n";
+    for (size_t i = 0; i < stages.size(); i++) {
+        const FusedShaderStage& stage = stages[i];
+        shaderName += "_" + stage.shaderName + "_" + std::to_string(stage.constantIdBase);
+
+        source += "#define STAGE(name) s" + std::to_string(i) + "_##name\n";
+        source += "#define DESCRIPTOR_SET " + std::to_string(i) + "\n";
+        source += "#define CONSTANT_ID_BASE " + std::to_string(stage.constantIdBase) + "\n";
+        for (auto& it : stage.macroDefinitions) {
+            shaderName += "_" + it.first + "_" + it.second;
+            source += "#define " + it.first + " " + it.second + "\n";
+        }
+
+        source += fusableShaderSource(stage.shaderName) + "\n";
+
+        source += "#undef STAGE\n#undef DESCRIPTOR_SET\n#undef CONSTANT_ID_BASE\n";
+        for (auto& it : stage.macroDefinitions) {
+            source += "#undef " + it.first + "\n";
+        }
+    }
+
+    const std::string last = "s" + std::to_string(stages.size() - 1) + "_";
+    source += "layout (local_size_x = " + std::to_string(workgroupSize) + ", local_size_y = " + std::to_string(workgroupSize) + ", local_size_z = 1) in;\n";
+    source += "void main() {\n";
+    source += "    ivec2 xy = ivec2(gl_GlobalInvocationID.xy);\n";
+    source += "    ivec2 resolution = imageSize(" + last + "outputImage);\n";
+    source += "    if (xy.x >= resolution.x || xy.y >= resolution.y)\n";
+    source += "        return;\n";
+    source += "    vec4 color = s0_load(xy);\n";
+    for (size_t i = 0; i < stages.size(); i++) {
+        source += "    color = s" + std::to_string(i) + "_apply(color, xy);\n";
+    }
+    source += "    imageStore(" + last + "outputImage, xy, color);\n";
+    source += "}\n";
+
+    return get(device, shaderName, source.c_str(), source.size(), {});
 }
 
-}
\ No newline at end of file
+}
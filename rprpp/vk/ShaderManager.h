@@ -1,10 +1,23 @@
 #pragma once
 
 #include "vk.h"
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace vk::helper {
 
+// pointwise body of a filter shader, stitched with others into a single fused shader
+struct FusedShaderStage {
+    std::string shaderName;
+    std::unordered_map<std::string, std::string> macroDefinitions;
+    // added to the specialization constant ids of the stage, so the ids of fused stages don't overlap
+    uint32_t constantIdBase = 0;
+
+    bool operator==(const FusedShaderStage&) const = default;
+};
+
 class ShaderManager {
 private:
     vk::raii::ShaderModule get(const vk::raii::Device& device,
@@ -12,14 +25,18 @@ private:
         const char* source_text,
         size_t source_text_size,
         const std::unordered_map<std::string, std::string>& macroDefinitions);
+    static std::string fusableShaderSource(const std::string& shaderName);
+    static std::pair<const char*, size_t> shaderSource(const std::string& shaderName);
 
 public:
-    vk::raii::ShaderModule getBloomConvolve1dShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions);
-    vk::raii::ShaderModule getBloomConvolve2dShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions);
-    vk::raii::ShaderModule getBloomThresholdShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions);
-    vk::raii::ShaderModule getComposeColorShadowReflectionShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions);
-    vk::raii::ShaderModule getComposeOpacityShadowShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions);
-    vk::raii::ShaderModule getToneMapShader(const vk::raii::Device& device, const std::unordered_map<std::string, std::string>& macroDefinitions);
+    // identifies the compiled variant of a shader, equal macros give equal keys whatever their order is
+    static std::string variantKey(const std::string& shaderName, const std::unordered_map<std::string, std::string>& macroDefinitions);
+    static std::string fusedVariantKey(const std::vector<FusedShaderStage>& stages, uint32_t workgroupSize);
+
+    vk::raii::ShaderModule getShader(const vk::raii::Device& device, const std::string& shaderName, const std::unordered_map<std::string, std::string>& macroDefinitions);
+    // stage i uses descriptor set i, the result of each stage is passed to the next one in registers
+    // and only the output of the last stage is stored
+    vk::raii::ShaderModule getFusedShader(const vk::raii::Device& device, const std::vector<FusedShaderStage>& stages, uint32_t workgroupSize);
 };
 
 }
\ No newline at end of file
@@ -74,6 +74,17 @@ uint32_t getDeviceCount()
     return physicalDevices.size();
 }
 
+bool supportHalfPrecision(const vk::raii::PhysicalDevice& physicalDevice)
+{
+    auto supportedFeatures = physicalDevice.getFeatures2<
+        vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceVulkan11Features,
+        vk::PhysicalDeviceVulkan12Features>();
+
+    return supportedFeatures.get<vk::PhysicalDeviceVulkan12Features>().shaderFloat16
+        && supportedFeatures.get<vk::PhysicalDeviceVulkan11Features>().storageBuffer16BitAccess;
+}
+
 vk::raii::Device createDevice(const vk::raii::PhysicalDevice& physicalDevice,
     const std::vector<const char*>& enabledLayers,
     const std::vector<vk::DeviceQueueCreateInfo>& queueInfos)
@@ -135,6 +146,7 @@ vk::raii::Device createDevice(const vk::raii::PhysicalDevice& physicalDevice,
     features12.shaderStorageBufferArrayNonUniformIndexing = vk::True;
     features12.samplerFilterMinmax = supportedFeatures.get<vk::PhysicalDeviceVulkan12Features>().samplerFilterMinmax;
     features12.bufferDeviceAddress = vk::True;
+    features12.timelineSemaphore = vk::True;
 
     vk::PhysicalDeviceVulkan11Features features11;
     features11.storageBuffer16BitAccess = supportedFeatures.get<vk::PhysicalDeviceVulkan11Features>().storageBuffer16BitAccess;
@@ -31,6 +31,7 @@ private:
 vk::DebugUtilsMessengerCreateInfoEXT makeDebugUtilsMessengerCreateInfoEXT();
 bool validateRequiredExtensions(const std::vector<const char*>& extensions, const std::vector<const char*>& requiredExtensions);
 std::vector<const char*> getRayTracingExtensions();
+bool supportHalfPrecision(const vk::raii::PhysicalDevice& physicalDevice);
 uint32_t getDeviceCount();
 uint32_t findMemoryType(const vk::raii::PhysicalDevice& physicalDevice, uint32_t typeFilter, vk::MemoryPropertyFlags properties);
 Instance createInstance(const vk::raii::Context& context, bool enableValidationLayers);